@@ -10,6 +10,8 @@
 #include "BTree.hpp"
 #include "BPlusTree.hpp"
 #include "CRequirements.hpp"
+#include "IDictionary.hpp"
+#include "TreeStats.hpp"
 
 namespace fs = std::filesystem;
 
@@ -28,11 +30,19 @@ public:
     _rng( std::random_device{}() )
     , _dist( std::uniform_int_distribution<T>(0, 1'000'000'000) )
     , _path( "../inc/Benchmark/results" ) {
-        if (folder != "bplustree" && folder != "btree") {
+        if (folder != "bplustree" && folder != "btree" && folder != "hashmap") {
             throw Exception( Exception::ErrorCode::INVALID_INPUT );
         }
         _path /= folder;
         fs::create_directories(_path);
+      #ifdef TREE_STATS
+        _stats.open(_path / "stats.csv", std::ios::trunc);
+        if (!_stats) { throw Exception( "Error. Creating a file failed."); }
+        _stats << "operation,count,height,nodes,level_nodes,splits,root_splits,merges,left_rotations,right_rotations"
+               << ",comparisons_per_op,visits_per_op";
+        for (size_t i = 0; i < TreeShape::fillBuckets; i++) { _stats << ",fill_" << i * 10; }
+        _stats << "\n";
+      #endif
     }
 
     ~BTreeBenchmark() = default;
@@ -40,13 +50,14 @@ public:
     void launchInsertions( const size_t count ) {
         std::ofstream csv(_path / "insert.csv", std::ios::trunc);
         if (!csv) { throw Exception( "Error. Creating a file failed."); }
-        csv << "count,time_us\n";
+        csv << "count,time_us,nodes_bytes,payload_bytes,slack_bytes,control_bytes,total_bytes\n";
         
         auto data = uniqueSet( count );
 
         for (size_t i = 1; i <= 10; i++) {
             tree t;
             auto n = (count * i) / 10;
+            TREE_STAT( resetStats() );
 
             auto start = clock::now();
 
@@ -55,9 +66,12 @@ public:
             }
 
             auto end = clock::now();
+            TREE_STAT( writeStats( "insert", n, t ) );
 
             auto time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-            csv << n << "," << time << "\n";
+            auto usage = t.memoryUsage();
+            csv << n << "," << time << "," << usage.nodes << "," << usage.payload << "," 
+                << usage.slack << "," << usage.controlBlocks << "," << usage.total() << "\n";
         }
         csv.close();
     }
@@ -82,6 +96,7 @@ public:
             }
             
             volatile size_t acc = 0;
+            TREE_STAT( resetStats() );
             
             auto start = clock::now();
             for (size_t j = 0; j < queryCount; j++) {
@@ -90,6 +105,7 @@ public:
                 }
             }
             auto end = clock::now();
+            TREE_STAT( writeStats( "lookup", n, t ) );
 
             auto time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
             csv << n << "," << time << "\n";
@@ -97,10 +113,48 @@ public:
         csv.close();
     }
 
+    void launchBatchLookup( const size_t count ) {
+        std::ofstream csv(_path / "batch_lookup.csv", std::ios::trunc);
+        if (!csv) { throw Exception( "Error. Creating a file failed."); }
+        csv << "count,single_us,batch_us\n";
+
+        auto data = uniqueSet( count );
+
+        for (size_t i = 1; i <= 10; i++) {
+            IDictionary<T,T,tree> dict;
+            auto n = (count * i) / 10;
+            for (size_t j = 0; j < n; j++) { dict.add( data[j], data[j] ); }
+
+            size_t queryCount = n < 100'000 ? n : 100'000;
+            ArraySequence<T> queries( queryCount );
+            std::uniform_int_distribution<T> queryDist(0, n-1);
+            for (size_t j = 0; j < queryCount; j++) {
+                queries.append( data[queryDist(_rng)] );
+            }
+
+            volatile size_t acc = 0;
+            auto start = clock::now();
+            for (size_t j = 0; j < queryCount; j++) {
+                if ( dict.contains( queries[j] ) ) {
+                    acc += 1;
+                }
+            }
+            auto mid = clock::now();
+            ArraySequence<bool> found;
+            dict.containsMany( queries, found );
+            auto end = clock::now();
+
+            auto single = std::chrono::duration_cast<std::chrono::microseconds>(mid - start).count();
+            auto batch = std::chrono::duration_cast<std::chrono::microseconds>(end - mid).count();
+            csv << n << "," << single << "," << batch << "\n";
+        }
+        csv.close();
+    }
+
     void launchRemovals( const size_t count ) {
         std::ofstream csv(_path / "remove.csv", std::ios::trunc);
         if (!csv) { throw Exception( "Error. Creating a file failed."); }
-        csv << "count,time_us\n";
+        csv << "count,time_us,total_bytes\n";
     
         auto data = uniqueSet( count );
 
@@ -116,14 +170,16 @@ public:
                 queries.append(queryDist(_rng));
             }
             
+            TREE_STAT( resetStats() );
             auto start = clock::now();
             for (size_t j = 0; j < queryCount; j++) {
                 t.remove( data[queries[j]] );
             }            
             auto end = clock::now();
+            TREE_STAT( writeStats( "remove", n, t ) );
 
             auto time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-            csv << n << "," << time << "\n";
+            csv << n << "," << time << "," << t.memoryUsage().total() << "\n";
         }
         csv.close();
     }
@@ -135,6 +191,32 @@ public:
         }
     }
 private:
+  #ifdef TREE_STATS
+    static constexpr bool _hasStats = requires( const tree& t ) { tree::counters(); t.shape(); };
+
+    void resetStats() {
+        if constexpr(_hasStats) { tree::counters().reset(); }
+    }
+
+    // unordered containers have no tree statistics, their rows are skipped
+    void writeStats( const std::string& operation, const size_t n, const tree& t ) {
+        if constexpr(_hasStats) {
+            const auto& c = tree::counters();
+            auto shape = t.shape();
+
+            _stats << operation << "," << n << "," << shape.height << "," << shape.nodes << ",";
+            for (size_t level = 0; level < shape.levelNodes.getSize(); level++) {
+                _stats << (level ? ";" : "") << shape.levelNodes[level];
+            }
+            _stats << "," << c.splits << "," << c.rootSplits << "," << c.merges 
+                   << "," << c.leftRotations << "," << c.rightRotations
+                   << "," << c.comparisonsPerOperation() << "," << c.visitsPerOperation();
+            for (auto bucket : shape.fillHistogram) { _stats << "," << bucket; }
+            _stats << "\n";
+        }
+    }
+  #endif
+
     DynamicArray<T> dataset( const size_t count ) {
         auto arr = DynamicArray<T>(count);
 
@@ -154,6 +236,9 @@ private:
     std::mt19937 _rng;
     std::uniform_int_distribution<T> _dist;
     std::filesystem::path _path;
+  #ifdef TREE_STATS
+    std::ofstream _stats;
+  #endif
 };
 
 #endif // BENCHMARK_H
\ No newline at end of file
@@ -0,0 +1,177 @@
+#ifndef PTR_BENCHMARK_H
+#define PTR_BENCHMARK_H
+
+#include <filesystem>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include "SharedPtr.hpp"
+#include "UniquePtr.hpp"
+#include "WeakPtr.hpp"
+
+namespace fs = std::filesystem;
+
+class SharedPtrBenchmark
+{
+private:
+    using clock = std::chrono::steady_clock;
+    struct Payload {
+        std::uint64_t _key;
+        std::uint64_t _value;
+    public:
+        Payload() : _key(0), _value(0) {}
+        Payload( const std::uint64_t key ) : _key(key), _value(key * 2) {}
+    };
+public:
+    SharedPtrBenchmark() : _path( "../inc/Benchmark/results/sharedptr" ) {
+        fs::create_directories(_path);
+    }
+
+    ~SharedPtrBenchmark() = default;
+public:
+    // allocation + destruction of count objects:
+    // separate - SharedPtr adopting a UniquePtr (object and RefCount are two allocations)
+    // inplace  - makeShared (one allocation)
+    // std      - std::make_shared
+    void launchCreation( const size_t count ) {
+        std::ofstream csv(_path / "make.csv", std::ios::trunc);
+        if (!csv) { throw Exception( "Error. Creating a file failed."); }
+        csv << "count,separate_us,inplace_us,std_us\n";
+
+        for (size_t i = 1; i <= 10; i++) {
+            auto n = (count * i) / 10;
+
+            auto separate = measure([n]() {
+                std::vector<SharedPtr<Payload>> v;
+                v.reserve(n);
+                for (size_t j = 0; j < n; j++) { v.emplace_back( makeUnique<Payload>(j) ); }
+            });
+            auto inplace = measure([n]() {
+                std::vector<SharedPtr<Payload>> v;
+                v.reserve(n);
+                for (size_t j = 0; j < n; j++) { v.push_back( makeShared<Payload>(j) ); }
+            });
+            auto standard = measure([n]() {
+                std::vector<std::shared_ptr<Payload>> v;
+                v.reserve(n);
+                for (size_t j = 0; j < n; j++) { v.push_back( std::make_shared<Payload>(j) ); }
+            });
+            csv << n << "," << separate << "," << inplace << "," << standard << "\n";
+        }
+        csv.close();
+    }
+
+    // copy + dereference of already created pointers, touches both the count and the object
+    void launchCopies( const size_t count ) {
+        std::ofstream csv(_path / "copy.csv", std::ios::trunc);
+        if (!csv) { throw Exception( "Error. Creating a file failed."); }
+        csv << "count,separate_us,inplace_us,std_us\n";
+
+        for (size_t i = 1; i <= 10; i++) {
+            auto n = (count * i) / 10;
+
+            std::vector<SharedPtr<Payload>> separatePtrs;
+            std::vector<SharedPtr<Payload>> inplacePtrs;
+            std::vector<std::shared_ptr<Payload>> standardPtrs;
+            separatePtrs.reserve(n);
+            inplacePtrs.reserve(n);
+            standardPtrs.reserve(n);
+            for (size_t j = 0; j < n; j++) {
+                separatePtrs.emplace_back( makeUnique<Payload>(j) );
+                inplacePtrs.push_back( makeShared<Payload>(j) );
+                standardPtrs.push_back( std::make_shared<Payload>(j) );
+            }
+
+            auto separate = measure([&separatePtrs]() { copyAndRead( separatePtrs ); });
+            auto inplace  = measure([&inplacePtrs]()  { copyAndRead( inplacePtrs ); });
+            auto standard = measure([&standardPtrs]() { copyAndRead( standardPtrs ); });
+            csv << n << "," << separate << "," << inplace << "," << standard << "\n";
+        }
+        csv.close();
+    }
+
+    // copy + lock stress, every thread performs iterations copies of a SharedPtr and locks of a WeakPtr:
+    // single       - SingleThreaded policy, each thread owns its own pointer (the only safe way to use it)
+    // atomic       - MultiThreaded policy, each thread owns its own pointer (uncontended atomics)
+    // atomicShared - MultiThreaded policy, all threads hammer one pointer (contended cache line)
+    // stdShared    - std::shared_ptr / std::weak_ptr, all threads hammer one pointer
+    void launchConcurrent( const size_t maxThreads, const size_t iterations ) {
+        std::ofstream csv(_path / "concurrent.csv", std::ios::trunc);
+        if (!csv) { throw Exception( "Error. Creating a file failed."); }
+        csv << "threads,single_us,atomic_us,atomic_shared_us,std_shared_us\n";
+
+        for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+            auto single = measure([threads, iterations]() {
+                runThreads( threads, [iterations]() {
+                    auto ptr = makeShared<Payload,SingleThreaded>(1);
+                    stress( ptr, WeakPtr<Payload,SingleThreaded>(ptr), iterations );
+                });
+            });
+            auto atomic = measure([threads, iterations]() {
+                runThreads( threads, [iterations]() {
+                    auto ptr = makeShared<Payload,MultiThreaded>(1);
+                    stress( ptr, WeakPtr<Payload,MultiThreaded>(ptr), iterations );
+                });
+            });
+
+            auto sharedPtr = makeShared<Payload,MultiThreaded>(1);
+            WeakPtr<Payload,MultiThreaded> sharedWeak = sharedPtr;
+            auto atomicShared = measure([&sharedPtr, &sharedWeak, threads, iterations]() {
+                runThreads( threads, [&sharedPtr, &sharedWeak, iterations]() {
+                    stress( sharedPtr, sharedWeak, iterations );
+                });
+            });
+
+            auto stdPtr = std::make_shared<Payload>(1);
+            std::weak_ptr<Payload> stdWeak = stdPtr;
+            auto stdShared = measure([&stdPtr, &stdWeak, threads, iterations]() {
+                runThreads( threads, [&stdPtr, &stdWeak, iterations]() {
+                    stress( stdPtr, stdWeak, iterations );
+                });
+            });
+            csv << threads << "," << single << "," << atomic << "," << atomicShared << "," << stdShared << "\n";
+        }
+        csv.close();
+    }
+private:
+    template <typename F>
+    static void runThreads( const size_t count, F func ) {
+        std::vector<std::thread> pool;
+        pool.reserve(count);
+        for (size_t i = 0; i < count; i++) { pool.emplace_back( func ); }
+        for (auto& thread : pool) { thread.join(); }
+    }
+
+    template <typename TPtr, typename TWeak>
+    static void stress( const TPtr& ptr, const TWeak& weak, const size_t iterations ) {
+        volatile std::uint64_t acc = 0;
+        for (size_t j = 0; j < iterations; j++) {
+            TPtr copy = ptr;
+            auto locked = weak.lock();
+            acc = acc + copy->_value + locked->_value;
+        }
+    }
+
+    template <typename F>
+    static long measure( F&& func ) {
+        auto start = clock::now();
+        func();
+        auto end = clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+
+    template <typename TPtr>
+    static void copyAndRead( std::vector<TPtr>& ptrs ) {
+        volatile std::uint64_t acc = 0;
+        for (size_t j = 0; j < ptrs.size(); j++) {
+            TPtr copy = ptrs[j];
+            acc = acc + copy->_value;
+        }
+    }
+private:
+    std::filesystem::path _path;
+};
+
+#endif // PTR_BENCHMARK_H
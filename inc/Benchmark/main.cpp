@@ -1,21 +1,44 @@
 #include <iostream>
 #include "Benchmark.hpp"
+#include "PtrBenchmark.hpp"
+#include "HashMap.hpp"
+
+// the harness is parametrised by tree degree which a hash table doesn't have
+template <class K, class V, ssize_t>
+using HashMapAdaptor = HashMap<K,V>;
 
 int main() {
     BTreeBenchmark<BTree,1024> b1("btree");
     BTreeBenchmark<BPlusTree,1024> b2("bplustree");
+    BTreeBenchmark<HashMapAdaptor,0> b4("hashmap");
     
     b1.launchInsertions( 1'000'000 );
     b1.launchLookup( 1'000'000 );
+    b1.launchBatchLookup( 1'000'000 );
     b1.launchRemovals( 1'000'000 );
 
     std::cout << "btree done" << std::endl;
     
     b2.launchInsertions( 1'000'000 );
     b2.launchLookup( 1'000'000 );
+    b2.launchBatchLookup( 1'000'000 );
     b2.launchRemovals( 1'000'000 );
 
     std::cout << "bplustree done" << std::endl;
 
+    b4.launchInsertions( 1'000'000 );
+    b4.launchLookup( 1'000'000 );
+    b4.launchBatchLookup( 1'000'000 );
+    b4.launchRemovals( 1'000'000 );
+
+    std::cout << "hashmap done" << std::endl;
+
+    SharedPtrBenchmark b3;
+    b3.launchCreation( 1'000'000 );
+    b3.launchCopies( 1'000'000 );
+    b3.launchConcurrent( 8, 1'000'000 );
+
+    std::cout << "sharedptr done" << std::endl;
+
     b1.plot();
 }
\ No newline at end of file
@@ -9,7 +9,7 @@ def plot_benchmarks():
     graphs_path.mkdir(exist_ok=True)
     
     operations = ["insert", "lookup", "remove"]
-    trees = ["btree", "bplustree"]
+    trees = ["btree", "bplustree", "hashmap"]
     
     # Individual plots for each tree
     for tree in trees:
@@ -32,7 +32,7 @@ def plot_benchmarks():
     
     # Comparison plots
     fig, axes = plt.subplots(1, 3, figsize=(15, 4))
-    fig.suptitle('BTree vs B+Tree Comparison', fontsize=16)
+    fig.suptitle('BTree vs B+Tree vs HashMap Comparison', fontsize=16)
     
     for idx, op in enumerate(operations):
         for tree in trees:
@@ -51,5 +51,62 @@ def plot_benchmarks():
     plt.savefig(graphs_path / "comparison.png", dpi=150)
     plt.close()
 
+    # Per-key vs batched lookups
+    fig, axes = plt.subplots(1, len(trees), figsize=(5 * len(trees), 4))
+    fig.suptitle('Single vs batched lookup', fontsize=16)
+    for idx, tree in enumerate(trees):
+        csv_file = base_path / tree / "batch_lookup.csv"
+        if csv_file.exists():
+            df = pd.read_csv(csv_file)
+            for column in ["single_us", "batch_us"]:
+                axes[idx].plot(df['count'], df[column], marker='o', label=column[:-3])
+        axes[idx].set_xlabel('Elements')
+        axes[idx].set_ylabel('Time (μs)')
+        axes[idx].set_title(tree.upper())
+        axes[idx].legend()
+        axes[idx].grid(True)
+
+    plt.tight_layout()
+    plt.savefig(graphs_path / "batch_lookup.png", dpi=150)
+    plt.close()
+
+    # Memory footprint per stored element
+    fig, ax = plt.subplots(figsize=(6, 4))
+    fig.suptitle('Memory per element', fontsize=16)
+    for tree in trees:
+        csv_file = base_path / tree / "insert.csv"
+        if csv_file.exists():
+            df = pd.read_csv(csv_file)
+            if 'total_bytes' in df:
+                ax.plot(df['count'], df['total_bytes'] / df['count'], marker='o', label=tree.upper())
+    ax.set_xlabel('Elements')
+    ax.set_ylabel('Bytes')
+    ax.legend()
+    ax.grid(True)
+
+    plt.tight_layout()
+    plt.savefig(graphs_path / "memory.png", dpi=150)
+    plt.close()
+
+    # SharedPtr allocation strategies vs std::shared_ptr
+    fig, axes = plt.subplots(1, 2, figsize=(10, 4))
+    fig.suptitle('SharedPtr vs std::shared_ptr', fontsize=16)
+
+    for idx, op in enumerate(["make", "copy"]):
+        csv_file = base_path / "sharedptr" / f"{op}.csv"
+        if csv_file.exists():
+            df = pd.read_csv(csv_file)
+            for column in ["separate_us", "inplace_us", "std_us"]:
+                axes[idx].plot(df['count'], df[column], marker='o', label=column[:-3])
+        axes[idx].set_xlabel('Elements')
+        axes[idx].set_ylabel('Time (μs)')
+        axes[idx].set_title(f'{op.capitalize()}')
+        axes[idx].legend()
+        axes[idx].grid(True)
+
+    plt.tight_layout()
+    plt.savefig(graphs_path / "sharedptr.png", dpi=150)
+    plt.close()
+
 if __name__ == "__main__":
     plot_benchmarks()
@@ -1,11 +1,14 @@
 #ifndef BPLUSTREE_H
 #define BPLUSTREE_H
 
-#include "SharedPtr.hpp"
+#include "IntrusivePtr.hpp"
 #include "ArraySequence.hpp"
 #include "Pair.hpp"
 #include "Ordering.hpp"
 #include "Option.hpp"
+#include "MemoryUsage.hpp"
+#include "TreeStats.hpp"
+#include "BatchLookup.hpp"
 // degree is a tree parameter defining the minimum and maximum amount of keys per node and leaf - [t-1; 2t-1] and children per node - [t; 2t]
 // in that case fanout which is max amount of children per node equals degree * 2.
 template <COrdered K, typename V, ssize_t Degree = 32>
@@ -15,15 +18,15 @@ private:
     static constexpr bool _isSet = std::is_same_v<K,V>;
     static const size_t _fanout = Degree * 2;
     static const size_t _degree = Degree;
-    struct Node 
+    struct Node : IntrusiveRefCounter<>
     {
-        WeakPtr<Node> _parent;
+        Node* _parent = nullptr;
         // if node
         ArraySequence<K> _keys;
-        ArraySequence<SharedPtr<Node>> _children;
+        ArraySequence<IntrusivePtr<Node>> _children;
         // if leaf
-        WeakPtr<Node> _left;
-        WeakPtr<Node> _right;
+        Node* _left  = nullptr;
+        Node* _right = nullptr;
         using TContents = std::conditional_t<_isSet,V,Pair<K,V>>;
         ArraySequence<TContents> _contents;
     public:
@@ -36,6 +39,16 @@ private:
 
         ~Node() = default;
     public:
+        // sizes contents of a full leaf, or separators and children of a full inner node
+        void reserve( const bool inner ) {
+            if (inner) {
+                _keys.reserve( _fanout - 1 );
+                _children.reserve( _fanout );
+            } else {
+                _contents.reserve( _fanout - 1 );
+            }
+        }
+
         bool isLeaf() const noexcept { return _children.isEmpty(); }
         bool isFull() const noexcept {
             if (isLeaf()) { return _contents.getSize() == _fanout - 1; }
@@ -92,14 +105,14 @@ private:
             }
         }
 
-        SharedPtr<Node>& kthChild( const K& key ) { return _children[BSearchInChildren(key)]; }
-        SharedPtr<Node>& ithChild( const ssize_t& index ) { return _children[index]; }
-        const SharedPtr<Node>& kthChild( const K& key ) const { return _children[BSearchInChildren(key)]; }
-        const SharedPtr<Node>& ithChild( const ssize_t& index ) const { return _children[index]; }
+        IntrusivePtr<Node>& kthChild( const K& key ) { return _children[BSearchInChildren(key)]; }
+        IntrusivePtr<Node>& ithChild( const ssize_t& index ) { return _children[index]; }
+        const IntrusivePtr<Node>& kthChild( const K& key ) const { return _children[BSearchInChildren(key)]; }
+        const IntrusivePtr<Node>& ithChild( const ssize_t& index ) const { return _children[index]; }
 
-        WeakPtr<Node>& parent() { return _parent; }
-        WeakPtr<Node>& left() { return _left; }
-        WeakPtr<Node>& right() { return _right; }
+        Node*& parent() { return _parent; }
+        Node*& left() { return _left; }
+        Node*& right() { return _right; }
     public:
         ssize_t BSearchInChildren( const K& key ) const { // returns index [0, fanout - 1] in _children array so that ithChild(index) is the root of subtree containing that key
             if (hasNoKeys()) { return 0; } 
@@ -110,9 +123,11 @@ private:
             K L = minKey();
             K R = maxKey();
             K M = ithKey(m);
+            TREE_STAT( counters().comparisons += 2 );
             if (key < L) { return 0; }
             if (R <= key) { return r; }
             while (l < r - 1) {
+                TREE_STAT( counters().comparisons++ );
                 if (M <= key) {
                     l = m;
                 } else {
@@ -132,9 +147,11 @@ private:
             K M = ithKey(m);
             K L = ithKey(l);
             K R = ithKey(r);
+            TREE_STAT( counters().comparisons += 2 );
             if (L == key) { return l; }
             if (R == key) { return r; }
             while (l < r - 1) {
+                TREE_STAT( counters().comparisons++ );
                 if (M == key) { return m; }
                 if (M < key) {
                     l = m;
@@ -147,7 +164,28 @@ private:
             return -1;
         }
         bool hasInKeys( const K& key ) const noexcept { return (BSearchInContents(key) != -1); }
+        ssize_t lowerBound( const K& key, ssize_t from ) const { // first index in [from, keyCount()] with ithKey(index) >= key
+            ssize_t to = keyCount();
+            while (from < to) {
+                TREE_STAT( counters().comparisons++ );
+                ssize_t m = (from + to) / 2;
+                if (ithKey(m) < key) { from = m + 1; } 
+                else { to = m; }
+            }
+            return from;
+        }
+        ssize_t upperBound( const K& key, ssize_t from ) const { // first index in [from, keyCount()] with ithKey(index) > key
+            ssize_t to = keyCount();
+            while (from < to) {
+                TREE_STAT( counters().comparisons++ );
+                ssize_t m = (from + to) / 2;
+                if (key < ithKey(m)) { to = m; } 
+                else { from = m + 1; }
+            }
+            return from;
+        }
         bool hasInChildren( const K& key ) const noexcept { 
+            TREE_STAT( counters().visits++ );
             if (isLeaf()) {
                 return hasInKeys(key);
             } else {
@@ -157,8 +195,11 @@ private:
         }
     };
 
-    SharedPtr<Node> _root;
+    IntrusivePtr<Node> _root;
     ssize_t _size;
+    // preallocated nodes handed out by splits, filled by reserve()
+    ArraySequence<IntrusivePtr<Node>> _spareLeaves;
+    ArraySequence<IntrusivePtr<Node>> _spareInner;
 private:
     enum class iterState
     {
@@ -192,7 +233,7 @@ private:
         using reference  = typename IterTraits::reference; 
     public:
         BPlusTreeIterator() = default;
-        BPlusTreeIterator( SharedPtr<Node> node, const ssize_t index, const int state ) 
+        BPlusTreeIterator( IntrusivePtr<Node> node, const ssize_t index, const int state ) 
         : _root(node), _observed(node), _indexInLeaf(index) {
             switch(state)
             {
@@ -212,8 +253,8 @@ private:
 
         template <typename OtherTraits>
         BPlusTreeIterator( const BPlusTreeIterator<OtherTraits>& other )
-        : _observed( other._observed ), _indexInLeaf( other._indexInLeaf )
-        , _root( other._root ), _state( other._state ) {}
+        : _root( other._root ), _observed( other._observed )
+        , _indexInLeaf( other._indexInLeaf ), _state( other._state ) {}
     public: 
         reference operator*() noexcept {
             if constexpr(_isSet) {
@@ -225,6 +266,7 @@ private:
         pointer operator->() noexcept {
             return std::addressof(_observed->_contents[_indexInLeaf]);
         }
+        const K& key() const noexcept { return _observed->ithKey(_indexInLeaf); }
 
         BPlusTreeIterator& operator++() noexcept {
             return stepForward();
@@ -254,13 +296,14 @@ private:
         bool isEnd()   const noexcept { return static_cast<int>(_state) == static_cast<int>(iterState::atEnd); }
         bool isBegin() const noexcept { return static_cast<int>(_state) == static_cast<int>(iterState::atBegin); }
 
-        static BPlusTreeIterator begin( SharedPtr<Node> root ) noexcept {
+        static BPlusTreeIterator begin( IntrusivePtr<Node> root ) noexcept {
+            if (root->keyCount() == 0) { return end(root); } // only an empty root leaf has no keys
             BPlusTreeIterator res( root, 0, -1);
             return res.setBegin().goDownLeft();
         }
-        static BPlusTreeIterator end( SharedPtr<Node> root ) noexcept {
+        static BPlusTreeIterator end( IntrusivePtr<Node> root ) noexcept {
             BPlusTreeIterator res( root, 0, 1);
-            res._observed = SharedPtr<Node>();
+            res._observed = IntrusivePtr<Node>();
             return res;
         }
     private:
@@ -300,10 +343,10 @@ private:
             } else {
                 auto right = _observed->right();
                 if (right) {
-                    _observed = right.lock();
+                    _observed = right;
                     _indexInLeaf = 0;
                 } else {
-                    _observed = SharedPtr<Node>();
+                    _observed = IntrusivePtr<Node>();
                     _indexInLeaf = 0;
                     setEnd();
                 }
@@ -318,7 +361,7 @@ private:
             } else {
                 auto left = _observed->left();
                 if (left) {
-                    _observed = left.lock();
+                    _observed = left;
                     _indexInLeaf = _observed->keyCount() - 1;
                 } else {
                     _indexInLeaf = 0;
@@ -328,8 +371,8 @@ private:
             return *this;
         }
     private:
-        SharedPtr<Node> _root;
-        SharedPtr<Node> _observed;
+        IntrusivePtr<Node> _root;
+        IntrusivePtr<Node> _observed;
         ssize_t _indexInLeaf;
         iterState _state;
         template<class> friend class BPlusTreeIterator;
@@ -352,7 +395,7 @@ public:
         return constTIter::end(_root);
     }
 public:
-    BPlusTree() : _root( makeShared<Node>() ), _size(0) {}
+    BPlusTree() : _root( makeIntrusive<Node>() ), _size(0) {}
 
     BPlusTree( const BPlusTree& other ) = delete;
     BPlusTree& operator=( const BPlusTree& other ) = delete;
@@ -375,64 +418,258 @@ public:
     }
 
     TIter find( const K& key ) {
+        TREE_STAT( counters().operations++ );
         return find( _root, key );
     }
     constTIter find( const K& key ) const {
+        TREE_STAT( counters().operations++ );
         return find( _root, key );
     }
+
+    // first entry with a greater key, iteration goes on along the leaf chain from there
+    TIter upperBound( const K& key ) {
+        TREE_STAT( counters().operations++ );
+        return upperBound<TIter>( key );
+    }
+    constTIter upperBound( const K& key ) const {
+        TREE_STAT( counters().operations++ );
+        return upperBound<constTIter>( key );
+    }
     
     template <bool isSet = _isSet> requires(isSet)
     BPlusTree& insert( const V& value ) {
+        TREE_STAT( counters().operations++ );
         return insertInSubtree( _root, Pair<V,V>( value, value ) );
     }
     BPlusTree& insert( const Pair<K,V>& pair ) {
+        TREE_STAT( counters().operations++ );
         return insertInSubtree( _root, pair );
     }
 
     BPlusTree& remove( const K& key ) {
+        TREE_STAT( counters().operations++ );
         return removeFromSubTree( _root, key );
     }
 
     bool contains( const K& key ) const {
+        TREE_STAT( counters().operations++ );
         return _root->hasInChildren(key);
     }
+    // batch lookups sort the keys once and push them down together, so a node on a shared path
+    // is searched once per batch instead of once per key. out[i] is the result for keys[i]
+    void getMany( const ArraySequence<K>& keys, ArraySequence<Option<V>>& out ) const {
+        resetBatchOutput( out, keys.getSize(), Option<V>() );
+        lookupBatch( keys, [&out]( size_t index, const typename Node::TContents& content ) {
+            if constexpr(_isSet) { out[index] = content; } 
+            else { out[index] = content.second(); }
+        });
+    }
+    void containsMany( const ArraySequence<K>& keys, ArraySequence<bool>& out ) const {
+        resetBatchOutput( out, keys.getSize(), false );
+        lookupBatch( keys, [&out]( size_t index, const typename Node::TContents& ) { out[index] = true; } );
+    }
     bool isEmpty() const {
         return _size == 0;
     }
     ssize_t getSize() const {
         return _size;
     }
+    // preallocates full-size nodes for a total of capacity entries: inserts then do not
+    // touch the allocator until the reservation runs out
+    void reserve( const size_t capacity ) {
+        reserveStorage( _root );
+        if (capacity <= static_cast<size_t>(_size)) { return; }
+        auto leaves = (capacity - _size) / (_degree - 1) + 1;
+        fillSpare( _spareLeaves, leaves, false );
+        fillSpare( _spareInner, leaves / (_degree - 1) + 1, true );
+    }
+    // replaces the contents with strictly ascending pairs in O(n) and without splits:
+    // leaves are packed left to right, then each level of separators is laid over the one below
+    BPlusTree& assignSorted( const ArraySequence<Pair<K,V>>& sorted ) {
+        for (size_t i = 1; i < sorted.getSize(); i++) {
+            if (!(sorted[i - 1].first() < sorted[i].first())) {
+                throw Exception( Exception::ErrorCode::INVALID_INPUT );
+            }
+        }
+        _root = newNode( false );
+        _size = sorted.getSize();
+        if (sorted.isEmpty()) { return *this; }
+
+        ArraySequence<IntrusivePtr<Node>> level;
+        ArraySequence<K> mins; // smallest key under every node of the level
+        auto leafCount = (sorted.getSize() + _fanout - 2) / (_fanout - 1);
+        level.reserve( leafCount );
+        mins.reserve( leafCount );
+
+        Node* previous = nullptr;
+        for (size_t leaf = 0, next = 0; leaf < leafCount; leaf++) {
+            auto node = newNode( false );
+            auto count = shareOf( sorted.getSize(), leafCount, leaf );
+            node->_contents.reserve( count );
+            for (size_t end = next + count; next < end; next++) {
+                if constexpr(_isSet) { node->_contents.append( sorted[next].first() ); }
+                else { node->_contents.append( sorted[next] ); }
+            }
+            node->left() = previous;
+            if (previous) { previous->right() = node; }
+            previous = node;
+            mins.append( node->minKey() );
+            level.append( node );
+        }
+
+        while (level.getSize() > 1) {
+            auto parentCount = (level.getSize() + _fanout - 1) / _fanout;
+            ArraySequence<IntrusivePtr<Node>> parents( parentCount );
+            ArraySequence<K> parentMins( parentCount );
+            for (size_t index = 0, child = 0; index < parentCount; index++) {
+                auto node = newNode( true );
+                auto count = shareOf( level.getSize(), parentCount, index );
+                node->reserve( true );
+                parentMins.append( mins[child] );
+                for (size_t end = child + count; child < end; child++) {
+                    if (node->childCount() > 0) { node->_keys.append( mins[child] ); }
+                    level[child]->parent() = node;
+                    node->_children.append( level[child] );
+                }
+                parents.append( node );
+            }
+            level = std::move(parents);
+            mins = std::move(parentMins);
+        }
+        _root = level[0];
+        return *this;
+    }
+    // heap bytes held by the tree nodes, separator keys count as node overhead
+    // and unused reserved nodes as slack
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        collectUsage( _root, usage );
+        usage.slack += spareBytes( _spareLeaves ) + spareBytes( _spareInner );
+        return usage;
+    }
+#ifdef TREE_STATS
+    // counters are shared by all trees of one instantiation on the calling thread
+    static TreeCounters& counters() noexcept {
+        static thread_local TreeCounters counters;
+        return counters;
+    }
+    TreeShape shape() const {
+        TreeShape shape;
+        collectShape( _root, 0, shape );
+        return shape;
+    }
+#endif
 private:
-    TIter find( SharedPtr<Node> node, const K& key ) {
+    template <typename TFound>
+    void lookupBatch( const ArraySequence<K>& keys, const TFound& onFound ) const {
+        TREE_STAT( counters().operations += keys.getSize() );
+        auto order = batchOrder(keys);
+        lookupBatch( _root, keys, order.data(), order.data() + order.size(), onFound );
+    }
+
+    // [first, last) are positions in keys, sorted by key, of the keys routed to the node
+    template <typename TFound>
+    void lookupBatch( const IntrusivePtr<Node>& node, const ArraySequence<K>& keys
+                    , const size_t* first, const size_t* last, const TFound& onFound ) const {
+        TREE_STAT( counters().visits++ );
+        ssize_t index = 0;
+        if (node->isLeaf()) {
+            for (; first != last; first++) {
+                const K& key = keys[*first];
+                index = node->lowerBound( key, index );
+                if (index < node->keyCount() && node->ithKey(index) == key) {
+                    onFound( *first, node->_contents[index] );
+                }
+            }
+        } else {
+            while (first != last) {
+                index = node->upperBound( keys[*first], index );
+                auto stop = first + 1;
+                while (stop != last && (index == node->keyCount() || keys[*stop] < node->ithKey(index))) { 
+                    stop++; 
+                }
+                lookupBatch( node->ithChild(index), keys, first, stop, onFound );
+                first = stop;
+            }
+        }
+    }
+
+#ifdef TREE_STATS
+    void collectShape( const IntrusivePtr<Node>& node, const size_t level, TreeShape& shape ) const {
+        shape.account( level, node->keyCount(), _fanout - 1 );
+        for (ssize_t i = 0; i < node->childCount(); i++) {
+            collectShape( node->ithChild(i), level + 1, shape );
+        }
+    }
+#endif
+
+    void collectUsage( const IntrusivePtr<Node>& node, MemoryUsage& usage ) const {
+        using TContents = typename Node::TContents;
+        auto contentsBytes = node->_contents.getSize() * sizeof(TContents);
+        auto keysBytes = node->_keys.getSize() * sizeof(K);
+        auto linksBytes = node->childCount() * sizeof(IntrusivePtr<Node>);
+
+        usage.nodes += sizeof(Node) - sizeof(IntrusiveRefCounter<>) + keysBytes + linksBytes;
+        usage.controlBlocks += sizeof(IntrusiveRefCounter<>);
+        usage.payload += contentsBytes;
+        usage.slack += node->_contents.allocatedBytes() - contentsBytes
+                     + node->_keys.allocatedBytes() - keysBytes
+                     + node->_children.allocatedBytes() - linksBytes;
+
+        for (size_t i = 0; i < node->_contents.getSize(); i++) {
+            usage.payload += ownedBytes( node->_contents[i] );
+        }
+        for (size_t i = 0; i < node->_keys.getSize(); i++) {
+            usage.nodes += ownedBytes( node->_keys[i] );
+        }
+        for (ssize_t i = 0; i < node->childCount(); i++) {
+            collectUsage( node->ithChild(i), usage );
+        }
+    }
+
+    TIter find( IntrusivePtr<Node> node, const K& key ) {
+        TREE_STAT( counters().visits++ );
+        if (!node->isLeaf()) { // separators are copies, only leaves hold contents
+            return find( node->kthChild(key), key );
+        }
         if (node->hasInKeys(key)) {
             return TIter( node, node->BSearchInContents(key), 0);
         } else {
-            if (node->isLeaf()) { return end(); }
-            
-            if (node->hasInChildren(key)) {
-                return find( node->kthChild(key), key);
-            } else {
-                return end();
-            }
+            return end();
         }
     }
 
-    constTIter find( SharedPtr<Node> node, const K& key ) const {
+    constTIter find( IntrusivePtr<Node> node, const K& key ) const {
+        TREE_STAT( counters().visits++ );
+        if (!node->isLeaf()) { // separators are copies, only leaves hold contents
+            return find( node->kthChild(key), key );
+        }
         if (node->hasInKeys(key)) {
             return constTIter( node, node->BSearchInContents(key), 0);
         } else {
-            if (node->isLeaf()) { return end(); }
-            
-            if (node->hasInChildren(key)) {
-                return find( node->kthChild(key), key);
-            } else {
-                return end();
-            }
+            return end();
+        }
+    }
+
+    template <typename Iter>
+    Iter upperBound( const K& key ) const {
+        IntrusivePtr<Node> node = _root;
+        while (!node->isLeaf()) {
+            TREE_STAT( counters().visits++ );
+            node = node->kthChild(key);
+        }
+        auto index = node->upperBound( key, 0 );
+        if (index == node->keyCount()) { // every key of the leaf is not greater, the next leaf starts above
+            if (!node->right()) { return Iter::end(_root); }
+            node = IntrusivePtr<Node>( node->right() );
+            index = 0;
         }
+        return Iter( node, index, 0 );
     }
 
-    BPlusTree& insertInSubtree( SharedPtr<Node>& root, const Pair<K,V>& pair ) {
-        auto parent = root->parent().lock();
+    BPlusTree& insertInSubtree( IntrusivePtr<Node>& root, const Pair<K,V>& pair ) {
+        TREE_STAT( counters().visits++ );
+        IntrusivePtr<Node> parent( root->parent() );
         if (!parent) {
             if (root->isLeaf()) {
                 if (root->hasInKeys( pair.first() )) {
@@ -482,30 +719,27 @@ private:
         }
     }
 
+    // the old root keeps the lower half and becomes the left child
     BPlusTree& splitRoot() {
-        auto newRoot = makeShared<Node>();
+        TREE_STAT( counters().rootSplits++ );
+        auto newRoot = newNode( true );
         newRoot->_keys.append(_root->ithKey( _root->keyCount() / 2 ) );
 
-        auto left  = makeShared<Node>();
-        auto right = makeShared<Node>();
+        auto left  = _root;
+        auto right = newNode( !left->isLeaf() );
+        auto mid   = left->keyCount() / 2;
 
         left->parent() = right->parent() = newRoot;
-        if (_root->isLeaf()) {
-            left->_contents  = _root->_contents.subArray( 0, _root->keyCount() / 2 );
-            right->_contents = _root->_contents.subArray( _root->keyCount() / 2, _root->keyCount() );  
+        if (left->isLeaf()) {
+            moveTail( left->_contents, right->_contents, mid );
             left->right() = right;
             right->left() = left;          
         } else {
-            left->_keys = _root->_keys.subArray( 0, _root->keyCount() / 2 );
-            right->_keys = _root->_keys.subArray( _root->keyCount() / 2 + 1, _root->keyCount() ); 
-
-            left->_children  = _root->_children.subArray( 0, _root->childCount() / 2 );
-            right->_children = _root->_children.subArray( _root->childCount() / 2, _root->childCount() );
+            moveTail( left->_children, right->_children, left->childCount() / 2 );
+            moveTail( left->_keys, right->_keys, mid + 1 );
+            left->_keys.removeAt( mid );
 
-            left->_children.map([&left]( SharedPtr<Node>& child) -> SharedPtr<Node> { child->parent() = left;
-                                                                                      return child; });
-                                                                                      
-            right->_children.map([&right]( SharedPtr<Node>& child) -> SharedPtr<Node> { child->parent() = right;
+            right->_children.map([&right]( IntrusivePtr<Node>& child) -> IntrusivePtr<Node> { child->parent() = right;
                                                                                         return child; });
         }
         newRoot->_children.append(left);
@@ -514,30 +748,29 @@ private:
         return *this;
     }
 
-    BPlusTree& split( SharedPtr<Node>& parent, const K& key ) {
+    BPlusTree& split( IntrusivePtr<Node>& parent, const K& key ) {
+        TREE_STAT( counters().splits++ );
         size_t index = parent->BSearchInChildren(key);
         auto& node = parent->ithChild(index);
-        auto right = makeShared<Node>();
+        auto right = newNode( !node->isLeaf() );
         K separator = node->midKey();
 
         right->parent() = parent;
 
         if (!node->isLeaf()) {
-            right->_children = node->_children.subArray( node->childCount() / 2, node->childCount() );
-            right->_children.map([&right]( SharedPtr<Node>& child ) -> SharedPtr<Node> { child->parent() = right;
+            moveTail( node->_children, right->_children, node->childCount() / 2 );
+            right->_children.map([&right]( IntrusivePtr<Node>& child ) -> IntrusivePtr<Node> { child->parent() = right;
                                                                                          return child; });
-            node->_children  = node->_children.subArray( 0, node->childCount() / 2 );
-
-            right->_keys = node->_keys.subArray( node->keyCount() / 2 + 1, node->keyCount() );
-            node->_keys  = node->_keys.subArray( 0, node->keyCount() / 2 );
+            auto mid = node->keyCount() / 2;
+            moveTail( node->_keys, right->_keys, mid + 1 );
+            node->_keys.removeAt( mid );
         } else {
-            right->_contents = node->_contents.subArray( node->keyCount() / 2, node->keyCount() );
-            node->_contents  = node->_contents.subArray( 0, node->keyCount() / 2 );
+            moveTail( node->_contents, right->_contents, node->keyCount() / 2 );
 
             right->right() = node->right();
             node->right() = right;
             right->left() = node;
-            if (right->right()) { right->right().lock()->left() = right; }
+            if (right->right()) { right->right()->left() = right; }
         }
         parent->_keys.insertAt( separator, index );
         parent->_children.insertAt( right, index + 1 );
@@ -545,24 +778,76 @@ private:
         return *this;
     }
 
-    BPlusTree& merge( SharedPtr<Node>& node1Ref, SharedPtr<Node>& node2Ref ) {
-        SharedPtr<Node> node1 = node1Ref;
-        SharedPtr<Node> node2 = node2Ref;
+    // size of part index when total items are spread over parts as evenly as possible;
+    // with the fewest parts that fit, every part then holds at least the minimum of a node
+    static size_t shareOf( const size_t total, const size_t parts, const size_t index ) noexcept {
+        return total / parts + (index < total % parts ? 1 : 0);
+    }
+
+    IntrusivePtr<Node> newNode( const bool inner ) {
+        auto& spare = inner ? _spareInner : _spareLeaves;
+        if (spare.isEmpty()) { return makeIntrusive<Node>(); }
+
+        auto node = spare[spare.getSize() - 1];
+        spare.removeAt( spare.getSize() - 1 );
+        return node;
+    }
+
+    void fillSpare( ArraySequence<IntrusivePtr<Node>>& spare, const size_t count, const bool inner ) {
+        spare.reserve( count );
+        while (spare.getSize() < count) {
+            auto node = makeIntrusive<Node>();
+            node->reserve( inner );
+            spare.append( node );
+        }
+    }
+
+    void reserveStorage( IntrusivePtr<Node> node ) {
+        node->reserve( !node->isLeaf() );
+        for (ssize_t i = 0; i < node->childCount(); i++) {
+            reserveStorage( node->ithChild(i) );
+        }
+    }
+
+    size_t spareBytes( const ArraySequence<IntrusivePtr<Node>>& spare ) const {
+        size_t bytes = spare.allocatedBytes();
+        for (size_t i = 0; i < spare.getSize(); i++) {
+            bytes += sizeof(Node) + spare[i]->_keys.allocatedBytes() + spare[i]->_children.allocatedBytes()
+                   + spare[i]->_contents.allocatedBytes();
+        }
+        return bytes;
+    }
+
+    // moves items [from, size) of src to the end of dst
+    template <typename T>
+    static void moveTail( ArraySequence<T>& src, ArraySequence<T>& dst, const size_t from ) {
+        for (size_t index = from; index < src.getSize(); index++) {
+            dst.append( src[index] );
+        }
+        while (src.getSize() > from) {
+            src.removeAt( src.getSize() - 1 );
+        }
+    }
+
+    BPlusTree& merge( IntrusivePtr<Node>& node1Ref, IntrusivePtr<Node>& node2Ref ) {
+        TREE_STAT( counters().merges++ );
+        IntrusivePtr<Node> node1 = node1Ref;
+        IntrusivePtr<Node> node2 = node2Ref;
         
-        auto parent = node1->parent().lock();
+        IntrusivePtr<Node> parent( node1->parent() );
         auto index = parent->BSearchInChildren( node1->maxKey() );
 
         if (node1->isLeaf()) {
             node1->_contents.concat( node2->_contents );
             
             node1->right() = node2->right();
-            if (node1->right()) { node1->right().lock()->left() = node1; }
+            if (node1->right()) { node1->right()->left() = node1; }
         } else {
             node1->_keys.append( parent->ithKey(index) );
             node1->_keys.concat( node2->_keys );
 
             node1->_children.concat( node2->_children );
-            node1->_children.map([&node1]( SharedPtr<Node>& child ) -> SharedPtr<Node> { child->parent() = node1;
+            node1->_children.map([&node1]( IntrusivePtr<Node>& child ) -> IntrusivePtr<Node> { child->parent() = node1;
                                                                                          return child; });            
         }
 
@@ -570,14 +855,15 @@ private:
         parent->_children.removeAt( index + 1 );
 
         if (!parent->parent() && parent->keyCount() == 0) {
-            node1->parent() = WeakPtr<Node>();
+            node1->parent() = nullptr;
             _root = node1;
         }
         return *this;
     }
 
-    BPlusTree& rotateRight( SharedPtr<Node>& node ) {
-        auto parent = node->parent().lock();
+    BPlusTree& rotateRight( IntrusivePtr<Node>& node ) {
+        TREE_STAT( counters().rightRotations++ );
+        IntrusivePtr<Node> parent( node->parent() );
         auto index  = parent->BSearchInChildren(node->maxKey()) + 1;
         auto& right = parent->ithChild(index);
 
@@ -588,20 +874,21 @@ private:
             if constexpr (_isSet) { parent->_keys.setAt( right->_contents[0], index - 1 ); }
             else { parent->_keys.setAt( right->_contents[0].first(), index - 1 ); }
         } else {
-            node->_keys.append( right->ithKey(0) );
+            // the separator comes down, the first key of the sibling replaces it
+            node->_keys.append( parent->ithKey(index - 1) );
+            parent->_keys.setAt( right->ithKey(0), index - 1 );
             right->_keys.removeAt(0);
 
             node->_children.append( right->ithChild(0) );
             node->ithChild( node->childCount() - 1 )->parent() = node;
             right->_children.removeAt(0);
-
-            parent->_keys.setAt( right->ithKey(0), index );
         }
         return *this;
     }
 
-    BPlusTree& rotateLeft( SharedPtr<Node>& node ) {
-        auto parent = node->parent().lock();
+    BPlusTree& rotateLeft( IntrusivePtr<Node>& node ) {
+        TREE_STAT( counters().leftRotations++ );
+        IntrusivePtr<Node> parent( node->parent() );
         auto index  = parent->BSearchInChildren(node->maxKey()) - 1;
         auto& left = parent->ithChild(index);
 
@@ -612,20 +899,21 @@ private:
             if constexpr (_isSet) { parent->_keys.setAt( node->_contents[0], index ); }
             else { parent->_keys.setAt( node->_contents[0].first(), index ); }
         } else {
-            node->_keys.prepend( left->ithKey(left->keyCount() - 1) );
+            // the separator comes down, the last key of the sibling replaces it
+            node->_keys.prepend( parent->ithKey(index) );
+            parent->_keys.setAt( left->ithKey(left->keyCount() - 1), index );
             left->_keys.removeAt( left->keyCount() - 1 );
 
             node->_children.prepend( left->ithChild(left->childCount() - 1) );
             node->ithChild(0)->parent() = node;
             left->_children.removeAt(left->childCount() - 1);
-
-            parent->_keys.setAt( node->ithKey(0), index );
         }
 
         return *this;
     }
 
-    BPlusTree& removeFromSubTree( SharedPtr<Node>& node, const K& key ) {
+    BPlusTree& removeFromSubTree( IntrusivePtr<Node>& node, const K& key ) {
+        TREE_STAT( counters().visits++ );
         if (node->isLeaf()) {
             return removeFromLeaf( node, key );
         } else {
@@ -633,7 +921,7 @@ private:
         }
     }
 
-    BPlusTree& removeFromNode( SharedPtr<Node>& node, const K& key ) {
+    BPlusTree& removeFromNode( IntrusivePtr<Node>& node, const K& key ) {
         auto& child = node->kthChild(key);
         auto  index = node->BSearchInChildren(key);
         if (child->hasMinKeys()) {
@@ -690,8 +978,8 @@ private:
         }
     }
 
-    BPlusTree& removeFromLeaf( SharedPtr<Node>& leaf, const K& key ) {
-        auto parent = leaf->parent().lock();
+    BPlusTree& removeFromLeaf( IntrusivePtr<Node>& leaf, const K& key ) {
+        IntrusivePtr<Node> parent( leaf->parent() );
         if (leaf->hasInKeys(key)) {
             _size--;
             if (!parent) {
@@ -699,8 +987,8 @@ private:
                 return *this;
             } else {
                 if (leaf->hasMinKeys()) {
-                    auto left  = leaf->left().lock();
-                    auto right = leaf->right().lock();
+                    IntrusivePtr<Node> left( leaf->left() );
+                    IntrusivePtr<Node> right( leaf->right() );
                     leaf->_contents.removeAt( leaf->BSearchInContents(key) );
                     if (left && right) {
                         if (left->hasMinKeys() && leaf->hasMinKeys()) { return merge(left, leaf); }
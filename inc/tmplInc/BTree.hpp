@@ -1,11 +1,13 @@
 #ifndef BTREE_H
 #define BTREE_H
 
-#include "SharedPtr.hpp"
-#include "WeakPtr.hpp"
+#include "IntrusivePtr.hpp"
 #include "ArraySequence.hpp"
 #include "Pair.hpp"
 #include "Ordering.hpp"
+#include "MemoryUsage.hpp"
+#include "TreeStats.hpp"
+#include "BatchLookup.hpp"
 // degree is a tree parameter defining the minimum and maximum amount of keys per node - [t-1; 2t-1] and children per node - [t; 2t]
 // in that case fanout which is max amount of children per node equals degree * 2.
 template <COrdered K, typename V, ssize_t Degree = 32>
@@ -16,11 +18,11 @@ private:
     static const size_t _fanout = Degree * 2;
     static const size_t _degree = Degree;
     using TKeys = std::conditional_t<_isSet, V, Pair<K,V>>;
-    struct Node {
-        WeakPtr<Node> _parent;
+    struct Node : IntrusiveRefCounter<> {
+        Node* _parent = nullptr;
 
         ArraySequence<TKeys> _keys;
-        ArraySequence<SharedPtr<Node>> _children;
+        ArraySequence<IntrusivePtr<Node>> _children;
     public:
         Node() = default;
 
@@ -31,6 +33,12 @@ private:
 
         ~Node() = default;
     public:
+        // sizes key (and for inner nodes child) storage for a full node
+        void reserve( const bool inner ) {
+            _keys.reserve( 2 * _degree - 1 );
+            if (inner) { _children.reserve( 2 * _degree ); }
+        }
+
         bool isLeaf() const noexcept { return _children.isEmpty(); }
         bool isFull() const noexcept { return _keys.getSize() == 2 * _degree - 1; }
         bool hasNoKeys()  const noexcept { return _keys.getSize() == 0; }
@@ -69,11 +77,11 @@ private:
             return _keys[index];
         }
 
-        WeakPtr<Node>& parent() { return _parent; }
-        SharedPtr<Node>& kthChild( const K& key ) { return _children[BSearchInChildren(key)]; }
-        SharedPtr<Node>& ithChild( const ssize_t& index ) { return _children[index]; }
-        const SharedPtr<Node>& kthChild( const K& key ) const { return _children[BSearchInChildren(key)]; }
-        const SharedPtr<Node>& ithChild( const ssize_t& index ) const { return _children[index]; }
+        Node*& parent() { return _parent; }
+        IntrusivePtr<Node>& kthChild( const K& key ) { return _children[BSearchInChildren(key)]; }
+        IntrusivePtr<Node>& ithChild( const ssize_t& index ) { return _children[index]; }
+        const IntrusivePtr<Node>& kthChild( const K& key ) const { return _children[BSearchInChildren(key)]; }
+        const IntrusivePtr<Node>& ithChild( const ssize_t& index ) const { return _children[index]; }
     public:
         ssize_t BSearchInKeys( const K& key ) const { // returns index in [0, 2 * Degree - 2] and ssize_t max in case key not found
             if (hasNoKeys()) { return -1; }
@@ -84,6 +92,7 @@ private:
             K M = ithKey(m);
 
             while (l < r - 1) {
+                TREE_STAT( counters().comparisons++ );
                 if (M == key) { return m; }
                 if (M < key) {
                     l = m;
@@ -105,10 +114,12 @@ private:
             K R = maxKey();
             K M = ithKey(m);
 
+            TREE_STAT( counters().comparisons += 2 );
             if (key < L) { return 0; }
             if (R < key) { return r; } 
 
             while (l < r - 1) {
+                TREE_STAT( counters().comparisons++ );
                 if (M < key) {
                     l = m;
                 } else {
@@ -120,7 +131,18 @@ private:
             return r;   
         }
         bool hasKey( const K& key ) const { return (BSearchInKeys(key) != -1); }
+        ssize_t lowerBound( const K& key, ssize_t from ) const { // first index in [from, keyCount()] with ithKey(index) >= key
+            ssize_t to = keyCount();
+            while (from < to) {
+                TREE_STAT( counters().comparisons++ );
+                ssize_t m = (from + to) / 2;
+                if (ithKey(m) < key) { from = m + 1; } 
+                else { to = m; }
+            }
+            return from;
+        }
         bool hasInChildren( const K& key ) const {
+            TREE_STAT( counters().visits++ );
             if (isLeaf()) {
                 return hasKey(key);
             } else {
@@ -134,8 +156,11 @@ private:
         }
     };
 
-    SharedPtr<Node> _root;
+    IntrusivePtr<Node> _root;
     ssize_t _size;
+    // preallocated nodes handed out by splits, filled by reserve()
+    ArraySequence<IntrusivePtr<Node>> _spareLeaves;
+    ArraySequence<IntrusivePtr<Node>> _spareInner;
 private:
     enum class iterState 
     {
@@ -168,7 +193,7 @@ private:
         using reference  = typename IterTraits::reference; 
     public:
         BTreeIterator() = default;
-        BTreeIterator( SharedPtr<Node> node, const ssize_t index, const int state ) 
+        BTreeIterator( IntrusivePtr<Node> node, const ssize_t index, const int state ) 
         : _root(node), _observed(node), _indexInNode(index) {
             switch(state)
             {
@@ -201,6 +226,7 @@ private:
         pointer operator->() noexcept {
             return std::addressof( _observed->_keys[_indexInNode]);
         }
+        const K& key() const noexcept { return _observed->ithKey(_indexInNode); }
     
         BTreeIterator& operator++() noexcept {
             return stepForward();
@@ -230,13 +256,14 @@ private:
         bool isEnd()   const noexcept { return static_cast<int>(_state) == static_cast<int>(iterState::atEnd); }
         bool isBegin() const noexcept { return static_cast<int>(_state) == static_cast<int>(iterState::atBegin); }
 
-        static BTreeIterator begin( SharedPtr<Node> root ) noexcept {
+        static BTreeIterator begin( IntrusivePtr<Node> root ) noexcept {
+            if (root->keyCount() == 0) { return end(root); } // only an empty root has no keys
             BTreeIterator res( root, 0, -1 );
             return res.goDownLeft().setBegin();
         }
-        static BTreeIterator end( SharedPtr<Node> root ) noexcept {
+        static BTreeIterator end( IntrusivePtr<Node> root ) noexcept {
             BTreeIterator res( root, 0, 1 );
-            res.observed() = SharedPtr<Node>();
+            res.observed() = IntrusivePtr<Node>();
             return res;
         }
     private:
@@ -266,7 +293,7 @@ private:
             }
             _indexInNode = _observed->keyCount() - 1;
 
-            if (_indexInNode == 0 && _observed->parent().lock()->BSearchInChildren( _observed->minKey() ) == 0) {
+            if (_indexInNode == 0 && _observed->parent()->BSearchInChildren( _observed->minKey() ) == 0) {
                 return setBegin();
             }
 
@@ -275,7 +302,7 @@ private:
 
         BTreeIterator& goUp() noexcept {
             while (_observed->parent()) {
-                _observed = _observed->parent().lock();
+                _observed = _observed->parent();
             }
             return *this;
         }
@@ -291,11 +318,11 @@ private:
                     _observed = _observed->parent();
                     if (_observed) {
                         while (_observed->keyCount() == _observed->BSearchInChildren( maxKey ) && _observed->_parent) {
-                            _observed = _observed->parent().lock();
+                            _observed = _observed->parent();
                         }
                         if (_observed->BSearchInChildren( maxKey ) == _observed->keyCount()) {
                             setEnd();
-                            _observed = SharedPtr<Node>();
+                            _observed = IntrusivePtr<Node>();
                             _indexInNode = 0;
                         } else {
                             _indexInNode = _observed->BSearchInChildren( maxKey );
@@ -329,7 +356,7 @@ private:
                     _observed = _observed->parent();
                     if (_observed) {
                         while (_observed->BSearchInChildren( minKey ) == 0 && _observed->_parent) {
-                            _observed = _observed->parent().lock();
+                            _observed = _observed->parent();
                         }
                         if (_observed->BSearchInChildren( minKey ) == 0) { 
                             setBegin();
@@ -351,10 +378,10 @@ private:
             return *this;
         }
 
-        SharedPtr<Node>& observed() { return _observed; }
+        IntrusivePtr<Node>& observed() { return _observed; }
     private:
-        SharedPtr<Node> _root;
-        SharedPtr<Node> _observed;
+        IntrusivePtr<Node> _root;
+        IntrusivePtr<Node> _observed;
         ssize_t _indexInNode;
         iterState _state;
         template<class> friend class BTreeIterator;
@@ -379,7 +406,7 @@ public:
         return constTIter::end(_root);
     }
 public:
-    BTree() : _root( makeShared<Node>() ), _size(0) {}
+    BTree() : _root( makeIntrusive<Node>() ), _size(0) {}
 
     BTree( const BTree& other ) = delete;
     BTree& operator=( const BTree& other ) = delete;
@@ -400,24 +427,43 @@ public:
         else { throw Exception( Exception::ErrorCode::ABSENT_KEY ); }
     }
     TIter find( const K& key ) {
+        TREE_STAT( counters().operations++ );
         return find( _root, key );
     }
     constTIter find( const K& key ) const {
+        TREE_STAT( counters().operations++ );
         return find( _root, key );
     }
     template <bool isSet = _isSet> requires(isSet)  
     BTree& insert( const V& value ) {
+        TREE_STAT( counters().operations++ );
         return insertInSubtree( _root, Pair<V,V>( value, value ) );
     }
     BTree& insert( const Pair<K,V>& pair ) {
+        TREE_STAT( counters().operations++ );
         return insertInSubtree( _root, pair );
     }
     BTree& remove( const K& key ) {
+        TREE_STAT( counters().operations++ );
         return removeFromSubtree(_root, key);
     }
     bool contains( const K& key ) const {
+        TREE_STAT( counters().operations++ );
         return _root->hasInChildren( key );
     }
+    // batch lookups sort the keys once and push them down together, so a node on a shared path
+    // is searched once per batch instead of once per key. out[i] is the result for keys[i]
+    void getMany( const ArraySequence<K>& keys, ArraySequence<Option<V>>& out ) const {
+        resetBatchOutput( out, keys.getSize(), Option<V>() );
+        lookupBatch( keys, [&out]( size_t index, const TKeys& content ) {
+            if constexpr(_isSet) { out[index] = content; } 
+            else { out[index] = content.second(); }
+        });
+    }
+    void containsMany( const ArraySequence<K>& keys, ArraySequence<bool>& out ) const {
+        resetBatchOutput( out, keys.getSize(), false );
+        lookupBatch( keys, [&out]( size_t index, const TKeys& ) { out[index] = true; } );
+    }
     bool isEmpty() const {
         return _size == 0;
     }
@@ -430,8 +476,37 @@ public:
     const K& leftMostContent() const {
         return leftMostContent(_root);
     }
+    // preallocates full-size nodes for a total of capacity entries: inserts then do not
+    // touch the allocator until the reservation runs out
+    void reserve( const size_t capacity ) {
+        reserveStorage( _root );
+        if (capacity <= static_cast<size_t>(_size)) { return; }
+        auto leaves = (capacity - _size) / (_degree - 1) + 1;
+        fillSpare( _spareLeaves, leaves, false );
+        fillSpare( _spareInner, leaves / (_degree - 1) + 1, true );
+    }
+    // heap bytes held by the tree nodes, unused reserved nodes count as slack
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        collectUsage( _root, usage );
+        usage.slack += spareBytes( _spareLeaves ) + spareBytes( _spareInner );
+        return usage;
+    }
+#ifdef TREE_STATS
+    // counters are shared by all trees of one instantiation on the calling thread
+    static TreeCounters& counters() noexcept {
+        static thread_local TreeCounters counters;
+        return counters;
+    }
+    TreeShape shape() const {
+        TreeShape shape;
+        collectShape( _root, 0, shape );
+        return shape;
+    }
+#endif
 private:
-    TIter find( SharedPtr<Node> node, const K& key ) {
+    TIter find( IntrusivePtr<Node> node, const K& key ) {
+        TREE_STAT( counters().visits++ );
         if ( node->hasKey(key) ) {
             return TIter( node, node->BSearchInKeys(key), 0 );
         } else {
@@ -442,7 +517,8 @@ private:
             }
         }
     }
-    constTIter find( SharedPtr<Node> node, const K& key ) const {
+    constTIter find( IntrusivePtr<Node> node, const K& key ) const {
+        TREE_STAT( counters().visits++ );
         if ( node->hasKey(key) ) {
             return TIter( node, node->BSearchInKeys(key), 0);
         } else {
@@ -454,7 +530,8 @@ private:
             }
         }
     }
-    BTree& removeFromSubtree( SharedPtr<Node>& node, const K& key ) {
+    BTree& removeFromSubtree( IntrusivePtr<Node>& node, const K& key ) {
+        TREE_STAT( counters().visits++ );
         if (node->isLeaf()) {
             return removeFromLeaf(node, key);
         } else {
@@ -462,8 +539,8 @@ private:
         }
     }
 
-    BTree& removeFromLeaf( SharedPtr<Node>& node, const K& key ) {
-        auto parent = node->parent().lock();
+    BTree& removeFromLeaf( IntrusivePtr<Node>& node, const K& key ) {
+        IntrusivePtr<Node> parent( node->parent() );
         if (node->hasKey(key)) {
             if (!parent) {
                 node->_keys.removeAt(node->BSearchInKeys(key));
@@ -499,7 +576,7 @@ private:
         return *this;
     }
 
-    BTree& removeFromNode( SharedPtr<Node>& node, const K& key ) {
+    BTree& removeFromNode( IntrusivePtr<Node>& node, const K& key ) {
         if (!node->hasKey(key)) {
             ssize_t index = node->BSearchInChildren(key);
             auto& child = node->ithChild(index);
@@ -597,8 +674,9 @@ private:
         }
     } // removeFromNode()
 
-    BTree& rotateLeft( SharedPtr<Node>& node ) {
-        auto parent = node->parent().lock();
+    BTree& rotateLeft( IntrusivePtr<Node>& node ) {
+        TREE_STAT( counters().leftRotations++ );
+        IntrusivePtr<Node> parent( node->parent() );
         ssize_t index = parent->BSearchInChildren(node->minKey()) - 1;
         
         auto& leftSibling = parent->ithChild(index);
@@ -614,8 +692,9 @@ private:
         return *this;
     }   
 
-    BTree& rotateRight( SharedPtr<Node>& node ) {
-        auto parent = node->parent().lock();
+    BTree& rotateRight( IntrusivePtr<Node>& node ) {
+        TREE_STAT( counters().rightRotations++ );
+        IntrusivePtr<Node> parent( node->parent() );
         auto index = parent->BSearchInChildren(node->maxKey());
 
         auto& rightSibling = parent->ithChild(index + 1);
@@ -631,11 +710,12 @@ private:
         return *this;
     }    
 
-    BTree& merge( SharedPtr<Node>& node1Ref, SharedPtr<Node>& node2Ref ) {
-        SharedPtr<Node> node1 = node1Ref;
-        SharedPtr<Node> node2 = node2Ref;
+    BTree& merge( IntrusivePtr<Node>& node1Ref, IntrusivePtr<Node>& node2Ref ) {
+        TREE_STAT( counters().merges++ );
+        IntrusivePtr<Node> node1 = node1Ref;
+        IntrusivePtr<Node> node2 = node2Ref;
 
-        auto parent = node1->parent().lock();
+        IntrusivePtr<Node> parent( node1->parent() );
         ssize_t sepIndex = parent->BSearchInChildren( node1->maxKey() );
         auto separator = parent->ithContent( sepIndex );
 
@@ -644,7 +724,7 @@ private:
         node1->_children.concat( node2->_children );
 
         if (!node1->isLeaf()) {
-            node1->_children.map([&node1]( SharedPtr<Node>& child ) -> SharedPtr<Node> { child->parent() = node1;
+            node1->_children.map([&node1]( IntrusivePtr<Node>& child ) -> IntrusivePtr<Node> { child->parent() = node1;
                                                                                          return child; } );
         }
 
@@ -652,66 +732,108 @@ private:
         parent->_children.removeAt(sepIndex + 1);
         
         if (!parent->parent() && parent->keyCount() == 0) {
-            node1->parent() = WeakPtr<Node>();
+            node1->parent() = nullptr;
             _root = node1;
         }
         return *this;
     }
 
+    // the old root keeps the lower half and becomes the left child
     BTree& splitRoot() {
-        auto newRoot = makeShared<Node>();
+        TREE_STAT( counters().rootSplits++ );
+        auto newRoot = newNode( true );
         newRoot->_keys.append( _root->midContent() );
 
-        auto left  = makeShared<Node>();
-        auto right = makeShared<Node>();
+        auto left  = _root;
+        auto right = newNode( !left->isLeaf() );
+        auto mid   = left->keyCount() / 2;
 
-        left->_keys  = _root->_keys.subArray( 0, _root->keyCount() / 2 );
-        right->_keys = _root->_keys.subArray( _root->keyCount() / 2 + 1, _root->keyCount() );
+        if (!left->isLeaf()) {
+            moveTail( left->_children, right->_children, mid + 1 );
+            right->_children.map([&right]( IntrusivePtr<Node>& child ) -> IntrusivePtr<Node> { child->parent() = right;
+                                                                                         return child; } );
+        }
+        moveTail( left->_keys, right->_keys, mid + 1 );
+        left->_keys.removeAt( mid );
         left->parent()  = newRoot;
         right->parent() = newRoot;
 
-        if (!_root->isLeaf()) {
-            left->_children  = _root->_children.subArray( 0, _root->keyCount() / 2 + 1 );
-            left->_children.map([&left]( SharedPtr<Node>& child ) -> SharedPtr<Node> { child->parent() = left;
-                                                                                       return child; } );
-            right->_children = _root->_children.subArray( _root->keyCount() / 2 + 1, _root->keyCount() + 1 );
-            right->_children.map([&right]( SharedPtr<Node>& child ) -> SharedPtr<Node> { child->parent() = right;
-                                                                                         return child; } );
-        }
         newRoot->_children.append(left);
         newRoot->_children.append(right);
         _root = newRoot;
         return *this;
     }
 
-    BTree& split( SharedPtr<Node>& parent, const K& key ) {
+    // the node keeps its lower half in place, the upper half moves to a new right sibling
+    BTree& split( IntrusivePtr<Node>& parent, const K& key ) {
+        TREE_STAT( counters().splits++ );
         ssize_t indexInParent = parent->BSearchInChildren(key);
-        auto& node = parent->kthChild(key);
+        IntrusivePtr<Node> node = parent->ithChild(indexInParent);
         parent->_keys.insertAt( node->midContent(), indexInParent );
 
-        auto left  = makeShared<Node>();
-        auto right = makeShared<Node>();
-        
-        left->_keys      = node->_keys.subArray( 0, node->keyCount()/2 );
-        right->_keys     = node->_keys.subArray( node->keyCount()/2 + 1, node->keyCount() );
-        left->parent()   = parent;
-        right->parent()  = parent;                            
+        auto right = newNode( !node->isLeaf() );
+        auto mid   = node->keyCount() / 2;
+        right->parent() = parent;
 
         if (!node->isLeaf()) {
-            left->_children  = node->_children.subArray( 0, node->keyCount() / 2 + 1 );
-            left->_children.map([&left]( SharedPtr<Node>& child ) -> SharedPtr<Node> { child->_parent = left;
-                                                                                       return child; } );
-            right->_children = node->_children.subArray( node->keyCount() / 2 + 1, node->keyCount() + 1);
-            right->_children.map([&right]( SharedPtr<Node>& child ) -> SharedPtr<Node> { child->_parent = right;
+            moveTail( node->_children, right->_children, mid + 1 );
+            right->_children.map([&right]( IntrusivePtr<Node>& child ) -> IntrusivePtr<Node> { child->_parent = right;
                                                                                          return child; } );
         }
-        parent->_children[indexInParent] = left;
+        moveTail( node->_keys, right->_keys, mid + 1 );
+        node->_keys.removeAt( mid );
+
         parent->_children.insertAt(right, indexInParent + 1);
         return *this;
     }
 
-    BTree& insertInSubtree( SharedPtr<Node>& root, const Pair<K,V>& pair ) {
-        auto parent = root->parent().lock();
+    IntrusivePtr<Node> newNode( const bool inner ) {
+        auto& spare = inner ? _spareInner : _spareLeaves;
+        if (spare.isEmpty()) { return makeIntrusive<Node>(); }
+
+        auto node = spare[spare.getSize() - 1];
+        spare.removeAt( spare.getSize() - 1 );
+        return node;
+    }
+
+    void fillSpare( ArraySequence<IntrusivePtr<Node>>& spare, const size_t count, const bool inner ) {
+        spare.reserve( count );
+        while (spare.getSize() < count) {
+            auto node = makeIntrusive<Node>();
+            node->reserve( inner );
+            spare.append( node );
+        }
+    }
+
+    void reserveStorage( IntrusivePtr<Node> node ) {
+        node->reserve( !node->isLeaf() );
+        for (ssize_t i = 0; i < node->childCount(); i++) {
+            reserveStorage( node->ithChild(i) );
+        }
+    }
+
+    size_t spareBytes( const ArraySequence<IntrusivePtr<Node>>& spare ) const {
+        size_t bytes = spare.allocatedBytes();
+        for (size_t i = 0; i < spare.getSize(); i++) {
+            bytes += sizeof(Node) + spare[i]->_keys.allocatedBytes() + spare[i]->_children.allocatedBytes();
+        }
+        return bytes;
+    }
+
+    // moves items [from, size) of src to the end of dst
+    template <typename T>
+    static void moveTail( ArraySequence<T>& src, ArraySequence<T>& dst, const size_t from ) {
+        for (size_t index = from; index < src.getSize(); index++) {
+            dst.append( src[index] );
+        }
+        while (src.getSize() > from) {
+            src.removeAt( src.getSize() - 1 );
+        }
+    }
+
+    BTree& insertInSubtree( IntrusivePtr<Node>& root, const Pair<K,V>& pair ) {
+        TREE_STAT( counters().visits++ );
+        IntrusivePtr<Node> parent( root->parent() );
         if (!parent) {
             if (root->isLeaf()) {
                 if (root->hasKey(pair.first())) {
@@ -761,14 +883,73 @@ private:
         }
     }
 
-    const TKeys& rightMostContent( SharedPtr<Node> node ) {
+    template <typename TFound>
+    void lookupBatch( const ArraySequence<K>& keys, const TFound& onFound ) const {
+        TREE_STAT( counters().operations += keys.getSize() );
+        auto order = batchOrder(keys);
+        lookupBatch( _root, keys, order.data(), order.data() + order.size(), onFound );
+    }
+
+    // [first, last) are positions in keys, sorted by key, of the keys routed to the node
+    template <typename TFound>
+    void lookupBatch( const IntrusivePtr<Node>& node, const ArraySequence<K>& keys
+                    , const size_t* first, const size_t* last, const TFound& onFound ) const {
+        TREE_STAT( counters().visits++ );
+        ssize_t index = 0;
+        while (first != last) {
+            const K& key = keys[*first];
+            index = node->lowerBound( key, index );
+
+            if (index < node->keyCount() && node->ithKey(index) == key) {
+                onFound( *first++, node->ithContent(index) );
+            } else if (node->isLeaf()) {
+                first++;
+            } else {
+                auto stop = first + 1;
+                while (stop != last && (index == node->keyCount() || keys[*stop] < node->ithKey(index))) { 
+                    stop++; 
+                }
+                lookupBatch( node->ithChild(index), keys, first, stop, onFound );
+                first = stop;
+            }
+        }
+    }
+
+#ifdef TREE_STATS
+    void collectShape( const IntrusivePtr<Node>& node, const size_t level, TreeShape& shape ) const {
+        shape.account( level, node->keyCount(), 2 * _degree - 1 );
+        for (ssize_t i = 0; i < node->childCount(); i++) {
+            collectShape( node->ithChild(i), level + 1, shape );
+        }
+    }
+#endif
+
+    void collectUsage( const IntrusivePtr<Node>& node, MemoryUsage& usage ) const {
+        auto keysBytes = node->keyCount() * sizeof(TKeys);
+        auto linksBytes = node->childCount() * sizeof(IntrusivePtr<Node>);
+
+        usage.nodes += sizeof(Node) - sizeof(IntrusiveRefCounter<>) + linksBytes;
+        usage.controlBlocks += sizeof(IntrusiveRefCounter<>);
+        usage.payload += keysBytes;
+        usage.slack += node->_keys.allocatedBytes() - keysBytes
+                     + node->_children.allocatedBytes() - linksBytes;
+
+        for (ssize_t i = 0; i < node->keyCount(); i++) {
+            usage.payload += ownedBytes( node->ithContent(i) );
+        }
+        for (ssize_t i = 0; i < node->childCount(); i++) {
+            collectUsage( node->ithChild(i), usage );
+        }
+    }
+
+    const TKeys& rightMostContent( IntrusivePtr<Node> node ) {
         while (!node->isLeaf()) {
             node = node->ithChild( node->childCount() - 1 );
         }
         return node->ithContent( node->keyCount() - 1 );
     }
 
-    const TKeys& leftMostContent( SharedPtr<Node> node ) {
+    const TKeys& leftMostContent( IntrusivePtr<Node> node ) {
         while (!node->isLeaf()) {
             node = node->ithChild( 0 );
         }
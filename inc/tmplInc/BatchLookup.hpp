@@ -0,0 +1,29 @@
+#ifndef BATCH_LOOKUP_H
+#define BATCH_LOOKUP_H
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include "ArraySequence.hpp"
+#include "Option.hpp"
+#include "Ordering.hpp"
+
+// positions of keys in ascending key order: trees walk a batch in this order
+// so that keys sharing a path are routed through each node together
+template <COrdered K>
+std::vector<size_t> batchOrder( const ArraySequence<K>& keys ) {
+    std::vector<size_t> order( keys.getSize() );
+    std::iota( order.begin(), order.end(), size_t(0) );
+    std::sort( order.begin(), order.end(), [&keys]( size_t lhs, size_t rhs ) { return keys[lhs] < keys[rhs]; } );
+    return order;
+}
+
+// fills out with one empty entry per key, batch lookups then only set the found ones
+template <typename T>
+void resetBatchOutput( ArraySequence<T>& out, const size_t count, const T& empty ) {
+    out.clear();
+    out.reserve( count );
+    for (size_t i = 0; i < count; i++) { out.append( empty ); }
+}
+
+#endif // BATCH_LOOKUP_H
@@ -0,0 +1,124 @@
+#ifndef BLOB_STORE_H
+#define BLOB_STORE_H
+
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include "HashMap.hpp"
+#include "MappedFile.hpp"
+#include "VFSImage.hpp"
+
+// content-addressed storage for the backing files of a VFS. a file is stored once per distinct
+// content as <dir>/<64-bit hash in hex>-<n>: content is hashed in one pass and compared byte by
+// byte with the blobs of the same hash, n telling colliding contents apart. blobs are counted
+// by the File nodes pointing at them, the owner reports every reference taken and dropped. a
+// blob is deleted by the release() of its last reference, at once: put() hands out any blob on
+// disk, so a deletion left for later could hit a blob that has new references by then
+class BlobStore
+{
+public:
+    explicit BlobStore( const std::filesystem::path& dir ) : _dir( dir ) {
+        std::filesystem::create_directories(_dir);
+    }
+
+    BlobStore( const BlobStore& other ) = delete;
+    BlobStore& operator=( const BlobStore& other ) = delete;
+
+    ~BlobStore() = default;
+public:
+    // the blob holding the content of source, which takes a reference. a path of a blob
+    // already in the store only takes the reference
+    std::filesystem::path ingest( const std::filesystem::path& source ) {
+        if (owns(source)) {
+            if (!std::filesystem::exists(source)) {
+                throw Exception( std::format( "Error. Blob {} is missing.", source.string() ));
+            }
+            retain(source);
+            return source;
+        }
+        MappedFile file( source.string() );
+        auto blob = put( file.data(), file.size() );
+        retain(blob);
+        return blob;
+    }
+
+    // the blob of the empty content, without a reference
+    std::filesystem::path empty() {
+        return put( nullptr, 0 );
+    }
+
+    void retain( const std::filesystem::path& blob ) {
+        auto name = blob.filename().string();
+        auto it = _refs.find(name);
+        if (it != _refs.end()) { (*it)++; }
+        else { _refs.insert( Pair<std::string,size_t>( name, 1 )); }
+    }
+    // true when that was the last reference and the blob is deleted
+    bool release( const std::filesystem::path& blob ) {
+        auto name = blob.filename().string();
+        auto it = _refs.find(name);
+        if (it == _refs.end()) { return false; }
+        if (--(*it) != 0) { return false; }
+        _refs.remove(name);
+        std::error_code ec; // a blob that is already gone is not an error
+        std::filesystem::remove( blob, ec );
+        return true;
+    }
+    size_t refs( const std::filesystem::path& blob ) const {
+        auto it = _refs.find( blob.filename().string() );
+        return (it == _refs.end()) ? 0 : *it;
+    }
+
+    bool owns( const std::filesystem::path& path ) const {
+        return path.parent_path() == _dir;
+    }
+    // forgets every reference, for an owner that recounts them
+    void clear() {
+        _refs = HashMap<std::string,size_t>();
+    }
+
+    const std::filesystem::path& dir() const noexcept { return _dir; }
+    ssize_t getSize() const noexcept { return _refs.getSize(); }
+    MemoryUsage memoryUsage() const { return _refs.memoryUsage(); }
+private:
+    std::filesystem::path put( const char* data, const size_t size ) {
+        static const char none = 0;
+        auto hash = VFSImage::checksum( size ? data : &none, size );
+        for (size_t n = 0;; n++) {
+            auto blob = _dir/std::format( "{:016x}-{}", hash, n );
+            if (!std::filesystem::exists(blob)) {
+                write( blob, data, size );
+                return blob;
+            }
+            if (std::filesystem::file_size(blob) == size && sameContent( blob, data, size )) {
+                return blob;
+            }
+        }
+    }
+
+    static bool sameContent( const std::filesystem::path& blob, const char* data, const size_t size ) {
+        if (size == 0) { return true; }
+        MappedFile stored( blob.string() );
+        return stored.size() == size && std::memcmp( stored.data(), data, size ) == 0;
+    }
+
+    // written aside and renamed in, so a blob under its final name is always complete
+    static void write( const std::filesystem::path& blob, const char* data, const size_t size ) {
+        auto temp = blob;
+        temp += ".tmp";
+        {
+            std::ofstream ofs( temp, std::ios::binary | std::ios::trunc );
+            if (!ofs || (size && !ofs.write( data, size )) || !ofs.flush()) {
+                throw Exception( Exception::ErrorCode::ERROR_CREATING_FILE );
+            }
+        }
+        std::filesystem::rename( temp, blob );
+    }
+private:
+    std::filesystem::path _dir;
+    HashMap<std::string,size_t> _refs; // blob file name -> File nodes pointing at it
+};
+
+#endif // BLOB_STORE_H
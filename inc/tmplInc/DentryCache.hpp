@@ -0,0 +1,170 @@
+#ifndef DENTRY_CACHE_H
+#define DENTRY_CACHE_H
+
+#include <cstring>
+#include "ArraySequence.hpp"
+#include "HashMap.hpp"
+#include "Option.hpp"
+#include "VFSNode.hpp"
+
+// bounded cache of VFS path resolutions. child entries map (parent id, name) to the child id,
+// or to 0 when the name is known to be absent; path entries map a normalized absolute path
+// of a directory to its id. slots are recycled with the CLOCK policy once the cache is full.
+// the owner keeps it exact: every link, unlink and move must be reported.
+class DentryCache
+{
+private:
+    struct Entry {
+        std::string _key;
+        NodeID _target = 0;
+        bool _referenced = false;
+    };
+    static constexpr char _childTag = 'c';
+    static constexpr char _pathTag = 'p';
+public:
+    static constexpr NodeID absent = 0; // slot map keys are never 0
+
+    explicit DentryCache( const size_t capacity = 4096 ) : _capacity( capacity ), _hand( 0 ) {
+        if (_capacity == 0) {
+            throw Exception( Exception::ErrorCode::INVALID_SIZE );
+        }
+        _entries.reserve(_capacity);
+        _index.reserve(_capacity);
+    }
+
+    DentryCache( const DentryCache& other ) = delete;
+    DentryCache& operator=( const DentryCache& other ) = delete;
+
+    ~DentryCache() = default;
+public:
+    // empty option on a miss, absent for a cached negative entry
+    Option<NodeID> child( const NodeID parent, const std::string& name ) {
+        return lookup( childKey( parent, name ));
+    }
+    void cacheChild( const NodeID parent, const std::string& name, const NodeID target ) {
+        store( childKey( parent, name ), target );
+    }
+    Option<NodeID> path( const std::string& path ) {
+        return lookup( pathKey(path) );
+    }
+    void cachePath( const std::string& path, const NodeID target ) {
+        store( pathKey(path), target );
+    }
+
+    // drops the path entries of a directory and of everything below it
+    void forgetPaths( const std::string& path ) {
+        auto prefix = pathKey(path);
+        forgetIf( [&prefix]( const std::string& key ) {
+            return key.starts_with(prefix)
+                && (key.size() == prefix.size() || key[prefix.size()] == '/');
+        });
+    }
+    // drops the child entries of a removed directory
+    void forgetChildrenOf( const NodeID parent ) {
+        auto prefix = childKey( parent, "" );
+        forgetIf( [&prefix]( const std::string& key ) { return key.starts_with(prefix); } );
+    }
+    // same for a whole removed subtree in one sweep, parents is a set with contains()
+    template <typename TSet>
+    void forgetChildrenOfAll( const TSet& parents ) {
+        forgetIf( [&parents]( const std::string& key ) {
+            return key[0] == _childTag && parents.contains( parentOf(key) );
+        });
+    }
+    void clear() {
+        _entries.clear();
+        _index = HashMap<std::string,size_t>();
+        _index.reserve(_capacity);
+        _free.clear();
+        _hand = 0;
+    }
+
+    ssize_t getSize() const noexcept { return _index.getSize(); }
+    size_t capacity() const noexcept { return _capacity; }
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage = _index.memoryUsage();
+        usage.nodes += _entries.allocatedBytes() + _free.allocatedBytes();
+        for (size_t slot = 0; slot < _entries.getSize(); slot++) {
+            usage.payload += ownedBytes( _entries[slot]._key );
+        }
+        return usage;
+    }
+private:
+    static std::string childKey( const NodeID parent, const std::string& name ) {
+        std::string key( 1 + sizeof(NodeID), _childTag );
+        std::memcpy( key.data() + 1, &parent, sizeof(NodeID) );
+        return key += name;
+    }
+    static NodeID parentOf( const std::string& childKey ) {
+        NodeID parent;
+        std::memcpy( &parent, childKey.data() + 1, sizeof(NodeID) );
+        return parent;
+    }
+    static std::string pathKey( const std::string& path ) {
+        return _pathTag + path;
+    }
+
+    Option<NodeID> lookup( const std::string& key ) {
+        auto it = _index.find(key);
+        if (it == _index.end()) { return Option<NodeID>(); }
+
+        auto& entry = _entries[*it];
+        entry._referenced = true;
+        return Option<NodeID>( entry._target );
+    }
+
+    void store( const std::string& key, const NodeID target ) {
+        auto it = _index.find(key);
+        if (it != _index.end()) {
+            _entries[*it]._target = target;
+            _entries[*it]._referenced = true;
+            return;
+        }
+
+        size_t slot;
+        if (!_free.isEmpty()) {
+            slot = _free[_free.getSize() - 1];
+            _free.removeAt( _free.getSize() - 1 );
+        } else if (_entries.getSize() < _capacity) {
+            slot = _entries.getSize();
+            _entries.append( Entry() );
+        } else {
+            slot = evict();
+        }
+        _entries[slot] = Entry{ key, target, false };
+        _index.insert( Pair<std::string,size_t>( key, slot ));
+    }
+
+    // second chance: referenced entries survive one more sweep of the hand
+    size_t evict() {
+        while (_entries[_hand]._referenced) {
+            _entries[_hand]._referenced = false;
+            _hand = (_hand + 1) % _entries.getSize();
+        }
+        auto slot = _hand;
+        _hand = (_hand + 1) % _entries.getSize();
+        _index.remove( _entries[slot]._key );
+        return slot;
+    }
+
+    template <typename Pred>
+    void forgetIf( Pred pred ) {
+        for (size_t slot = 0; slot < _entries.getSize(); slot++) {
+            auto& entry = _entries[slot];
+            if (!entry._key.empty() && pred(entry._key)) {
+                _index.remove( entry._key );
+                entry = Entry();
+                _free.append(slot);
+            }
+        }
+    }
+private:
+    ArraySequence<Entry> _entries;
+    HashMap<std::string,size_t> _index; // key -> slot in _entries
+    ArraySequence<size_t> _free;        // slots emptied by forget*
+    size_t _capacity;
+    size_t _hand;
+};
+
+#endif // DENTRY_CACHE_H
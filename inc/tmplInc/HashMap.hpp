@@ -0,0 +1,390 @@
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+#include "Pair.hpp"
+#include "MemoryUsage.hpp"
+#include "util.hpp"
+
+// open-addressing hash table of the swiss-table family, unordered alternative to the trees.
+// slots are split into groups of 15, each group has a 16 byte metadata word: one tag per slot
+// (0 - empty, otherwise the high byte of the hash) and one overflow byte. a whole group is matched
+// against a tag with a single SSE2 compare where available.
+// there are no tombstones: an insertion passing a full group sets a bit in its overflow byte, so a
+// lookup stops at the first group where the bit of its hash is clear, and erasing just clears the tag.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class HashMap
+{
+private:
+    static constexpr bool _isSet = std::is_same_v<K,V>;
+    using TKeys = std::conditional_t<_isSet, V, Pair<K,V>>;
+
+    struct alignas(16) Group {
+        static const size_t slots = 15;
+        static const size_t overflow = 15;
+
+        unsigned char _tags[16];
+    public:
+        unsigned match( const unsigned char tag ) const noexcept { // bit i set if slot i has the tag
+          #if defined(__SSE2__)
+            auto word = _mm_load_si128( reinterpret_cast<const __m128i*>(_tags) );
+            auto eq = _mm_cmpeq_epi8( word, _mm_set1_epi8( static_cast<char>(tag) ) );
+            return static_cast<unsigned>( _mm_movemask_epi8(eq) ) & 0x7FFF;
+          #else
+            unsigned res = 0;
+            for (size_t i = 0; i < slots; i++) {
+                if (_tags[i] == tag) { res |= 1u << i; }
+            }
+            return res;
+          #endif
+        }
+        unsigned matchEmpty() const noexcept { return match(0); }
+        bool isOccupied( const size_t slot ) const noexcept { return _tags[slot] != 0; }
+        bool hasOverflow( const unsigned char bit ) const noexcept { return _tags[overflow] & bit; }
+        bool hasAnyOverflow() const noexcept { return _tags[overflow] != 0; }
+        void markOverflow( const unsigned char bit ) noexcept { _tags[overflow] |= bit; }
+        void setTag( const size_t slot, const unsigned char tag ) noexcept { _tags[slot] = tag; }
+    };
+
+    struct constIterTraits {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type = V;
+        using pointer    = const V*;
+        using reference  = const V&;
+    };
+    struct nonConstIterTraits {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type = V;
+        using pointer    = V*;
+        using reference  = V&;
+    };
+
+    template <typename IterTraits>
+    class HashMapIterator {
+    public:
+        using iterator_category = typename IterTraits::iterator_category;
+        using difference_type   = typename IterTraits::difference_type;
+        using value_type = typename IterTraits::value_type;
+        using pointer    = typename IterTraits::pointer;
+        using reference  = typename IterTraits::reference;
+    public:
+        HashMapIterator() = default;
+        HashMapIterator( const Group* groups, TKeys* slots, const size_t index, const size_t capacity )
+        : _groups( groups ), _slots( slots ), _index( index ), _capacity( capacity ) {}
+
+        template <typename OtherTraits>
+        HashMapIterator( const HashMapIterator<OtherTraits>& other )
+        : _groups( other._groups ), _slots( other._slots ), _index( other._index ), _capacity( other._capacity ) {}
+    public:
+        reference operator*() noexcept {
+            if constexpr(_isSet) { return _slots[_index]; }
+            else { return _slots[_index].second(); }
+        }
+        pointer operator->() noexcept {
+            return std::addressof( operator*() );
+        }
+        const K& key() const noexcept { return keyOf( _slots[_index] ); }
+
+        HashMapIterator& operator++() noexcept {
+            do { _index++; } while (_index < _capacity && !isOccupied(_index));
+            return *this;
+        }
+        HashMapIterator operator++(int) noexcept {
+            auto res = *this;
+            ++(*this);
+            return res;
+        }
+        HashMapIterator& operator--() noexcept {
+            auto index = _index;
+            while (index > 0) {
+                if (isOccupied(--index)) {
+                    _index = index;
+                    break;
+                }
+            }
+            return *this;
+        }
+        HashMapIterator operator--(int) noexcept {
+            auto res = *this;
+            --(*this);
+            return res;
+        }
+
+        friend bool operator==( const HashMapIterator& lhs, const HashMapIterator& rhs ) noexcept {
+            return lhs._slots == rhs._slots && lhs._index == rhs._index;
+        }
+        friend bool operator!=( const HashMapIterator& lhs, const HashMapIterator& rhs ) noexcept {
+            return !( lhs == rhs );
+        }
+
+        static HashMapIterator begin( const Group* groups, TKeys* slots, const size_t capacity ) noexcept {
+            HashMapIterator res( groups, slots, 0, capacity );
+            if (capacity != 0 && !res.isOccupied(0)) { ++res; }
+            return res;
+        }
+        static HashMapIterator end( const Group* groups, TKeys* slots, const size_t capacity ) noexcept {
+            return HashMapIterator( groups, slots, capacity, capacity );
+        }
+    private:
+        bool isOccupied( const size_t index ) const noexcept {
+            return _groups[index / Group::slots].isOccupied( index % Group::slots );
+        }
+
+        const Group* _groups = nullptr;
+        TKeys* _slots = nullptr;
+        size_t _index = 0;
+        size_t _capacity = 0;
+
+        template <typename> friend class HashMapIterator;
+    };
+public:
+    using TIter = HashMapIterator<
+        std::conditional_t<_isSet,constIterTraits,nonConstIterTraits>
+                                 >;
+    using constTIter = HashMapIterator<constIterTraits>;
+
+    TIter begin() noexcept { return TIter::begin( _groups, _slots, capacity() ); }
+    TIter end() noexcept { return TIter::end( _groups, _slots, capacity() ); }
+    constTIter begin() const noexcept { return constTIter::begin( _groups, _slots, capacity() ); }
+    constTIter end() const noexcept { return constTIter::end( _groups, _slots, capacity() ); }
+public:
+    HashMap() : _groups( nullptr ), _slots( nullptr ), _groupCount( 0 ), _size( 0 ), _growthLeft( 0 ) {}
+
+    HashMap( const HashMap& other ) = delete;
+    HashMap& operator=( const HashMap& other ) = delete;
+
+    HashMap( HashMap&& other ) noexcept
+    : _groups( other._groups ), _slots( other._slots ), _groupCount( other._groupCount )
+    , _size( other._size ), _growthLeft( other._growthLeft ), _hash( std::move(other._hash) ) {
+        other.forget();
+    }
+    HashMap& operator=( HashMap&& other ) noexcept {
+        if (this != &other) {
+            release();
+            _groups = other._groups;
+            _slots = other._slots;
+            _groupCount = other._groupCount;
+            _size = other._size;
+            _growthLeft = other._growthLeft;
+            _hash = std::move(other._hash);
+            other.forget();
+        }
+        return *this;
+    }
+
+    ~HashMap() { release(); }
+public:
+    template <bool isSet = _isSet> requires(!isSet)
+    V& get( const K& key ) {
+        auto index = findIndex(key);
+        if (index != -1) { return _slots[index].second(); }
+        else { throw Exception( Exception::ErrorCode::ABSENT_KEY ); }
+    }
+    const V& get( const K& key ) const {
+        auto index = findIndex(key);
+        if (index == -1) { throw Exception( Exception::ErrorCode::ABSENT_KEY ); }
+        if constexpr(_isSet) { return _slots[index]; }
+        else { return _slots[index].second(); }
+    }
+
+    TIter find( const K& key ) {
+        auto index = findIndex(key);
+        return (index == -1) ? end() : TIter( _groups, _slots, index, capacity() );
+    }
+    constTIter find( const K& key ) const {
+        auto index = findIndex(key);
+        return (index == -1) ? end() : constTIter( _groups, _slots, index, capacity() );
+    }
+
+    template <bool isSet = _isSet> requires(isSet)
+    HashMap& insert( const V& value ) {
+        return insertContent( value, value );
+    }
+    HashMap& insert( const Pair<K,V>& pair ) {
+        if constexpr(_isSet) { return insertContent( pair.first(), pair.first() ); }
+        else { return insertContent( pair.first(), pair ); }
+    }
+
+    HashMap& remove( const K& key ) {
+        auto index = findIndex(key);
+        if (index != -1) {
+            auto& group = _groups[index / Group::slots];
+            std::destroy_at( _slots + index );
+            group.setTag( index % Group::slots, 0 );
+            _size--;
+            // a slot freed in an overflowed group does not shorten any probe sequence,
+            // so it is not returned to the budget and the next rehash cleans the group up
+            if (!group.hasAnyOverflow()) { _growthLeft++; }
+        }
+        return *this;
+    }
+
+    bool contains( const K& key ) const {
+        return findIndex(key) != -1;
+    }
+    bool isEmpty() const noexcept {
+        return _size == 0;
+    }
+    ssize_t getSize() const noexcept {
+        return _size;
+    }
+    size_t capacity() const noexcept {
+        return _groupCount * Group::slots;
+    }
+    // grows the table once so that count entries fit without a rehash
+    void reserve( const size_t count ) {
+        auto groupCount = groupsFor(count);
+        if (groupCount > _groupCount) { rehash(groupCount); }
+    }
+
+    // metadata words count as nodes, empty slots as slack
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.nodes = _groupCount * sizeof(Group);
+        usage.payload = _size * sizeof(TKeys);
+        usage.slack = (capacity() - _size) * sizeof(TKeys);
+        for (size_t index = 0; index < capacity(); index++) {
+            if (isOccupied(index)) { usage.payload += ownedBytes( _slots[index] ); }
+        }
+        return usage;
+    }
+private:
+    static size_t mix( size_t hash ) noexcept { // spreads weak hashes (identity for integers) over all bits
+        hash ^= hash >> 32;
+        hash *= 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+        return hash;
+    }
+    static unsigned char tagOf( const size_t hash ) noexcept {
+        auto tag = static_cast<unsigned char>( hash >> 56 );
+        return (tag == 0) ? 1 : tag;
+    }
+    static unsigned char overflowBitOf( const size_t hash ) noexcept {
+        return static_cast<unsigned char>( 1u << ((hash >> 48) & 7) );
+    }
+    static size_t maxLoad( const size_t groupCount ) noexcept {
+        return groupCount * Group::slots * 7 / 8;
+    }
+    bool isOccupied( const size_t index ) const noexcept {
+        return _groups[index / Group::slots].isOccupied( index % Group::slots );
+    }
+    static const K& keyOf( const TKeys& content ) noexcept {
+        if constexpr(_isSet) { return content; }
+        else { return content.first(); }
+    }
+
+    ssize_t findIndex( const K& key ) const {
+        if (_groupCount == 0) { return -1; }
+        auto hash = mix( _hash(key) );
+        auto tag  = tagOf(hash);
+        auto bit  = overflowBitOf(hash);
+        auto pos  = hash & (_groupCount - 1);
+
+        for (size_t step = 1; step <= _groupCount; step++) {
+            const auto& group = _groups[pos];
+            for (auto mask = group.match(tag); mask != 0; mask &= mask - 1) {
+                auto index = pos * Group::slots + std::countr_zero(mask);
+                if (keyOf( _slots[index] ) == key) { return index; }
+            }
+            if (!group.hasOverflow(bit)) { return -1; }
+            pos = (pos + step) & (_groupCount - 1);
+        }
+        return -1;
+    }
+
+    HashMap& insertContent( const K& key, const TKeys& content ) {
+        if (contains(key)) {
+            throw Exception( Exception::ErrorCode::KEY_COLLISION );
+        }
+        if (_growthLeft == 0) {
+            rehash( groupsFor( _size + 1 ) );
+        }
+        place( mix( _hash(key) ), TKeys( content ) );
+        _size++;
+        _growthLeft--;
+        return *this;
+    }
+
+    void place( const size_t hash, TKeys&& content ) {
+        auto bit = overflowBitOf(hash);
+        auto pos = hash & (_groupCount - 1);
+
+        for (size_t step = 1; ; step++) {
+            auto& group = _groups[pos];
+            auto empty = group.matchEmpty();
+            if (empty != 0) {
+                auto slot = static_cast<size_t>( std::countr_zero(empty) );
+                std::construct_at( _slots + pos * Group::slots + slot, std::move(content) );
+                group.setTag( slot, tagOf(hash) );
+                return;
+            }
+            group.markOverflow(bit);
+            pos = (pos + step) & (_groupCount - 1);
+        }
+    }
+
+    static size_t groupsFor( const size_t count ) noexcept {
+        size_t groupCount = 1;
+        while (maxLoad(groupCount) < count) { groupCount *= 2; }
+        return groupCount;
+    }
+
+    // rebuilding also drops every overflow bit
+    void rehash( const size_t groupCount ) {
+        auto oldGroups = _groups;
+        auto oldSlots  = _slots;
+        auto oldCount  = _groupCount;
+
+        _groups = new Group[groupCount]();
+        _slots  = std::allocator<TKeys>().allocate( groupCount * Group::slots );
+        _groupCount = groupCount;
+        _growthLeft = maxLoad(groupCount) - _size;
+
+        for (size_t index = 0; index < oldCount * Group::slots; index++) {
+            if (oldGroups[index / Group::slots].isOccupied( index % Group::slots )) { // isOccupied() already reads the new table
+                place( mix( _hash( keyOf(oldSlots[index]) ) ), std::move( oldSlots[index] ) );
+                std::destroy_at( oldSlots + index );
+            }
+        }
+        if (oldCount != 0) {
+            std::allocator<TKeys>().deallocate( oldSlots, oldCount * Group::slots );
+            delete[] oldGroups;
+        }
+    }
+
+    void release() noexcept {
+        for (size_t index = 0; index < capacity(); index++) {
+            if (isOccupied(index)) { std::destroy_at( _slots + index ); }
+        }
+        if (_groupCount != 0) {
+            std::allocator<TKeys>().deallocate( _slots, capacity() );
+            delete[] _groups;
+        }
+        forget();
+    }
+    void forget() noexcept {
+        _groups = nullptr;
+        _slots = nullptr;
+        _groupCount = 0;
+        _size = 0;
+        _growthLeft = 0;
+    }
+private:
+    Group* _groups;
+    TKeys* _slots;
+    size_t _groupCount; // always a power of two
+    ssize_t _size;
+    size_t _growthLeft; // insertions left before a rehash
+    Hash _hash;
+};
+
+#endif // HASHMAP_H
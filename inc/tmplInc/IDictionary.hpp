@@ -4,15 +4,17 @@
 #include "CRequirements.hpp"
 #include "BTree.hpp"
 #include "BPlusTree.hpp"
+#include "BatchLookup.hpp"
+#include "BloomFilter.hpp"
 
 template <typename K, typename V, typename TContainer = BTree<K,V>>     
 requires CAssociative<TContainer,K,V>
 class IDictionary 
 {
 public:
-    IDictionary() : _container(), _capacity() {}
+    IDictionary() : _container(), _capacity(), _filterFrom(-1) {}
     IDictionary( const ssize_t capacity ) 
-    : _container(), _capacity( capacity ) {}
+    : _container(), _capacity(), _filterFrom(-1) { reserve(capacity); }
 
     IDictionary( const IDictionary& other ) = delete;
     IDictionary& operator=( const IDictionary& other ) = delete;
@@ -31,17 +33,88 @@ public:
     }
     void add( const Pair<K,V>& pair ) {
         _container.insert(pair);
+        if (_filter.isEnabled()) {
+            _filter.add( pair.first() );
+            if (_filter.needsRebuild()) { rebuildFilter(); }
+        } else if (wantsFilter()) {
+            rebuildFilter();
+        }
     }
     void add( const K& key, const V& value ) {
-        auto pair = Pair<K,V>( key, value );
-        _container.insert(pair);
+        add( Pair<K,V>( key, value ) );
     }
     void remove( const K& key ) {
         _container.remove(key);
+        if (_filter.isEnabled()) {
+            _filter.noteRemoved();
+            if (_filter.needsRebuild()) { rebuildFilter(); }
+        }
     }
     bool contains( const K& key ) const {
+        if (!_filter.mayContain(key)) { return false; }
         return _container.contains(key);
     }
+    // keeps a Bloom filter over the keys once there are minSize of them, so that contains()
+    // answers most misses without searching the container; a small container is searched about
+    // as fast and saves the filter block. the filter is rebuilt from the keys when it gets inaccurate
+    void useBloomFilter( const ssize_t minSize = 0 ) {
+        if (minSize < 0) {
+            throw Exception( Exception::ErrorCode::INVALID_SIZE );
+        }
+        _filterFrom = minSize;
+        if (wantsFilter()) { rebuildFilter(); }
+    }
+    bool hasBloomFilter() const noexcept {
+        return _filter.isEnabled();
+    }
+    // out[i] holds the value of keys[i] or nothing if it is absent.
+    // containers without batch support are queried key by key
+    void getMany( const ArraySequence<K>& keys, ArraySequence<Option<V>>& out ) const {
+        if constexpr (requires { _container.getMany( keys, out ); }) {
+            _container.getMany( keys, out );
+        } else {
+            resetBatchOutput( out, keys.getSize(), Option<V>() );
+            for (size_t i = 0; i < keys.getSize(); i++) {
+                if (_container.contains( keys[i] )) { out[i] = _container.get( keys[i] ); }
+            }
+        }
+    }
+    void containsMany( const ArraySequence<K>& keys, ArraySequence<bool>& out ) const {
+        if constexpr (requires { _container.containsMany( keys, out ); }) {
+            _container.containsMany( keys, out );
+        } else {
+            resetBatchOutput( out, keys.getSize(), false );
+            for (size_t i = 0; i < keys.getSize(); i++) {
+                out[i] = _container.contains( keys[i] );
+            }
+        }
+    }
+    // replaces the contents with strictly ascending pairs. containers without bulk
+    // construction are rebuilt pair by pair
+    void assignSorted( const ArraySequence<Pair<K,V>>& sorted ) {
+        if constexpr (requires { _container.assignSorted( sorted ); }) {
+            _container.assignSorted( sorted );
+        } else {
+            _container = TContainer();
+            if constexpr (requires { _container.reserve( size_t() ); }) {
+                _container.reserve( sorted.getSize() );
+            }
+            for (size_t i = 0; i < sorted.getSize(); i++) {
+                _container.insert( sorted[i] );
+            }
+        }
+        if (_filter.isEnabled() || wantsFilter()) { rebuildFilter(); }
+    }
+    // sizes the container for capacity entries in total, if it supports preallocation
+    void reserve( const ssize_t capacity ) {
+        if (capacity < 0) {
+            throw Exception( Exception::ErrorCode::INVALID_SIZE );
+        }
+        if constexpr (requires { _container.reserve( size_t() ); }) {
+            _container.reserve( static_cast<size_t>(capacity) );
+        }
+        _capacity = std::max( _capacity, capacity );
+    }
 public:
     ssize_t getSize() const noexcept {
         return _container.getSize();
@@ -52,6 +125,11 @@ public:
     bool isEmpty() const noexcept {
         return _container.isEmpty();
     }
+    MemoryUsage memoryUsage() const {
+        auto usage = _container.memoryUsage();
+        usage += _filter.memoryUsage();
+        return usage;
+    }
 private:
     struct constIterTraits {
         using iterator_category = std::bidirectional_iterator_tag;
@@ -91,6 +169,9 @@ private:
         reference operator*() noexcept {
             return _iter.operator*();
         }
+        const K& key() const noexcept {
+            return _iter.key();
+        }
     public:
         IDictionaryIterator& operator++() noexcept {
             ++_iter;
@@ -99,7 +180,7 @@ private:
         IDictionaryIterator operator++(int) noexcept {
             auto temp = *this;
             ++_iter;
-            return *this;
+            return temp;
         }
         IDictionaryIterator& operator--() noexcept {
             --_iter;
@@ -108,7 +189,7 @@ private:
         IDictionaryIterator operator--(int) noexcept {
             auto temp = *this;
             --_iter;
-            return *this;
+            return temp;
         }
         friend bool operator==( const IDictionaryIterator& lhs, const IDictionaryIterator& rhs ) {
             return lhs._iter == rhs._iter;
@@ -129,9 +210,32 @@ public:
     TIter end()   { return TIter(_container.end()); }
     constTIter begin() const { return constTIter(_container.begin()); }
     constTIter end() const   { return constTIter(_container.end()); }
+
+    // containers iterating in key order with a seek of their own. in any other a greater key
+    // is no position, and a scan from begin() would make every seek linear
+    static constexpr bool seekable = requires( TContainer& container, const K& key ) { container.upperBound(key); };
+
+    // first entry with a greater key
+    TIter upperBound( const K& key ) requires seekable {
+        return TIter( _container.upperBound(key) );
+    }
+private:
+    bool wantsFilter() const noexcept {
+        return _filterFrom >= 0 && !_filter.isEnabled() && getSize() >= _filterFrom;
+    }
+    void rebuildFilter() {
+        // twice the current size leaves room to grow before the next rebuild
+        BloomFilter<K> filter( 2 * static_cast<size_t>( getSize() ) );
+        if (!isEmpty()) {
+            for (auto it = _container.begin(); it != _container.end(); ++it) { filter.add( it.key() ); }
+        }
+        _filter = std::move(filter);
+    }
 private:
     TContainer _container;
     ssize_t _capacity;
+    BloomFilter<K> _filter;
+    ssize_t _filterFrom; // size at which the filter starts, -1 without one
 };
 
 #endif // IDICTIONARY_H
@@ -0,0 +1,151 @@
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ArraySequence.hpp"
+#include "HashMap.hpp"
+
+extern char** environ;
+
+// starts the viewer of a file without waiting for it. children are started by posix_spawn, which
+// neither copies the page tables of a large parent like fork nor runs anything in the child
+// before exec. a background reaper collects them, polling only the pids started here so other
+// children of the process are left to their owners, and queues a message for every failed one
+class Launcher
+{
+public:
+    explicit Launcher( std::vector<std::string> command = defaultCommand()
+                     , const std::chrono::milliseconds pollInterval = std::chrono::milliseconds( 20 ))
+    : _command( std::move(command) ), _pollInterval( pollInterval ), _stopping( false ) {
+        if (_command.empty()) {
+            throw Exception( Exception::ErrorCode::INVALID_INPUT );
+        }
+    }
+
+    Launcher( const Launcher& other ) = delete;
+    Launcher& operator=( const Launcher& other ) = delete;
+
+    // children still running are left alone, they outlive the launcher
+    ~Launcher() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        if (_reaper.joinable()) { _reaper.join(); }
+    }
+public:
+    // returns once the child exists, the command runs as <command...> <path>
+    void launch( const std::string& path ) {
+        std::vector<char*> argv;
+        for (auto& arg : _command) { argv.push_back( const_cast<char*>( arg.c_str() )); }
+        argv.push_back( const_cast<char*>( path.c_str() ));
+        argv.push_back( nullptr );
+
+        pid_t pid;
+        int error = ::posix_spawnp( &pid, argv[0], nullptr, nullptr, argv.data(), environ );
+        if (error == ENOENT || error == EACCES || error == ENOEXEC) {
+            throw Exception( Exception::ErrorCode::EXEC_FAILURE );
+        } else if (error != 0) {
+            throw Exception( Exception::ErrorCode::FORK_FAILURE );
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running.insert( Pair<pid_t,std::string>( pid, path ));
+        if (!_reaper.joinable()) { _reaper = std::thread( &Launcher::reap, this ); }
+        _wake.notify_all();
+    }
+
+    // the messages of the children that failed since the last call
+    ArraySequence<std::string> failures() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ArraySequence<std::string> taken( _failures.size() );
+        for (auto& failure : _failures) { taken.append( std::move(failure) ); }
+        _failures.clear();
+        return taken;
+    }
+
+    size_t running() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _running.getSize();
+    }
+
+    // blocks until every child started so far has been collected
+    void wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle.wait( lock, [this]() { return _running.getSize() == 0; } );
+    }
+
+    static std::vector<std::string> defaultCommand() {
+      #ifdef __APPLE__
+        return { "/usr/bin/open" };
+      #else
+        return { "xdg-open" };
+      #endif
+    }
+private:
+    void reap() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _wake.wait( lock, [this]() { return _stopping || _running.getSize() != 0; } );
+            if (_stopping) { return; }
+
+            ArraySequence<pid_t> finished;
+            for (auto it = _running.begin(); it != _running.end(); ++it) {
+                int status = 0;
+                auto result = ::waitpid( it.key(), &status, WNOHANG );
+                if (result == 0) { continue; }
+                finished.append( it.key() );
+                auto message = (result == -1) ? std::string( Exception( Exception::ErrorCode::WAITPID_FAILURE ).what() )
+                                              : describe( *it, status );
+                if (!message.empty()) { _failures.push_back( std::move(message) ); }
+            }
+            for (size_t i = 0; i < finished.getSize(); i++) {
+                _running.remove( finished[i] );
+            }
+            if (_running.getSize() == 0) {
+                _idle.notify_all();
+            } else {
+                _wake.wait_for( lock, _pollInterval, [this]() { return _stopping; } );
+            }
+        }
+    }
+
+    // empty for a child that succeeded
+    static std::string describe( const std::string& path, const int status ) {
+        if (WIFEXITED(status)) {
+            int code = WEXITSTATUS(status);
+            if (code == 127) {
+                return std::format( "Error. Unable to open {}: exec() failed.", path );
+            } else if (code != 0) {
+                return std::format( "Error. Unable to open {}: open tool failed with code {}.", path, code );
+            }
+            return std::string();
+        }
+        return std::format( "Error. Unable to open {}: killed by signal {}.", path, WTERMSIG(status) );
+    }
+private:
+    std::vector<std::string> _command;
+    std::chrono::milliseconds _pollInterval;
+
+    mutable std::mutex _mutex;             // guards everything below
+    std::condition_variable _wake;         // a child was started or the launcher stops
+    std::condition_variable _idle;         // the last running child was collected
+    HashMap<pid_t,std::string> _running;   // pid -> path of every child not collected yet
+    std::deque<std::string> _failures;
+    bool _stopping;
+    std::thread _reaper;                   // started with the first child
+};
+
+#endif // LAUNCHER_H
@@ -0,0 +1,149 @@
+#ifndef MAPPING_CACHE_H
+#define MAPPING_CACHE_H
+
+#include <string>
+#include <string_view>
+#include "ArraySequence.hpp"
+#include "HashMap.hpp"
+#include "MappedFile.hpp"
+#include "SharedPtr.hpp"
+
+// read-only view of a whole file handed out by MappingCache. it shares the mapping with the
+// cache, so the memory stays mapped after the entry was evicted or forgotten. the bytes are the
+// file's own, not a copy: a file deleted or replaced by a rename, as FileWriter does, leaves the
+// view with the old contents, while a file edited in place shows the edits and one truncated
+// raises SIGBUS on access past its new end. only files changed by renames alone, like blobs
+// and the backing files the VFS writes, keep a view stable
+class FileView
+{
+public:
+    FileView() = default;
+    explicit FileView( SharedPtr<MappedFile> file ) : _file( std::move(file) ) {}
+public:
+    const char* data() const noexcept { return _file ? _file->data() : nullptr; }
+    size_t size() const noexcept { return _file ? _file->size() : 0; }
+    bool empty() const noexcept { return size() == 0; }
+    std::string_view view() const noexcept { return std::string_view( data(), size() ); }
+private:
+    SharedPtr<MappedFile> _file;
+};
+
+// bounded cache of whole-file mappings and their open descriptors keyed by physical path, least
+// recently used evicted first. a hit costs one fstat: an entry is mapped again when its file was
+// written or truncated since, unless the caller vouches that the file never changes
+class MappingCache
+{
+private:
+    static constexpr size_t none = SIZE_MAX;
+
+    struct Entry {
+        std::string _path;
+        SharedPtr<MappedFile> _file;
+        size_t _prev = none;
+        size_t _next = none;
+    };
+public:
+    explicit MappingCache( const size_t capacity = 256 )
+    : _capacity( capacity ), _head( none ), _tail( none ) {
+        if (_capacity == 0) {
+            throw Exception( Exception::ErrorCode::INVALID_SIZE );
+        }
+        _entries.reserve(_capacity);
+        _index.reserve(_capacity);
+    }
+
+    MappingCache( const MappingCache& other ) = delete;
+    MappingCache& operator=( const MappingCache& other ) = delete;
+
+    ~MappingCache() = default;
+public:
+    FileView get( const std::string& path, const MappedFile::Access access = MappedFile::Access::sequential
+                , const bool immutable = false ) {
+        auto it = _index.find(path);
+        if (it != _index.end()) {
+            auto slot = *it;
+            auto& entry = _entries[slot];
+            if (immutable || entry._file->isCurrent()) {
+                entry._file->advise(access);
+            } else { // views handed out before keep the old mapping, see FileView
+                entry._file = makeShared<MappedFile>( path, access );
+            }
+            unchain(slot);
+            chainFront(slot);
+            return FileView( entry._file );
+        }
+
+        auto file = makeShared<MappedFile>( path, access );
+        size_t slot;
+        if (!_free.isEmpty()) {
+            slot = _free[_free.getSize() - 1];
+            _free.removeAt( _free.getSize() - 1 );
+        } else if (_entries.getSize() < _capacity) {
+            slot = _entries.getSize();
+            _entries.append( Entry() );
+        } else {
+            slot = _tail;
+            unchain(slot);
+            _index.remove( _entries[slot]._path );
+        }
+        _entries[slot] = Entry{ path, file };
+        chainFront(slot);
+        _index.insert( Pair<std::string,size_t>( path, slot ));
+        return FileView( file );
+    }
+
+    // drops the mapping of a file that was removed or is not used by the owner any more
+    void forget( const std::string& path ) {
+        auto it = _index.find(path);
+        if (it == _index.end()) { return; }
+        auto slot = *it;
+        unchain(slot);
+        _index.remove(path);
+        _entries[slot] = Entry();
+        _free.append(slot);
+    }
+    void clear() {
+        _entries.clear();
+        _index = HashMap<std::string,size_t>();
+        _index.reserve(_capacity);
+        _free.clear();
+        _head = _tail = none;
+    }
+
+    bool contains( const std::string& path ) const { return _index.find(path) != _index.end(); }
+    ssize_t getSize() const noexcept { return _index.getSize(); }
+    size_t capacity() const noexcept { return _capacity; }
+
+    // the mapped bytes are not counted, they are page cache rather than heap
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage = _index.memoryUsage();
+        usage.nodes += _entries.allocatedBytes() + _free.allocatedBytes();
+        for (size_t slot = 0; slot < _entries.getSize(); slot++) {
+            usage.payload += ownedBytes( _entries[slot]._path );
+        }
+        return usage;
+    }
+private:
+    void unchain( const size_t slot ) {
+        auto& entry = _entries[slot];
+        if (entry._prev != none) { _entries[entry._prev]._next = entry._next; } else { _head = entry._next; }
+        if (entry._next != none) { _entries[entry._next]._prev = entry._prev; } else { _tail = entry._prev; }
+        entry._prev = entry._next = none;
+    }
+    void chainFront( const size_t slot ) {
+        auto& entry = _entries[slot];
+        entry._prev = none;
+        entry._next = _head;
+        if (_head != none) { _entries[_head]._prev = slot; } else { _tail = slot; }
+        _head = slot;
+    }
+private:
+    ArraySequence<Entry> _entries;
+    HashMap<std::string,size_t> _index; // physical path -> slot in _entries
+    ArraySequence<size_t> _free;        // slots emptied by forget
+    size_t _capacity;
+    size_t _head; // most recently used
+    size_t _tail; // least recently used
+};
+
+#endif // MAPPING_CACHE_H
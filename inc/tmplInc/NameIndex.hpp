@@ -0,0 +1,157 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "ArraySequence.hpp"
+#include "BPlusTree.hpp"
+#include "SharedPtr.hpp"
+#include "VFSNode.hpp"
+
+// secondary index of entry names over a whole namespace: exact name -> ids and
+// extension -> ids, the extension being the name from its last '.' on like VFSPath::extension().
+// names are mostly distinct, so every (name, id) pair is one key of a B+ tree set, name + '\0'
+// + id bytes, held once: the ids of a name form one run that a single descent reaches. a few
+// extensions are shared by most names, so each is kept once with a set of its ids as the run.
+// a query costs O(log n + k). the owner keeps it exact: every link and unlink must be reported
+class NameIndex
+{
+private:
+    using Set = BPlusTree<std::string,std::string>;
+    using Ids = BPlusTree<NodeID,NodeID>;
+    using Runs = BPlusTree<std::string,SharedPtr<Ids>>;
+public:
+    NameIndex() = default;
+
+    NameIndex( const NameIndex& other ) = delete;
+    NameIndex& operator=( const NameIndex& other ) = delete;
+
+    ~NameIndex() = default;
+public:
+    void add( const std::string& name, const NodeID id ) {
+        _names.insert( key( name, id ));
+        auto extension = extensionOf(name);
+        if (extension.empty()) { return; }
+        auto run = _extensions.find(extension);
+        if (run != _extensions.end()) {
+            (*run)->insert(id);
+        } else {
+            auto ids = makeShared<Ids>();
+            ids->insert(id);
+            _extensions.insert( Pair<std::string,SharedPtr<Ids>>( extension, ids ));
+        }
+    }
+    void remove( const std::string& name, const NodeID id ) {
+        _names.remove( key( name, id ));
+        auto extension = extensionOf(name);
+        if (extension.empty()) { return; }
+        auto run = _extensions.find(extension);
+        if (run == _extensions.end()) { throw Exception( Exception::ErrorCode::ABSENT_KEY ); }
+        auto ids = *run;
+        ids->remove(id);
+        if (ids->isEmpty()) { _extensions.remove(extension); }
+    }
+
+    ArraySequence<NodeID> byName( const std::string& name ) const {
+        return run( _names, name );
+    }
+    // the leading '.' of extension may be omitted
+    ArraySequence<NodeID> byExtension( const std::string& extension ) const {
+        ArraySequence<NodeID> ids;
+        auto run = _extensions.find( extension.starts_with('.') ? extension : "." + extension );
+        if (run == _extensions.end()) { return ids; }
+        ids.reserve( (*run)->getSize() );
+        for (auto it = (*run)->begin(); it != (*run)->end(); ++it) { ids.append(*it); }
+        return ids;
+    }
+
+    // replaces the contents with the given entries, sorted and bulk-loaded instead of inserted
+    void assign( const ArraySequence<Pair<std::string,NodeID>>& entries ) {
+        std::vector<std::string> names;
+        std::vector<Pair<std::string,NodeID>> extensions;
+        names.reserve( entries.getSize() );
+        for (size_t i = 0; i < entries.getSize(); i++) {
+            auto& name = entries[i].first();
+            names.push_back( key( name, entries[i].second() ));
+            auto extension = extensionOf(name);
+            if (!extension.empty()) { extensions.push_back( Pair<std::string,NodeID>( extension, entries[i].second() )); }
+        }
+        _names = build( names );
+        _extensions = build( extensions );
+    }
+
+    void clear() {
+        _names = Set();
+        _extensions = Runs();
+    }
+    ssize_t getSize() const noexcept { return _names.getSize(); }
+
+    MemoryUsage memoryUsage() const {
+        auto usage = _names.memoryUsage();
+        usage += _extensions.memoryUsage();
+        for (auto it = _extensions.begin(); it != _extensions.end(); ++it) { usage += (*it)->memoryUsage(); }
+        return usage;
+    }
+private:
+    static std::string key( const std::string& term, const NodeID id ) {
+        std::string key( term.size() + 1 + sizeof(NodeID), '\0' );
+        std::memcpy( key.data(), term.data(), term.size() );
+        std::memcpy( key.data() + term.size() + 1, &id, sizeof(NodeID) );
+        return key;
+    }
+
+    // a set takes its keys from the first of each pair, the second stays empty
+    static Set build( std::vector<std::string>& keys ) {
+        std::sort( keys.begin(), keys.end() );
+        ArraySequence<Pair<std::string,std::string>> sorted( keys.size() );
+        for (auto& key : keys) { sorted.append( Pair<std::string,std::string>( std::move(key), std::string() )); }
+        Set set;
+        set.assignSorted( sorted );
+        return set;
+    }
+
+    static Runs build( std::vector<Pair<std::string,NodeID>>& entries ) {
+        std::sort( entries.begin(), entries.end(), []( const auto& lhs, const auto& rhs ) {
+            return lhs.first() < rhs.first() || (lhs.first() == rhs.first() && lhs.second() < rhs.second());
+        });
+        ArraySequence<Pair<std::string,SharedPtr<Ids>>> runs;
+        for (size_t begin = 0, end = 0; begin < entries.size(); begin = end) {
+            ArraySequence<Pair<NodeID,NodeID>> ids;
+            for (end = begin; end < entries.size() && entries[end].first() == entries[begin].first(); end++) {
+                ids.append( Pair<NodeID,NodeID>( entries[end].second(), entries[end].second() ));
+            }
+            auto run = makeShared<Ids>();
+            run->assignSorted(ids);
+            runs.append( Pair<std::string,SharedPtr<Ids>>( entries[begin].first(), run ));
+        }
+        Runs set;
+        set.assignSorted( runs );
+        return set;
+    }
+
+    static std::string extensionOf( const std::string& name ) {
+        auto dot = name.rfind('.');
+        return (dot == std::string::npos) ? std::string() : name.substr(dot);
+    }
+
+    // term + '\0' is the least key longer than term that starts with it, so the run begins
+    // right after term itself
+    static ArraySequence<NodeID> run( const Set& set, const std::string& term ) {
+        ArraySequence<NodeID> ids;
+        auto prefix = term + '\0';
+        for (auto it = set.upperBound(term); it != set.end(); ++it) {
+            auto& key = it.key();
+            if (!key.starts_with(prefix)) { break; }
+            NodeID id;
+            std::memcpy( &id, key.data() + prefix.size(), sizeof(NodeID) );
+            ids.append(id);
+        }
+        return ids;
+    }
+private:
+    Set _names;
+    Runs _extensions;
+};
+
+#endif // NAME_INDEX_H
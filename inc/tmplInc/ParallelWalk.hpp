@@ -0,0 +1,80 @@
+#ifndef PARALLEL_WALK_H
+#define PARALLEL_WALK_H
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// visits a task graph that unfolds while it is walked, e.g. the subtrees of a directory tree.
+// visit( task, spawn, worker ) may call spawn( task ) for further tasks. every worker owns a
+// deque: its own tasks are taken from the back, depth first, and an idle worker steals from the
+// front of another one, taking the oldest and so the largest pending subtree. the first
+// exception thrown by visit stops the walk and is rethrown to the caller
+template <typename Task, typename Visit>
+void parallelWalk( Task root, size_t threads, Visit visit ) {
+    if (threads == 0) { threads = 1; }
+
+    struct Worker {
+        std::mutex _mutex;
+        std::deque<Task> _tasks;
+    };
+    std::vector<Worker> workers( threads );
+    std::atomic<size_t> pending( 1 ); // queued plus running, a parent counts until its children are queued
+    std::atomic<bool> failed( false );
+    std::exception_ptr error;
+    workers[0]._tasks.push_back( std::move(root) );
+
+    auto take = [&workers]( const size_t self, Task& task ) {
+        for (size_t i = 0; i < workers.size(); i++) {
+            auto& victim = workers[(self + i) % workers.size()];
+            std::lock_guard<std::mutex> lock( victim._mutex );
+            if (victim._tasks.empty()) { continue; }
+            if (i == 0) {
+                task = std::move( victim._tasks.back() );
+                victim._tasks.pop_back();
+            } else {
+                task = std::move( victim._tasks.front() );
+                victim._tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    };
+
+    auto work = [&]( const size_t self ) {
+        auto spawn = [&]( Task task ) {
+            pending.fetch_add( 1, std::memory_order_relaxed );
+            std::lock_guard<std::mutex> lock( workers[self]._mutex );
+            workers[self]._tasks.push_back( std::move(task) );
+        };
+        Task task;
+        while (pending.load( std::memory_order_acquire ) != 0) {
+            if (!take( self, task )) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (!failed.load( std::memory_order_relaxed )) {
+                try {
+                    visit( task, spawn, self );
+                } catch (...) {
+                    if (!failed.exchange(true)) { error = std::current_exception(); }
+                }
+            }
+            pending.fetch_sub( 1, std::memory_order_acq_rel );
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t self = 1; self < threads; self++) {
+        pool.emplace_back( work, self );
+    }
+    work(0);
+    for (auto& thread : pool) { thread.join(); }
+
+    if (error) { std::rethrow_exception(error); }
+}
+
+#endif // PARALLEL_WALK_H
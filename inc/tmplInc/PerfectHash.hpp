@@ -0,0 +1,56 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// perfect hash of a fixed set of names built at compile time: seeds of an FNV-1a hash are tried
+// until every name gets a slot of its own, so a lookup costs one hash of the key and one
+// comparison however many names there are. Slots must be a power of two larger than N; a set
+// without a seed below the search limit fails to compile
+template <size_t N, size_t Slots>
+class PerfectHash
+{
+    static_assert( Slots > N && (Slots & (Slots - 1)) == 0, "Slots must be a power of two larger than N" );
+public:
+    static constexpr size_t absent = N;
+
+    consteval explicit PerfectHash( const std::array<std::string_view,N>& names ) : _names( names ) {
+        for (_seed = 1; _seed < 1u << 20; _seed++) {
+            if (tryFill()) { return; }
+        }
+        throw "no perfect seed"; // not a constant expression, compilation stops here
+    }
+public:
+    // index of name in the set, absent when it is none of them
+    constexpr size_t find( std::string_view name ) const noexcept {
+        auto index = _slots[hash( name, _seed ) & (Slots - 1)];
+        return (index != absent && _names[index] == name) ? index : absent;
+    }
+private:
+    static constexpr std::uint32_t hash( std::string_view name, const std::uint32_t seed ) noexcept {
+        std::uint32_t hash = 2166136261u ^ seed;
+        for (char ch : name) {
+            hash ^= static_cast<unsigned char>(ch);
+            hash *= 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    constexpr bool tryFill() {
+        _slots.fill( absent );
+        for (size_t i = 0; i < N; i++) {
+            auto& slot = _slots[hash( _names[i], _seed ) & (Slots - 1)];
+            if (slot != absent) { return false; }
+            slot = i;
+        }
+        return true;
+    }
+private:
+    std::array<std::string_view,N> _names;
+    std::array<size_t,Slots> _slots{};
+    std::uint32_t _seed = 0;
+};
+
+#endif // PERFECT_HASH_H
@@ -0,0 +1,793 @@
+#ifndef RADIX_TREE_H
+#define RADIX_TREE_H
+
+#include <bit>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+#include "Pair.hpp"
+#include "MemoryUsage.hpp"
+#include "util.hpp"
+
+// adaptive radix tree over string keys: a lookup descends one node per key byte, so it costs
+// O(key length) regardless of how many keys are stored. inner nodes come in four sizes (4, 16, 48
+// and 256 children) and are grown or shrunk as children come and go. bytes shared by every key below
+// a node are kept as its prefix instead of a chain of single-child nodes, and a leaf holds its whole
+// key, so a subtree with one key is just a leaf. a key ending inside the tree is the terminal leaf of
+// its node and sorts before the children. iteration is in byte order, the order of std::string.
+template <typename K, typename V>
+class RadixTree
+{
+    static_assert( std::is_same_v<K,std::string>, "RadixTree keys are strings" );
+private:
+    static constexpr bool _isSet = std::is_same_v<K,V>;
+    using TKeys = std::conditional_t<_isSet, V, Pair<K,V>>;
+
+    enum class Kind : unsigned char { leaf, node4, node16, node48, node256 };
+    static const int _terminal = -1; // position of a terminal leaf in its node
+
+    struct Inner;
+    struct Node {
+        Kind _kind;
+        int _byte = _terminal; // child byte in the parent
+        Inner* _parent = nullptr;
+    public:
+        explicit Node( const Kind kind ) : _kind( kind ) {}
+        bool isLeaf() const noexcept { return _kind == Kind::leaf; }
+    };
+    struct Leaf : Node {
+        TKeys _content;
+    public:
+        explicit Leaf( const TKeys& content ) : Node( Kind::leaf ), _content( content ) {}
+        const K& key() const noexcept {
+            if constexpr(_isSet) { return _content; }
+            else { return _content.first(); }
+        }
+    };
+    struct Inner : Node {
+        std::string _prefix; // bytes between the parent and this node
+        Leaf* _terminalLeaf = nullptr;
+        unsigned short _count = 0;
+    public:
+        explicit Inner( const Kind kind ) : Node( kind ) {}
+    };
+    struct Node4 : Inner {
+        static const size_t capacity = 4;
+        unsigned char _keys[capacity] = {}; // sorted
+        Node* _children[capacity] = {};
+    public:
+        Node4() : Inner( Kind::node4 ) {}
+    };
+    struct Node16 : Inner {
+        static const size_t capacity = 16;
+        alignas(16) unsigned char _keys[capacity] = {}; // sorted
+        Node* _children[capacity] = {};
+    public:
+        Node16() : Inner( Kind::node16 ) {}
+    };
+    struct Node48 : Inner {
+        static const size_t capacity = 48;
+        unsigned char _index[256] = {}; // slot + 1 of the child for each byte, 0 - no child
+        Node* _children[capacity] = {};
+    public:
+        Node48() : Inner( Kind::node48 ) {}
+    };
+    struct Node256 : Inner {
+        static const size_t capacity = 256;
+        Node* _children[capacity] = {};
+    public:
+        Node256() : Inner( Kind::node256 ) {}
+    };
+
+    struct constIterTraits {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type = V;
+        using pointer    = const V*;
+        using reference  = const V&;
+    };
+    struct nonConstIterTraits {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type = V;
+        using pointer    = V*;
+        using reference  = V&;
+    };
+
+    template <typename IterTraits>
+    class RadixTreeIterator {
+    public:
+        using iterator_category = typename IterTraits::iterator_category;
+        using difference_type   = typename IterTraits::difference_type;
+        using value_type = typename IterTraits::value_type;
+        using pointer    = typename IterTraits::pointer;
+        using reference  = typename IterTraits::reference;
+    public:
+        RadixTreeIterator() = default;
+        RadixTreeIterator( const RadixTree* tree, Leaf* leaf ) : _tree( tree ), _leaf( leaf ) {}
+
+        template <typename OtherTraits>
+        RadixTreeIterator( const RadixTreeIterator<OtherTraits>& other ) : _tree( other._tree ), _leaf( other._leaf ) {}
+    public:
+        reference operator*() noexcept {
+            if constexpr(_isSet) { return _leaf->_content; }
+            else { return _leaf->_content.second(); }
+        }
+        pointer operator->() noexcept {
+            return std::addressof( operator*() );
+        }
+        const K& key() const noexcept { return _leaf->key(); }
+
+        RadixTreeIterator& operator++() noexcept {
+            _leaf = successor(_leaf);
+            return *this;
+        }
+        RadixTreeIterator operator++(int) noexcept {
+            auto res = *this;
+            ++(*this);
+            return res;
+        }
+        RadixTreeIterator& operator--() noexcept { // from end() to the last key
+            if (_leaf) { _leaf = predecessor(_leaf); }
+            else if (_tree->_root) { _leaf = maximum(_tree->_root); }
+            return *this;
+        }
+        RadixTreeIterator operator--(int) noexcept {
+            auto res = *this;
+            --(*this);
+            return res;
+        }
+
+        friend bool operator==( const RadixTreeIterator& lhs, const RadixTreeIterator& rhs ) noexcept {
+            return lhs._leaf == rhs._leaf;
+        }
+        friend bool operator!=( const RadixTreeIterator& lhs, const RadixTreeIterator& rhs ) noexcept {
+            return !( lhs == rhs );
+        }
+    private:
+        const RadixTree* _tree = nullptr;
+        Leaf* _leaf = nullptr;
+
+        template <typename OtherTraits>
+        friend class RadixTreeIterator;
+    };
+public:
+    using TIter = RadixTreeIterator<
+        std::conditional_t<_isSet,constIterTraits,nonConstIterTraits>
+                                   >;
+    using constTIter = RadixTreeIterator<constIterTraits>;
+
+    TIter begin() noexcept { return TIter( this, _root ? minimum(_root) : nullptr ); }
+    TIter end() noexcept { return TIter( this, nullptr ); }
+    constTIter begin() const noexcept { return constTIter( this, _root ? minimum(_root) : nullptr ); }
+    constTIter end() const noexcept { return constTIter( this, nullptr ); }
+public:
+    RadixTree() : _root( nullptr ), _size( 0 ) {}
+
+    RadixTree( const RadixTree& other ) = delete;
+    RadixTree& operator=( const RadixTree& other ) = delete;
+
+    RadixTree( RadixTree&& other ) noexcept : _root( other._root ), _size( other._size ) {
+        other._root = nullptr;
+        other._size = 0;
+    }
+    RadixTree& operator=( RadixTree&& other ) noexcept {
+        if (this != &other) {
+            destroy(_root);
+            _root = other._root;
+            _size = other._size;
+            other._root = nullptr;
+            other._size = 0;
+        }
+        return *this;
+    }
+
+    ~RadixTree() { destroy(_root); }
+public:
+    template <bool isSet = _isSet> requires(!isSet)
+    V& get( const K& key ) {
+        auto leaf = findLeaf(key);
+        if (!leaf) { throw Exception( Exception::ErrorCode::ABSENT_KEY ); }
+        return leaf->_content.second();
+    }
+    const V& get( const K& key ) const {
+        auto leaf = findLeaf(key);
+        if (!leaf) { throw Exception( Exception::ErrorCode::ABSENT_KEY ); }
+        if constexpr(_isSet) { return leaf->_content; }
+        else { return leaf->_content.second(); }
+    }
+
+    TIter find( const K& key ) { return TIter( this, findLeaf(key) ); }
+    constTIter find( const K& key ) const { return constTIter( this, findLeaf(key) ); }
+
+    // first key greater than the given one, found in one descent like a lookup
+    TIter upperBound( const K& key ) { return TIter( this, upperLeaf(key) ); }
+    constTIter upperBound( const K& key ) const { return constTIter( this, upperLeaf(key) ); }
+
+    template <bool isSet = _isSet> requires(isSet)
+    RadixTree& insert( const V& value ) {
+        return insertContent( value, value );
+    }
+    RadixTree& insert( const Pair<K,V>& pair ) {
+        if constexpr(_isSet) { return insertContent( pair.first(), pair.first() ); }
+        else { return insertContent( pair.first(), pair ); }
+    }
+
+    RadixTree& remove( const K& key ) {
+        auto leaf = findLeaf(key);
+        if (!leaf) {
+            throw Exception( Exception::ErrorCode::ABSENT_KEY );
+        }
+        auto node = leaf->_parent;
+        if (!node) {
+            _root = nullptr;
+        } else if (leaf->_byte == _terminal) {
+            node->_terminalLeaf = nullptr;
+        } else {
+            node = removeChild( slotOf(node), static_cast<unsigned char>(leaf->_byte) );
+        }
+        delete leaf;
+        _size--;
+        if (node) { collapse( slotOf(node) ); }
+        return *this;
+    }
+
+    bool contains( const K& key ) const {
+        return findLeaf(key) != nullptr;
+    }
+    bool isEmpty() const noexcept {
+        return _size == 0;
+    }
+    ssize_t getSize() const noexcept {
+        return _size;
+    }
+
+    // unused child slots of inner nodes count as slack
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        if (_root) { collectUsage( _root, usage ); }
+        return usage;
+    }
+private:
+    Leaf* findLeaf( const K& key ) const {
+        Node* node = _root;
+        size_t depth = 0;
+        while (node) {
+            if (node->isLeaf()) {
+                auto leaf = static_cast<Leaf*>(node);
+                return (leaf->key() == key) ? leaf : nullptr;
+            }
+            auto inner = static_cast<Inner*>(node);
+            auto& prefix = inner->_prefix;
+            if (key.size() < depth + prefix.size() || key.compare( depth, prefix.size(), prefix ) != 0) {
+                return nullptr;
+            }
+            depth += prefix.size();
+            if (depth == key.size()) { return inner->_terminalLeaf; }
+
+            auto slot = childSlot( inner, static_cast<unsigned char>(key[depth]) );
+            if (!slot) { return nullptr; }
+            node = *slot;
+            depth++;
+        }
+        return nullptr;
+    }
+
+    // descends as findLeaf does; where the key leaves the tree, the keys below the node it
+    // reached are all greater or all less than it
+    Leaf* upperLeaf( const K& key ) const {
+        Node* node = _root;
+        size_t depth = 0;
+        while (node) {
+            if (node->isLeaf()) {
+                auto leaf = static_cast<Leaf*>(node);
+                return (key < leaf->key()) ? leaf : successor(leaf);
+            }
+            auto inner = static_cast<Inner*>(node);
+            auto order = key.compare( depth, inner->_prefix.size(), inner->_prefix );
+            if (order < 0) { return minimum(inner); }
+            if (order > 0) { return successor(inner); }
+            depth += inner->_prefix.size();
+
+            int byte = _terminal; // a key ending here is the terminal leaf, the children follow it
+            if (depth < key.size()) {
+                byte = static_cast<unsigned char>(key[depth]);
+                if (auto slot = childSlot( inner, static_cast<unsigned char>(byte) )) {
+                    node = *slot;
+                    depth++;
+                    continue;
+                }
+            }
+            int childByte;
+            auto child = childAfter( inner, byte, childByte );
+            return child ? minimum(child) : successor(inner);
+        }
+        return nullptr;
+    }
+
+    RadixTree& insertContent( const K& key, const TKeys& content ) {
+        Node** ref = &_root;
+        size_t depth = 0;
+        while (*ref) {
+            if ((*ref)->isLeaf()) {
+                if (static_cast<Leaf*>(*ref)->key() == key) {
+                    throw Exception( Exception::ErrorCode::KEY_COLLISION );
+                }
+                splitLeaf( *ref, depth, new Leaf( content ) );
+                _size++;
+                return *this;
+            }
+            auto inner = static_cast<Inner*>(*ref);
+            auto matched = matchPrefix( inner, key, depth );
+            if (matched < inner->_prefix.size()) {
+                splitPrefix( *ref, matched, depth, new Leaf( content ) );
+                _size++;
+                return *this;
+            }
+            depth += matched;
+            if (depth == key.size()) {
+                if (inner->_terminalLeaf) {
+                    throw Exception( Exception::ErrorCode::KEY_COLLISION );
+                }
+                attach( inner, new Leaf( content ), depth );
+                _size++;
+                return *this;
+            }
+            auto byte = static_cast<unsigned char>(key[depth]);
+            auto slot = childSlot( inner, byte );
+            if (!slot) {
+                addChild( *ref, byte, new Leaf( content ) );
+                _size++;
+                return *this;
+            }
+            ref = slot;
+            depth++;
+        }
+        _root = new Leaf( content );
+        _size++;
+        return *this;
+    }
+
+    // two different keys met at a leaf: a node4 with their common bytes as prefix holds both
+    static void splitLeaf( Node*& ref, size_t depth, Leaf* leaf ) {
+        auto old = static_cast<Leaf*>(ref);
+        auto& key = leaf->key();
+        auto& oldKey = old->key();
+        size_t common = 0;
+        while (depth + common < key.size() && depth + common < oldKey.size()
+            && key[depth + common] == oldKey[depth + common]) {
+            common++;
+        }
+        auto node = new Node4();
+        node->_prefix = key.substr( depth, common );
+        node->_parent = old->_parent;
+        node->_byte = old->_byte;
+        ref = node;
+
+        attach( node, old, depth + common );
+        attach( node, leaf, depth + common );
+    }
+
+    // the key leaves the prefix after matched bytes: a node4 takes over the matched part
+    static void splitPrefix( Node*& ref, const size_t matched, const size_t depth, Leaf* leaf ) {
+        auto inner = static_cast<Inner*>(ref);
+        auto node = new Node4();
+        node->_prefix = inner->_prefix.substr( 0, matched );
+        node->_parent = inner->_parent;
+        node->_byte = inner->_byte;
+        ref = node;
+
+        auto byte = static_cast<unsigned char>(inner->_prefix[matched]);
+        inner->_prefix.erase( 0, matched + 1 );
+        place( node, byte, inner );
+        attach( node, leaf, depth + matched );
+    }
+
+    // hangs a leaf whose key continues at depth under a node with free room
+    static void attach( Inner* node, Leaf* leaf, const size_t depth ) {
+        auto& key = leaf->key();
+        if (depth == key.size()) {
+            node->_terminalLeaf = leaf;
+            leaf->_parent = node;
+            leaf->_byte = _terminal;
+        } else {
+            place( node, static_cast<unsigned char>(key[depth]), leaf );
+        }
+    }
+
+    static size_t matchPrefix( const Inner* node, const K& key, const size_t depth ) noexcept {
+        size_t matched = 0;
+        auto& prefix = node->_prefix;
+        while (matched < prefix.size() && depth + matched < key.size() && prefix[matched] == key[depth + matched]) {
+            matched++;
+        }
+        return matched;
+    }
+
+    // slot holding the child for the byte, nullptr if there is none
+    static Node** childSlot( Inner* node, const unsigned char byte ) noexcept {
+        switch (node->_kind) {
+            case Kind::node4: {
+                auto n = static_cast<Node4*>(node);
+                for (size_t i = 0; i < n->_count; i++) {
+                    if (n->_keys[i] == byte) { return &n->_children[i]; }
+                }
+                return nullptr;
+            }
+            case Kind::node16: {
+                auto n = static_cast<Node16*>(node);
+                auto i = search16( n, byte );
+                return (i < n->_count) ? &n->_children[i] : nullptr;
+            }
+            case Kind::node48: {
+                auto n = static_cast<Node48*>(node);
+                return n->_index[byte] ? &n->_children[n->_index[byte] - 1] : nullptr;
+            }
+            default: {
+                auto n = static_cast<Node256*>(node);
+                return n->_children[byte] ? &n->_children[byte] : nullptr;
+            }
+        }
+    }
+
+    static size_t search16( const Node16* node, const unsigned char byte ) noexcept {
+      #if defined(__SSE2__)
+        auto keys = _mm_load_si128( reinterpret_cast<const __m128i*>(node->_keys) );
+        auto eq = _mm_cmpeq_epi8( keys, _mm_set1_epi8( static_cast<char>(byte) ) );
+        auto mask = static_cast<unsigned>( _mm_movemask_epi8(eq) ) & ((1u << node->_count) - 1);
+        return mask ? static_cast<size_t>( std::countr_zero(mask) ) : Node16::capacity;
+      #else
+        for (size_t i = 0; i < node->_count; i++) {
+            if (node->_keys[i] == byte) { return i; }
+        }
+        return Node16::capacity;
+      #endif
+    }
+
+    Node*& slotOf( Inner* node ) noexcept {
+        return node->_parent ? *childSlot( node->_parent, static_cast<unsigned char>(node->_byte) ) : _root;
+    }
+
+    static bool isFull( const Inner* node ) noexcept {
+        switch (node->_kind) {
+            case Kind::node4:  return node->_count == Node4::capacity;
+            case Kind::node16: return node->_count == Node16::capacity;
+            case Kind::node48: return node->_count == Node48::capacity;
+            default: return false;
+        }
+    }
+
+    // adds a child to the node at ref, growing it into the next size if it is full
+    static void addChild( Node*& ref, const unsigned char byte, Node* child ) {
+        auto node = static_cast<Inner*>(ref);
+        if (isFull(node)) {
+            node = resize( ref, static_cast<Kind>( static_cast<unsigned char>(node->_kind) + 1 ) );
+        }
+        place( node, byte, child );
+    }
+
+    // adds a child to a node with free room
+    static void place( Inner* node, const unsigned char byte, Node* child ) noexcept {
+        child->_parent = node;
+        child->_byte = byte;
+        switch (node->_kind) {
+            case Kind::node4: {
+                auto n = static_cast<Node4*>(node);
+                insertSorted( n->_keys, n->_children, n->_count, byte, child );
+                break;
+            }
+            case Kind::node16: {
+                auto n = static_cast<Node16*>(node);
+                insertSorted( n->_keys, n->_children, n->_count, byte, child );
+                break;
+            }
+            case Kind::node48: {
+                auto n = static_cast<Node48*>(node);
+                size_t slot = 0;
+                while (n->_children[slot]) { slot++; }
+                n->_children[slot] = child;
+                n->_index[byte] = static_cast<unsigned char>(slot + 1);
+                break;
+            }
+            default:
+                static_cast<Node256*>(node)->_children[byte] = child;
+        }
+        node->_count++;
+    }
+
+    static void insertSorted( unsigned char* keys, Node** children, size_t count, const unsigned char byte, Node* child ) noexcept {
+        while (count > 0 && keys[count - 1] > byte) {
+            keys[count] = keys[count - 1];
+            children[count] = children[count - 1];
+            count--;
+        }
+        keys[count] = byte;
+        children[count] = child;
+    }
+
+    static void eraseSorted( unsigned char* keys, Node** children, const size_t count, const unsigned char byte ) noexcept {
+        size_t index = 0;
+        while (keys[index] != byte) { index++; }
+        for (; index + 1 < count; index++) {
+            keys[index] = keys[index + 1];
+            children[index] = children[index + 1];
+        }
+        children[count - 1] = nullptr;
+    }
+
+    // drops the child for the byte, shrinking the node when it gets sparse. returns the node now at ref
+    static Inner* removeChild( Node*& ref, const unsigned char byte ) {
+        auto node = static_cast<Inner*>(ref);
+        switch (node->_kind) {
+            case Kind::node4: {
+                auto n = static_cast<Node4*>(node);
+                eraseSorted( n->_keys, n->_children, n->_count, byte );
+                break;
+            }
+            case Kind::node16: {
+                auto n = static_cast<Node16*>(node);
+                eraseSorted( n->_keys, n->_children, n->_count, byte );
+                break;
+            }
+            case Kind::node48: {
+                auto n = static_cast<Node48*>(node);
+                n->_children[n->_index[byte] - 1] = nullptr;
+                n->_index[byte] = 0;
+                break;
+            }
+            default:
+                static_cast<Node256*>(node)->_children[byte] = nullptr;
+        }
+        node->_count--;
+
+        // shrink thresholds sit below the grow ones, so a node does not flip on every insert/remove
+        if (node->_kind == Kind::node16 && node->_count <= 3)  { return resize( ref, Kind::node4 ); }
+        if (node->_kind == Kind::node48 && node->_count <= 12) { return resize( ref, Kind::node16 ); }
+        if (node->_kind == Kind::node256 && node->_count <= 37) { return resize( ref, Kind::node48 ); }
+        return node;
+    }
+
+    // an inner node left with a single entry is replaced by it, a child node inherits the prefix
+    static void collapse( Node*& ref ) {
+        auto node = static_cast<Inner*>(ref);
+        if (node->_count + (node->_terminalLeaf ? 1 : 0) != 1) { return; }
+
+        Node* only = node->_terminalLeaf;
+        if (!only) {
+            int byte = 0;
+            only = childAfter( node, _terminal, byte );
+            if (!only->isLeaf()) {
+                auto inner = static_cast<Inner*>(only);
+                inner->_prefix = node->_prefix + static_cast<char>(byte) + inner->_prefix;
+            }
+        }
+        only->_parent = node->_parent;
+        only->_byte = node->_byte;
+        ref = only;
+        destroyShallow(node);
+    }
+
+    static Inner* makeInner( const Kind kind ) {
+        switch (kind) {
+            case Kind::node4:  return new Node4();
+            case Kind::node16: return new Node16();
+            case Kind::node48: return new Node48();
+            default: return new Node256();
+        }
+    }
+
+    // moves the node at ref into a node of another size
+    static Inner* resize( Node*& ref, const Kind kind ) {
+        auto old = static_cast<Inner*>(ref);
+        auto node = makeInner(kind);
+        node->_prefix = std::move( old->_prefix );
+        node->_parent = old->_parent;
+        node->_byte = old->_byte;
+        node->_terminalLeaf = old->_terminalLeaf;
+        if (node->_terminalLeaf) { node->_terminalLeaf->_parent = node; }
+        forEachChild( old, [node]( const unsigned char byte, Node* child ) { place( node, byte, child ); } );
+
+        ref = node;
+        destroyShallow(old);
+        return node;
+    }
+
+    // calls func( byte, child ) for every child in byte order
+    template <typename TFunc>
+    static void forEachChild( const Inner* node, const TFunc& func ) {
+        switch (node->_kind) {
+            case Kind::node4: {
+                auto n = static_cast<const Node4*>(node);
+                for (size_t i = 0; i < n->_count; i++) { func( n->_keys[i], n->_children[i] ); }
+                break;
+            }
+            case Kind::node16: {
+                auto n = static_cast<const Node16*>(node);
+                for (size_t i = 0; i < n->_count; i++) { func( n->_keys[i], n->_children[i] ); }
+                break;
+            }
+            case Kind::node48: {
+                auto n = static_cast<const Node48*>(node);
+                for (size_t byte = 0; byte < 256; byte++) {
+                    if (n->_index[byte]) { func( static_cast<unsigned char>(byte), n->_children[n->_index[byte] - 1] ); }
+                }
+                break;
+            }
+            default: {
+                auto n = static_cast<const Node256*>(node);
+                for (size_t byte = 0; byte < 256; byte++) {
+                    if (n->_children[byte]) { func( static_cast<unsigned char>(byte), n->_children[byte] ); }
+                }
+            }
+        }
+    }
+
+    // first child with a byte greater than after, nullptr if there is none
+    static Node* childAfter( const Inner* node, const int after, int& byte ) noexcept {
+        switch (node->_kind) {
+            case Kind::node4: {
+                auto n = static_cast<const Node4*>(node);
+                for (size_t i = 0; i < n->_count; i++) {
+                    if (n->_keys[i] > after) { byte = n->_keys[i]; return n->_children[i]; }
+                }
+                return nullptr;
+            }
+            case Kind::node16: {
+                auto n = static_cast<const Node16*>(node);
+                for (size_t i = 0; i < n->_count; i++) {
+                    if (n->_keys[i] > after) { byte = n->_keys[i]; return n->_children[i]; }
+                }
+                return nullptr;
+            }
+            case Kind::node48: {
+                auto n = static_cast<const Node48*>(node);
+                for (int b = after + 1; b < 256; b++) {
+                    if (n->_index[b]) { byte = b; return n->_children[n->_index[b] - 1]; }
+                }
+                return nullptr;
+            }
+            default: {
+                auto n = static_cast<const Node256*>(node);
+                for (int b = after + 1; b < 256; b++) {
+                    if (n->_children[b]) { byte = b; return n->_children[b]; }
+                }
+                return nullptr;
+            }
+        }
+    }
+
+    // last child with a byte less than before, nullptr if there is none
+    static Node* childBefore( const Inner* node, const int before, int& byte ) noexcept {
+        switch (node->_kind) {
+            case Kind::node4: {
+                auto n = static_cast<const Node4*>(node);
+                for (size_t i = n->_count; i-- > 0;) {
+                    if (n->_keys[i] < before) { byte = n->_keys[i]; return n->_children[i]; }
+                }
+                return nullptr;
+            }
+            case Kind::node16: {
+                auto n = static_cast<const Node16*>(node);
+                for (size_t i = n->_count; i-- > 0;) {
+                    if (n->_keys[i] < before) { byte = n->_keys[i]; return n->_children[i]; }
+                }
+                return nullptr;
+            }
+            case Kind::node48: {
+                auto n = static_cast<const Node48*>(node);
+                for (int b = before - 1; b >= 0; b--) {
+                    if (n->_index[b]) { byte = b; return n->_children[n->_index[b] - 1]; }
+                }
+                return nullptr;
+            }
+            default: {
+                auto n = static_cast<const Node256*>(node);
+                for (int b = before - 1; b >= 0; b--) {
+                    if (n->_children[b]) { byte = b; return n->_children[b]; }
+                }
+                return nullptr;
+            }
+        }
+    }
+
+    static Leaf* minimum( Node* node ) noexcept {
+        int byte;
+        while (!node->isLeaf()) {
+            auto inner = static_cast<Inner*>(node);
+            if (inner->_terminalLeaf) { return inner->_terminalLeaf; }
+            node = childAfter( inner, _terminal, byte );
+        }
+        return static_cast<Leaf*>(node);
+    }
+
+    static Leaf* maximum( Node* node ) noexcept {
+        int byte;
+        while (!node->isLeaf()) {
+            auto inner = static_cast<Inner*>(node);
+            auto child = childBefore( inner, 256, byte );
+            if (!child) { return inner->_terminalLeaf; }
+            node = child;
+        }
+        return static_cast<Leaf*>(node);
+    }
+
+    // first leaf after everything below the node
+    static Leaf* successor( const Node* node ) noexcept {
+        auto parent = node->_parent;
+        int byte = node->_byte;
+        while (parent) {
+            int childByte;
+            if (auto child = childAfter( parent, byte, childByte )) { return minimum(child); }
+            byte = parent->_byte;
+            parent = parent->_parent;
+        }
+        return nullptr;
+    }
+
+    static Leaf* predecessor( const Leaf* leaf ) noexcept {
+        auto parent = leaf->_parent;
+        int byte = leaf->_byte;
+        while (parent) {
+            if (byte != _terminal) {
+                int childByte;
+                if (auto child = childBefore( parent, byte, childByte )) { return maximum(child); }
+                if (parent->_terminalLeaf) { return parent->_terminalLeaf; }
+            }
+            byte = parent->_byte;
+            parent = parent->_parent;
+        }
+        return nullptr;
+    }
+
+    static void destroyShallow( Inner* node ) noexcept {
+        switch (node->_kind) {
+            case Kind::node4:  delete static_cast<Node4*>(node); break;
+            case Kind::node16: delete static_cast<Node16*>(node); break;
+            case Kind::node48: delete static_cast<Node48*>(node); break;
+            default: delete static_cast<Node256*>(node);
+        }
+    }
+
+    static void destroy( Node* node ) noexcept {
+        if (!node) { return; }
+        if (node->isLeaf()) {
+            delete static_cast<Leaf*>(node);
+            return;
+        }
+        auto inner = static_cast<Inner*>(node);
+        forEachChild( inner, []( const unsigned char, Node* child ) { destroy(child); } );
+        delete inner->_terminalLeaf;
+        destroyShallow(inner);
+    }
+
+    static void collectUsage( const Node* node, MemoryUsage& usage ) {
+        if (node->isLeaf()) {
+            auto leaf = static_cast<const Leaf*>(node);
+            usage.nodes += sizeof(Leaf) - sizeof(TKeys);
+            usage.payload += sizeof(TKeys) + ownedBytes( leaf->_content );
+            return;
+        }
+        auto inner = static_cast<const Inner*>(node);
+        size_t bytes, slots;
+        switch (inner->_kind) {
+            case Kind::node4:  bytes = sizeof(Node4);  slots = Node4::capacity;  break;
+            case Kind::node16: bytes = sizeof(Node16); slots = Node16::capacity; break;
+            case Kind::node48: bytes = sizeof(Node48); slots = Node48::capacity; break;
+            default: bytes = sizeof(Node256); slots = Node256::capacity;
+        }
+        auto unused = (slots - inner->_count) * sizeof(Node*);
+        usage.nodes += bytes - unused + ownedBytes( inner->_prefix );
+        usage.slack += unused;
+
+        if (inner->_terminalLeaf) { collectUsage( inner->_terminalLeaf, usage ); }
+        forEachChild( inner, [&usage]( const unsigned char, const Node* child ) { collectUsage( child, usage ); } );
+    }
+private:
+    Node* _root;
+    ssize_t _size;
+};
+
+#endif // RADIX_TREE_H
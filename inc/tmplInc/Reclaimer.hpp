@@ -0,0 +1,77 @@
+#ifndef RECLAIMER_H
+#define RECLAIMER_H
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include "ArraySequence.hpp"
+
+// deletes backing files on one long-lived background thread. callers only queue paths and
+// return, so removing a large subtree never waits for the deletions of an earlier one. the
+// worker starts with the first batch; the destructor lets it finish the queue
+class Reclaimer
+{
+public:
+    Reclaimer() : _busy( false ), _stopping( false ) {}
+
+    Reclaimer( const Reclaimer& other ) = delete;
+    Reclaimer& operator=( const Reclaimer& other ) = delete;
+
+    ~Reclaimer() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        if (_worker.joinable()) { _worker.join(); }
+    }
+public:
+    void remove( ArraySequence<std::filesystem::path>&& paths ) {
+        if (paths.isEmpty()) { return; }
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t i = 0; i < paths.getSize(); i++) { _queue.push_back( std::move(paths[i]) ); }
+        if (!_worker.joinable()) { _worker = std::thread( &Reclaimer::work, this ); }
+        _wake.notify_all();
+    }
+
+    // blocks until every path queued so far is deleted
+    void wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle.wait( lock, [this]() { return _queue.empty() && !_busy; } );
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _queue.size();
+    }
+private:
+    void work() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _wake.wait( lock, [this]() { return _stopping || !_queue.empty(); } );
+            if (_queue.empty()) { return; } // stopping with nothing left
+
+            std::deque<std::filesystem::path> batch;
+            batch.swap(_queue);
+            _busy = true;
+            lock.unlock();
+            std::error_code ec; // a file that is already gone is not an error
+            for (auto& path : batch) { std::filesystem::remove( path, ec ); }
+            lock.lock();
+            _busy = false;
+            if (_queue.empty()) { _idle.notify_all(); }
+        }
+    }
+private:
+    mutable std::mutex _mutex;                   // guards everything below
+    std::condition_variable _wake;               // paths were queued or the reclaimer stops
+    std::condition_variable _idle;               // the queue ran empty
+    std::deque<std::filesystem::path> _queue;
+    bool _busy;                                  // the worker deletes a batch taken off the queue
+    bool _stopping;
+    std::thread _worker;                         // started with the first batch
+};
+
+#endif // RECLAIMER_H
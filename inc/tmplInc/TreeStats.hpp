@@ -0,0 +1,56 @@
+#ifndef TREE_STATS_H
+#define TREE_STATS_H
+
+#include <array>
+#include <cstddef>
+#include "ArraySequence.hpp"
+
+// statistics are opt-in: build with TREE_STATS defined to enable them.
+// otherwise the hooks expand to nothing and trees expose neither counters() nor shape()
+#ifdef TREE_STATS
+  #define TREE_STAT( statement ) statement
+#else
+  #define TREE_STAT( statement )
+#endif
+
+struct TreeCounters
+{
+    size_t operations = 0;
+    size_t splits = 0;
+    size_t rootSplits = 0;
+    size_t merges = 0;
+    size_t leftRotations = 0;
+    size_t rightRotations = 0;
+    size_t comparisons = 0;
+    size_t visits = 0;
+
+    double comparisonsPerOperation() const noexcept {
+        return (operations == 0) ? 0.0 : static_cast<double>(comparisons) / operations;
+    }
+    double visitsPerOperation() const noexcept {
+        return (operations == 0) ? 0.0 : static_cast<double>(visits) / operations;
+    }
+    void reset() noexcept { *this = TreeCounters(); }
+};
+
+struct TreeShape
+{
+    static const size_t fillBuckets = 10;
+
+    size_t height = 0;
+    size_t nodes = 0;
+    ArraySequence<size_t> levelNodes;                 // node count per level, root first
+    std::array<size_t,fillBuckets> fillHistogram{};   // nodes by keys / maxKeys, in tenths
+
+    void account( const size_t level, const size_t keys, const size_t maxKeys ) {
+        while (levelNodes.getSize() <= level) { levelNodes.append(0); }
+        levelNodes[level]++;
+        nodes++;
+        height = (level + 1 > height) ? level + 1 : height;
+
+        auto bucket = (maxKeys == 0) ? 0 : keys * fillBuckets / maxKeys;
+        fillHistogram[(bucket < fillBuckets) ? bucket : fillBuckets - 1]++;
+    }
+};
+
+#endif // TREE_STATS_H
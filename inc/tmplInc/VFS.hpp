@@ -2,17 +2,34 @@
 #define VFS_H
 
 #if defined(__unix__) || defined(__APPLE__) 
-  #include <unistd.h>
-  #include <sys/wait.h>
+  #include "Launcher.hpp"
 #elif defined(_WIN32)
   #include <windows.h>
   #include <shellapi.h>
 #endif
+#include <algorithm>
+#include <charconv>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "VFSNode.hpp"
 #include "VFSPath.hpp"
+#include "VFSImage.hpp"
+#include "VFSJournal.hpp"
+#include "ParallelWalk.hpp"
+#include "SlotMap.hpp"
+#include "DentryCache.hpp"
+#include "NameIndex.hpp"
+#include "BlobStore.hpp"
+#include "MappedFile.hpp"
+#include "MappingCache.hpp"
+#include "FileWriter.hpp"
+#include "Reclaimer.hpp"
+#include "Glob.hpp"
 
 namespace fs = std::filesystem;
 
@@ -23,15 +40,18 @@ private:
     using Node = VFSNode<TContainer>;
     using Path = VFSPath;
 public:
-    VFS() : _lastID(0), _tempCount(0) {
+    enum class FindType { any, file, dir };
+
+    VFS() : _tempCount(0) {
         _tempServiceDir = fs::current_path()/".temp";
         fs::create_directory(_tempServiceDir);
-        auto root = makeShared<Dir<TContainer>>( 1, 0, "/" );
+        auto root = makeIntrusive<Dir<TContainer>>( _data.nextKey(), 0, "/" );
         
         _currentDir = root;
         _rootDir    = root;
+        _currentPath = Path("/");
         
-        _data.add(++_lastID, root);
+        _data.insert( root );
     }
 
     VFS( const VFS& other ) = delete;
@@ -40,13 +60,14 @@ public:
     VFS( VFS&& other ) = delete;
     VFS& operator=( VFS&& other ) = delete;
 
-    ~VFS() = default;
+    ~VFS() = default; // the reclaimer finishes its queue
 public:
     void cd( const std::string& path ) {
         auto node = findByPath(path);
         if (!node->isDir()) {
             throw Exception( std::format( "Error. cd: {} is not a directory.", Path(path).string() ));
         } else {
+            _currentPath = absolute( Path(path) );
             _currentDir = node;
         }
     }
@@ -67,9 +88,11 @@ public:
                 if (node->contents().contains( name )) {
                     throw Exception( std::format("Error. {} already exists.", vpath.string()));
                 } else {
-                    auto dir = makeShared<Dir<TContainer>>( ++_lastID, node->id(), name );
-                    node->contents().add( Pair<std::string,NodeID>( name, _lastID ));
-                    _data.add( Pair<NodeID,SharedPtr<Node>>( _lastID, dir ) );
+                    auto id = _data.nextKey();
+                    auto dir = makeIntrusive<Dir<TContainer>>( id, node->id(), name );
+                    link( node, name, id );
+                    _data.insert( dir );
+                    record( VFSJournal::Op::mkdir, absolute(vpath).string() );
                 }
             }
         }        
@@ -79,6 +102,8 @@ public:
         auto npath = Path(path);
         if (exists(npath)) {
             throw Exception( std::format( "Error. {} already exists.", npath.string()));
+        } else if (_blobs) {
+            attach( path, _blobs->empty().string() ); // every empty file shares one blob
         } else {
             auto phys = fs::absolute(newTempPath()).lexically_normal();
             createTempFile(phys);
@@ -93,117 +118,69 @@ public:
         if (!fs::is_regular_file(physPath)) {
             throw Exception( std::format("Error. For attach {} must be a regular file.", vpath.string()));
         } else {
-            auto name = vpath.name();
-            auto extension = vpath.extension();
-
-            if (name.empty() || extension.empty()) {
-                throw Exception( Exception::ErrorCode::INVALID_INPUT );
-            } else {
-                auto location = vpath.location();
-                auto node = findByPath(location);
-
-                if (!node->isDir()) {
-                    throw Exception( std::format("Error. {} is not a directory.", node->name()));
-                } else {
-                    if (node->hasChild(name)) {
-                        throw Exception( std::format("Error. {} already exists.", vpath.string()));
-                    } else {
-                        auto file = makeShared<File<TContainer>>( ++_lastID, node->id(), name + extension, physPath );
-                        node->contents().add( Pair<std::string,NodeID>( name + extension, _lastID ));
-                        _data.add( Pair<NodeID,SharedPtr<Node>>( _lastID, file ) );
-                    }
-                }
-            }   
+            auto dir = fileLocation( vpath );
+            auto stored = _blobs ? _blobs->ingest(pPath) : fs::path(physPath);
+            addFile( dir, vpath.name() + vpath.extension(), stored );
+            record( VFSJournal::Op::attach, absolute(vpath).string(), stored.string() );
         }
     }
 
     void rmdir( const std::string& path ) {
-        auto node = findByPath(path);
-        auto vpath = Path(path);
-
-        if (!node->isDir()) {
-            throw Exception( std::format( "Error. {} is not a directory.", vpath.string() ) );
-        }
-        if (node->parent() == 0) {
-            throw Exception( std::format( "Error. {} is a root directory and cannot be deleted.", vpath.string() ) );
-        } else {
-            auto parent = _data.get( node->parent() );
-            auto& contents = node->contents();
-            for (auto it = contents.begin(); it != contents.end(); it++) {
-                _data.remove( *it );
-            }
-            parent->contents().remove( node->name() );
-            _data.remove( node->id() );
+        auto target = absolute( Path(path) ).string();
+        auto subtree = detachSubtree( Path(path) );
+        for (size_t i = 0; i < subtree._blobs.getSize(); i++) {
+            if (_blobs->release( subtree._blobs[i] )) { _mappings.forget( subtree._blobs[i].string() ); }
         }
+        reclaim( std::move(subtree._tempFiles) );
+        record( VFSJournal::Op::rmdir, target );
     }
 
     void remove( const std::string& path ) {
         auto vpath = Path(path);
-        auto node = findByPath(vpath);
-
-        if (node->isDir()) {
-            throw Exception( std::format( "Error. {} is a directory. Use rmdir instead.", vpath.string() ) );
+        auto node = detachFile(vpath);
+        _mappings.forget( node->path().string() );
+        if (isTempFile( node->path() )) {
+            ArraySequence<fs::path> paths;
+            paths.append( node->path() );
+            reclaim( std::move(paths) );
         } else {
-            auto parent = _data.get( node->parent() );
-            parent->contents().remove( node->name() );
-            _data.remove( node->id() );
+            releaseBlob( node->path() );
         }
+        record( VFSJournal::Op::remove, absolute(vpath).string() );
     }
 
     void move( const std::string& from, const std::string& to ) {
+        auto srcPath = Path(from);
         auto destPath = Path(to);
+        if (to.empty()) {
+            throw Exception( Exception::ErrorCode::INVALID_INPUT );
+        }
+        // resolved up front, relink may move the current directory
+        auto srcAbsolute = absolute(srcPath).string();
+        auto destAbsolute = absolute(destPath).string();
 
-        if (exists(destPath)) {
-            auto dest = findByPath(to);
-
-            if (!dest->isDir()) {
-                throw Exception( std::format("Error. Unable to move to {}: it is not a directory.", destPath.string()));
-            } else {
-                auto node = findByPath(from);
-
-                if (node->id() == dest->id()) {
-                    throw Exception( Exception::ErrorCode::CYCLIC_MOVE );
-                } else {
-                    if (node->parent() == 0) {
-                        throw Exception( std::format("Error. {} is a root directory.", Path(from).string()));
-                    } else {
-                        if (dest->contents().contains( node->name() ) ) {
-                            throw Exception( std::format("Error. {} already exists.", destPath.string()));
-                        } else {
-                            auto srcDir = _data.get( node->parent() );
-                            srcDir->contents().remove( node->name() );
-                            dest->contents().add( Pair<std::string,NodeID>( node->name(), node->id() ));
-                        }
-                    }
-                }
-            }
+        auto node = findByPath(srcPath);
+        if (node->parent() == 0) {
+            throw Exception( std::format("Error. {} is a root directory.", srcPath.string() ));
+        }
+        // a destination that exists, or only refers to a directory like / . and .., is moved into
+        IntrusivePtr<Node> destDir;
+        std::string title;
+        if (destPath.isEmpty() || isDirReference( destPath[destPath.getSize() - 1] ) || exists(destPath)) {
+            destDir = findByPath(destPath);
+            title = node->name();
         } else {
-            auto srcPath = Path(from);
-            auto node = findByPath(srcPath);
-            if (node->parent() == 0) {
-                throw Exception( std::format("Error. {} is a root directory.", Path(from).string() ));
-            } else {
-                auto destDir = findByPath( destPath.location() );
-                if (destDir->contents().contains( destPath.name() )) {
-                    throw Exception( std::format( "Error. {} already exists.", destPath.string()));
-                } else {
-                    auto srcDir = findByPath(srcPath);
-                    if (node->isDir()) {
-                        auto contents = std::move(node->contents());
-                        auto node1 = makeShared<Dir<TContainer>>( node->id(), node->parent(), destPath.name(), contents );
-                        srcDir->contents().remove( node->name() );
-                        destDir->contents().add( Pair<std::string,NodeID>( destPath.name(), node->id()));
-                        _data.get(node->id()) = node1;
-                    } else {
-                        auto physPath = node->path();
-                        auto node1 = makeShared<File<TContainer>>( node->id(), node->parent(), destPath.name(), physPath );
-                        srcDir->contents().remove( node->name() );
-                        destDir->contents().add( Pair<std::string,NodeID>( destPath.name(), node->id()));
-                        _data.get(node->id()) = node1;
-                    }
-                }
+            destDir = findByPath( destPath.location() );
+            title = destPath[destPath.getSize() - 1]; // name() would drop the extension
+        }
 
-            }
+        if (!destDir->isDir()) {
+            throw Exception( std::format("Error. Unable to move to {}: it is not a directory.", destPath.string()));
+        } else if (isAncestorOrSelf( node, destDir )) {
+            throw Exception( Exception::ErrorCode::CYCLIC_MOVE );
+        } else {
+            relink( node, srcPath, destDir, title );
+            record( VFSJournal::Op::move, srcAbsolute, destAbsolute );
         }
     }
 
@@ -214,19 +191,272 @@ public:
         if (node->isDir()) {
             cd( path );
         } else {
+            if (_blobs && _blobs->owns( node->path() )) { // the program may change it, a blob is shared
+                auto copy = fs::absolute(newTempPath()).lexically_normal();
+                fs::copy_file( node->path(), copy );
+                repoint( node, copy );
+            }
             if (!tryOpen( *node )) {
                 throw Exception( Exception::ErrorCode::UNKNOWN_ERROR );
             }
         }
     }
 
-    void ls() {
-        
+    // the contents of a file as a read-only mapping instead of a copy. mappings stay in an LRU
+    // cache (see MappingCache.hpp), so reading the same files again costs no open, read or
+    // close; a backing file changed on disk is mapped again. access is a read-ahead hint.
+    // the view keeps its contents when the file is removed or written through the VFS; an
+    // attached file edited in place by another program shows the edits, or faults past the end
+    // it was truncated to (see FileView)
+    FileView read( const std::string& path, const MappedFile::Access access = MappedFile::Access::sequential ) const {
+        auto node = findByPath(path);
+        if (node->isDir()) {
+            throw Exception( std::format( "Error. {} is a directory.", Path(path).string() ));
+        }
+        auto& phys = node->path();
+        return _mappings.get( phys.string(), access, _blobs && _blobs->owns(phys) ); // blobs never change
+    }
+
+    // a buffered writer of the contents of a file, which is created when missing (see
+    // FileWriter.hpp). the new contents show once the writer is closed; views read before keep
+    // the old ones. a file stored as a blob gets a private copy first, a blob is shared
+    FileWriter writer( const std::string& path, const bool append = false, const WritePolicy& policy = WritePolicy() ) {
+        if (!exists( Path(path) )) { touch(path); }
+        auto node = findByPath(path);
+        if (node->isDir()) {
+            throw Exception( std::format( "Error. {} is a directory.", Path(path).string() ));
+        }
+        auto phys = node->path();
+        _mappings.forget( phys.string() );
+        if (_blobs && _blobs->owns(phys)) {
+            auto copy = fs::absolute(newTempPath()).lexically_normal();
+            if (append) { fs::copy_file( phys, copy ); } else { createTempFile(copy); }
+            repoint( node, copy );
+            return FileWriter( copy.string(), FileWriter::Mode::append, policy );
+        }
+        return FileWriter( phys.string(), append ? FileWriter::Mode::append : FileWriter::Mode::replace, policy );
+    }
+
+    // a one-shot write stages no more than its data
+    void write( const std::string& path, std::string_view data, const WritePolicy& policy = WritePolicy() ) {
+        auto out = writer( path, false, sizedFor( policy, data.size() ));
+        out.write(data);
+        out.close();
+    }
+
+    void append( const std::string& path, std::string_view data, const WritePolicy& policy = WritePolicy() ) {
+        auto out = writer( path, true, sizedFor( policy, data.size() ));
+        out.write(data);
+        out.close();
+    }
+
+    // messages of the viewers started by open() that failed since the last call
+    ArraySequence<std::string> openFailures() {
+      #if defined(__unix__) || defined(__APPLE__)
+        return _launcher.failures();
+      #else
+        return ArraySequence<std::string>();
+      #endif
+    }
+
+    // streams a directory (the current one for an empty path) in the order of its container,
+    // sorted by name for the trees, one entry per line with directories marked by a trailing /.
+    // at most limit entries after the name after are written through a fixed buffer, so memory
+    // does not grow with the directory. returns the after of the next page, empty at the end.
+    // pages need a container kept in key order, a HashMap directory is listed whole only
+    std::string ls( std::ostream& out, const std::string& path = ""
+                  , const size_t limit = SIZE_MAX, const std::string& after = "" ) const {
+        auto dir = path.empty() ? _currentDir : findByPath(path);
+        if (!dir->isDir()) {
+            throw Exception( std::format( "Error. {} is not a directory.", Path(path).string() ));
+        }
+        constexpr size_t bufferSize = 1 << 16;
+        std::string buffer;
+        buffer.reserve( bufferSize );
+
+        auto& contents = dir->contents();
+        auto it = contents.begin();
+        if constexpr (std::remove_reference_t<decltype(contents)>::seekable) {
+            if (!after.empty()) { it = contents.upperBound(after); }
+        } else if (limit != SIZE_MAX || !after.empty()) { // a name is no position in hash order
+            throw Exception( "Error. Paging needs directories kept in key order." );
+        }
+        size_t count = 0;
+        const std::string* last = nullptr;
+        for (; it != contents.end() && count < limit; ++it, count++) {
+            last = &it.key();
+            buffer += *last;
+            if (_data.get(*it)->isDir()) { buffer += '/'; }
+            buffer += '\n';
+            if (buffer.size() >= bufferSize - 256) {
+                out.write( buffer.data(), buffer.size() );
+                buffer.clear();
+            }
+        }
+        out.write( buffer.data(), buffer.size() );
+
+        return (it == contents.end() || !last) ? std::string() : *last;
+    }
+
+    // writes the absolute path of every node below root, root included, whose name matches the
+    // glob pattern (see Glob.hpp) and returns their count. subtrees are spread over threads
+    // (0 for one per core) that steal work from each other, so lines come in no fixed order.
+    // the caller is blocked meanwhile and the workers only read nodes, never the dentry cache,
+    // so the walk sees the namespace as it was when find was called
+    size_t find( std::ostream& out, const std::string& root, const std::string& pattern
+               , const FindType type = FindType::any, size_t threads = 0 ) const {
+        auto start = findByPath(root);
+        auto startPath = absolutePathOf(start);
+        if (threads == 0) { threads = std::max( 1u, std::thread::hardware_concurrency() ); }
+
+        auto wanted = [&pattern, type]( const Node& node, const std::string& name ) {
+            return (type == FindType::any || (type == FindType::dir) == node.isDir())
+                && globMatch( pattern, name );
+        };
+        constexpr size_t bufferSize = 1 << 16;
+        std::vector<std::string> buffers( threads );
+        std::vector<size_t> counts( threads, 0 );
+        std::mutex outMutex;
+        auto emit = [&]( const size_t worker, const std::string& path, const bool force ) {
+            auto& buffer = buffers[worker];
+            if (!path.empty()) {
+                buffer += path;
+                buffer += '\n';
+                counts[worker]++;
+            }
+            if (force || buffer.size() >= bufferSize) {
+                std::lock_guard<std::mutex> lock(outMutex);
+                out.write( buffer.data(), buffer.size() );
+                buffer.clear();
+            }
+        };
+
+        if (wanted( *start, start->name() )) { emit( 0, startPath, false ); }
+        if (start->isDir()) {
+            parallelWalk( FindTask{ start.get(), startPath }, threads
+                        , [&]( const FindTask& task, auto& spawn, const size_t worker ) {
+                auto& contents = task._dir->contents();
+                auto prefix = (task._path == "/") ? task._path : task._path + "/";
+                for (auto it = contents.begin(); it != contents.end(); ++it) {
+                    auto& child = _data.get(*it);
+                    bool match = wanted( *child, it.key() );
+                    if (!match && !child->isDir()) { continue; } // most leaves never need a path
+
+                    auto path = prefix + it.key();
+                    if (match) { emit( worker, path, false ); }
+                    if (child->isDir()) { spawn( FindTask{ child.get(), std::move(path) } ); }
+                }
+            });
+        }
+        size_t total = 0;
+        for (size_t worker = 0; worker < threads; worker++) {
+            emit( worker, "", true );
+            total += counts[worker];
+        }
+        return total;
+    }
+
+    // writes the absolute paths of the entries called name, or of those with the extension name
+    // when byExtension is set, and returns their count. the lookups go to the name index, which
+    // the first call builds in one pass over the namespace and every mutation keeps current
+    size_t locate( std::ostream& out, const std::string& name, const bool byExtension = false ) {
+        indexNames();
+        auto ids = byExtension ? _names->byExtension(name) : _names->byName(name);
+        std::string buffer;
+        for (size_t i = 0; i < ids.getSize(); i++) {
+            buffer += absolutePathOf( _data.get( ids[i] ));
+            buffer += '\n';
+        }
+        out.write( buffer.data(), buffer.size() );
+        return ids.getSize();
+    }
+
+    // from now on attach and touch store content in a deduplicating blob store under the
+    // service directory (see BlobStore.hpp); files attached before keep their backing files
+    void useBlobStore() {
+        if (_blobs) { return; }
+        _blobs = std::make_unique<BlobStore>( _tempServiceDir/"blobs" );
+        countBlobRefs();
+    }
+
+    void indexNames() {
+        if (_names) { return; }
+        ArraySequence<Pair<std::string,NodeID>> entries( _data.getSize() );
+        for (auto it = _data.begin(); it != _data.end(); ++it) {
+            if ((*it)->parent() != 0) { entries.append( Pair<std::string,NodeID>( (*it)->name(), (*it)->id() )); }
+        }
+        auto names = std::make_unique<NameIndex>();
+        names->assign( entries );
+        _names = std::move(names);
+    }
+
+    void save( const std::string& imagePath ) const {
+        writeImage( imagePath );
+    }
+
+    // a journaled namespace is compacted right away, so its journal follows the new contents
+    void load( const std::string& imagePath ) {
+        readImage( imagePath );
+        if (_journal) { compact(); }
+    }
+
+    // makes the namespace durable at imagePath: the image and the mutations journaled after it
+    // are loaded, then every mutation is appended to imagePath.journal (see VFSJournal.hpp)
+    void persist( const std::string& imagePath, const JournalPolicy& policy = JournalPolicy() ) {
+        _journal.reset();
+        _skippedRecords = 0;
+        std::uint64_t base = fs::exists(imagePath) ? readImage( imagePath ) : 0;
+        auto journalPath = imagePath + ".journal";
+        auto length = VFSJournal::replay( journalPath, base, [this]( const VFSJournal::Record& record ) {
+            replay(record);
+        });
+        if (_blobs) { countBlobRefs(); } // replay adds and drops blob files without counting
+        _imagePath = imagePath;
+        _journal = std::make_unique<VFSJournal>( journalPath, base, length, policy );
+    }
+
+    // journal records the last persist() could not apply, none for a consistent journal
+    size_t skippedRecords() const noexcept {
+        return _skippedRecords;
+    }
+
+    // folds the journal into a fresh image, which bounds the work of the next replay
+    void compact() {
+        if (!_journal) {
+            throw Exception( "Error. The namespace is not persistent." );
+        }
+        _journal->reset( writeImage( _imagePath ));
+    }
+
+    // waits until every journaled mutation is on disk
+    void sync() {
+        if (_journal) { _journal->sync(); }
     }
 
     std::string getCD() {
         return _currentDir->name();
     }
+
+    std::string getCWD() const {
+        return _currentPath.string();
+    }
+
+    // nodes of the id index and the dentry cache plus every file and directory with its contents
+    MemoryUsage memoryUsage() const {
+        auto usage = _data.memoryUsage();
+        usage += _dentries.memoryUsage();
+        usage += _mappings.memoryUsage();
+        if (_names) { usage += _names->memoryUsage(); }
+        if (_blobs) { usage += _blobs->memoryUsage(); }
+        for (auto it = _data.begin(); it != _data.end(); ++it) {
+            usage += (*it)->memoryUsage();
+        }
+        return usage;
+    }
+
+    ssize_t nodeCount() const {
+        return _data.getSize();
+    }
 private:
   #ifdef _WIN32
     bool tryOpen( const Node& node ) {
@@ -247,93 +477,51 @@ private:
         } else return true;
     }
   #else 
+    // the viewer is started in the background, a failure shows in openFailures() later
     bool tryOpen( const Node& node ) {
-        auto p = node.path();
-        const char* path = p.c_str();
-
-
-        pid_t pid = fork();
-        if (pid == -1 ) {
-            throw Exception( Exception::ErrorCode::FORK_FAILURE );
-        }
-
-        if (pid == 0) {
-          #ifdef __APPLE__
-            execl( "/usr/bin/open"
-                 , "open"
-                 ,"-W"
-                 , path
-                 , (char*) nullptr );
-            _exit(127);
-          #elif defined(__linux__)
-            execlp( "xdg-open"
-                  , "xdg-open"
-                  , path
-                  , (char*) nullptr );
-                  
-            _exit(127);
-          #else
-            _exit(127);
-          #endif
-        }
-
-        int status = 0;
-        if (waitpid(pid, &status, 0) == -1) {
-            throw Exception(Exception::ErrorCode::WAITPID_FAILURE );
-        }
-
-        if (WIFEXITED(status)) {
-            int code = WEXITSTATUS(status);
-            if (code == 127) {
-                throw Exception( Exception::ErrorCode::EXEC_FAILURE );
-            } else if (code != 0) {
-                throw Exception( std::format( "Error. open tool failed with code {}", code) );
-            } else return true;
-        } else if (WIFSIGNALED(status)) {
-            throw Exception( std::format( "Error. Child kiiled by signal with code {}", WTERMSIG(status)));
-        } else {
-            return false;
-        }
+        _launcher.launch( node.path().string() );
+        return true;
     }
   #endif
 
     bool exists( const std::string& path ) const {
-        auto npath = Path(path);
-        auto location = npath.location();
-        auto name = npath.name();
-
-        auto node = findByPath(location);
-        if (node->isDir() && node->hasChild( name )) {
-            return true;
-        } else return false;
+        return exists( Path(path) );
     }
 
     bool exists( const Path& path ) const {
         auto location = path.location();
-        auto name = path.name();
+        auto name = path[path.getSize() - 1]; // name() would drop the extension
 
         auto node = findByPath(location);
-        if (node->isDir() && node->hasChild( name )) {
+        if (node->isDir() && lookup( node, name ) != DentryCache::absent) {
             return true;
         } else return false;
     }
 
-    SharedPtr<Node> findByPath( const std::string& path ) const {
+    IntrusivePtr<Node> findByPath( const std::string& path ) const {
         return findByPath( Path(path) );
     }
 
-    SharedPtr<Node> findByPath( const Path& path ) const {
-        if (path.isAbsolute()) {
-            return resolve( _rootDir, path );
-        } else { 
-            return resolve( _currentDir, path );
+    // directories are cached by their absolute path, so a deep location resolves in one probe
+    IntrusivePtr<Node> findByPath( const Path& path ) const {
+        if (path.isEmpty()) { return _currentDir; }
+
+        auto key = absolute(path).string();
+        if (auto cached = _dentries.path(key)) {
+            return _data.get( cached.get() );
+        }
+
+        auto node = path.isAbsolute() ? resolve( _rootDir, path ) : resolve( _currentDir, path );
+        if (node->isDir()) {
+            _dentries.cachePath( key, node->id() );
         }
+        return node;
     }
 
-    SharedPtr<Node> resolve( SharedPtr<Node> node, const Path& path ) const {
+    IntrusivePtr<Node> resolve( IntrusivePtr<Node> node, const Path& path ) const {
         if (path.isEmpty()) { return node; }
 
-        SharedPtr<Node> res = node;
+        IntrusivePtr<Node> res = node;
         
         for (size_t i = 0; i < path.getSize(); i++) {
             auto token = path[i];
@@ -343,8 +531,9 @@ private:
                 }
             } else if (res->isDir()) {
                 if (token == "/") continue;
-                if (res->hasChild(token)) {
-                    res = _data.get( res->child(token));
+                auto id = lookup( res, token );
+                if (id != DentryCache::absent) {
+                    res = _data.get(id);
                 } else {
                     throw Exception( std::format("Error. Resolve failed: no such file or directory: {}", path.string()));
                 }
@@ -354,6 +543,408 @@ private:
         }
         return res;
     }
+
+    // child id or DentryCache::absent; misses are remembered as negative entries
+    NodeID lookup( const IntrusivePtr<Node>& dir, const std::string& name ) const {
+        if (auto cached = _dentries.child( dir->id(), name )) {
+            return cached.get();
+        }
+        auto id = dir->hasChild(name) ? dir->child(name) : DentryCache::absent;
+        _dentries.cacheChild( dir->id(), name, id );
+        return id;
+    }
+
+    Path absolute( const Path& path ) const {
+        if (path.isAbsolute()) { return path; }
+        else { return Path( _currentPath.string() + "/" + path.string() ); }
+    }
+
+    // names are gathered leaf first and appended root first, no prefix is copied per level
+    std::string absolutePathOf( IntrusivePtr<Node> node ) const {
+        ArraySequence<std::string> names;
+        for (; node->parent() != 0; node = _data.get( node->parent() )) {
+            names.append( node->name() );
+        }
+        std::string path;
+        for (size_t i = names.getSize(); i-- > 0;) {
+            path += '/';
+            path += names[i];
+        }
+        return Path(path.empty() ? "/" : path).string();
+    }
+
+    static bool isDirReference( const std::string& token ) noexcept {
+        return token == "/" || token == "." || token == "..";
+    }
+
+    bool isAncestorOrSelf( const IntrusivePtr<Node>& ancestor, IntrusivePtr<Node> node ) const {
+        while (true) {
+            if (node->id() == ancestor->id()) { return true; }
+            if (node->parent() == 0) { return false; }
+            node = _data.get( node->parent() );
+        }
+    }
+private:
+    // raw pointers: reference counts are not thread-safe, and nothing is freed during a walk
+    struct FindTask {
+        Node* _dir = nullptr;
+        std::string _path;
+    };
+
+    struct Subtree {
+        ArraySequence<NodeID> _ids;            // every node, the root of the subtree included
+        HashMap<NodeID,NodeID> _dirs;          // set of directory ids
+        ArraySequence<fs::path> _tempFiles;    // backing files created by touch
+        ArraySequence<fs::path> _blobs;        // one entry per file stored as a blob
+    };
+
+    // the directory a new file at vpath goes to, once its name is known to be free
+    IntrusivePtr<Node> fileLocation( const Path& vpath ) const {
+        auto name = vpath.name();
+        auto extension = vpath.extension();
+        if (name.empty() || extension.empty()) {
+            throw Exception( Exception::ErrorCode::INVALID_INPUT );
+        }
+        auto node = findByPath( vpath.location() );
+        if (!node->isDir()) {
+            throw Exception( std::format("Error. {} is not a directory.", node->name()));
+        } else if (lookup( node, name + extension ) != DentryCache::absent) {
+            throw Exception( std::format("Error. {} already exists.", vpath.string()));
+        }
+        return node;
+    }
+
+    // addFile, detachSubtree and detachFile change the namespace only; the callers decide what
+    // happens to backing files, which a replayed journal must leave alone
+    void addFile( IntrusivePtr<Node> dir, const std::string& title, const fs::path& phys ) {
+        auto id = _data.nextKey();
+        auto file = makeIntrusive<File<TContainer>>( id, dir->id(), title, phys );
+        link( dir, title, id );
+        _data.insert( file );
+    }
+
+    Subtree detachSubtree( const Path& vpath ) {
+        auto node = findByPath(vpath);
+        if (!node->isDir()) {
+            throw Exception( std::format( "Error. {} is not a directory.", vpath.string() ) );
+        }
+        if (node->parent() == 0) {
+            throw Exception( std::format( "Error. {} is a root directory and cannot be deleted.", vpath.string() ) );
+        }
+        auto parent = _data.get( node->parent() );
+        Subtree subtree;
+        collectSubtree( node, subtree );
+
+        // descendants are dropped wholesale, their listings are never edited entry by entry
+        unlink( parent, node->name(), node->id() );
+        _dentries.forgetChildrenOfAll( subtree._dirs );
+        if (_names) {
+            for (size_t i = 0; i < subtree._ids.getSize(); i++) {
+                auto id = subtree._ids[i];
+                if (id != node->id()) { _names->remove( _data.get(id)->name(), id ); }
+            }
+        }
+        _dentries.forgetPaths( absolute(vpath).string() );
+        if (subtree._dirs.contains( _currentDir->id() )) {
+            _currentDir = parent;
+            _currentPath = Path( absolutePathOf(parent) );
+        }
+        _data.removeMany( subtree._ids );
+        return subtree;
+    }
+
+    // the node stays alive for the caller
+    IntrusivePtr<Node> detachFile( const Path& vpath ) {
+        auto node = findByPath(vpath);
+        if (node->isDir()) {
+            throw Exception( std::format( "Error. {} is a directory. Use rmdir instead.", vpath.string() ) );
+        }
+        unlink( _data.get( node->parent() ), node->name(), node->id() );
+        _data.remove( node->id() );
+        return node;
+    }
+
+    // one iterative depth-first pass over the directory and everything below it
+    void collectSubtree( IntrusivePtr<Node> root, Subtree& subtree ) const {
+        ArraySequence<IntrusivePtr<Node>> stack;
+        stack.append( root );
+        while (!stack.isEmpty()) {
+            auto dir = stack[stack.getSize() - 1];
+            stack.removeAt( stack.getSize() - 1 );
+            subtree._ids.append( dir->id() );
+            subtree._dirs.insert( dir->id() );
+
+            auto& contents = dir->contents();
+            for (auto it = contents.begin(); it != contents.end(); ++it) {
+                auto child = _data.get( *it );
+                if (child->isDir()) {
+                    stack.append( child );
+                } else {
+                    subtree._ids.append( child->id() );
+                    if (isTempFile( child->path() )) {
+                        subtree._tempFiles.append( child->path() );
+                    } else if (_blobs && _blobs->owns( child->path() )) {
+                        subtree._blobs.append( child->path() );
+                    }
+                }
+            }
+        }
+    }
+
+    // backing files made by touch, open and writer live in the service directory and go with
+    // their file; attached files belong to the user and are never deleted
+    bool isTempFile( const fs::path& phys ) const {
+        return phys.parent_path() == _tempServiceDir;
+    }
+
+    // hands backing files to the background reclaimer, the caller does not wait for the deletion
+    void reclaim( ArraySequence<fs::path>&& paths ) {
+        for (size_t i = 0; i < paths.getSize(); i++) {
+            _mappings.forget( paths[i].string() );
+        }
+        _reclaimer.remove( std::move(paths) );
+    }
+
+    // writes the namespace as a binary image (see VFSImage.hpp) in one sequential write and
+    // returns its header checksum. the image goes to a temporary file first, so an interrupted
+    // save keeps the old one
+    std::uint64_t writeImage( const std::string& imagePath ) const {
+        std::vector<IntrusivePtr<Node>> order{ _rootDir };
+        std::vector<std::uint32_t> parents{ 0 };
+        std::vector<VFSImage::ImageNode> table;
+        std::string pool;
+
+        for (size_t index = 0; index < order.size(); index++) {
+            auto node = order[index];
+            VFSImage::ImageNode record{};
+            record._name = pool.size();
+            record._nameLength = node->name().size();
+            record._parent = parents[index];
+            pool += node->name();
+
+            if (node->isDir()) {
+                record._kind = VFSImage::Kind::dir;
+                record._firstChild = order.size();
+
+                auto& contents = node->contents();
+                auto first = order.size();
+                for (auto it = contents.begin(); it != contents.end(); ++it) {
+                    order.push_back( _data.get(*it) );
+                    parents.push_back( index );
+                }
+                auto byName = []( const IntrusivePtr<Node>& lhs, const IntrusivePtr<Node>& rhs ) {
+                    return lhs->name() < rhs->name();
+                };
+                if (!std::is_sorted( order.begin() + first, order.end(), byName )) {
+                    std::sort( order.begin() + first, order.end(), byName );
+                }
+                record._childCount = order.size() - first;
+                if (order.size() > UINT32_MAX) {
+                    throw Exception( Exception::ErrorCode::INVALID_SIZE );
+                }
+            } else {
+                auto path = node->path().string();
+                record._kind = VFSImage::Kind::file;
+                record._pathLength = path.size();
+                pool += path;
+            }
+            table.push_back( record );
+        }
+
+        VFSImage::Header header{};
+        std::memcpy( header._magic, VFSImage::magic, sizeof(header._magic) );
+        header._version = VFSImage::version;
+        header._nodeSize = sizeof(VFSImage::ImageNode);
+        header._nodeCount = table.size();
+        header._poolSize = pool.size();
+        header._tempCount = _tempCount;
+        header._nodesChecksum = VFSImage::checksum( reinterpret_cast<const char*>(table.data())
+                                                  , table.size() * sizeof(VFSImage::ImageNode) );
+        header._poolChecksum = VFSImage::checksum( pool.data(), pool.size() );
+        header._headerChecksum = VFSImage::headerChecksum( header );
+
+        std::string image;
+        image.reserve( sizeof(header) + table.size() * sizeof(VFSImage::ImageNode) + pool.size() );
+        image.append( reinterpret_cast<const char*>(&header), sizeof(header) );
+        image.append( reinterpret_cast<const char*>(table.data()), table.size() * sizeof(VFSImage::ImageNode) );
+        image += pool;
+
+        auto temp = imagePath + ".tmp";
+        {
+            std::ofstream ofs( temp, std::ios::binary | std::ios::trunc );
+            if (!ofs || !ofs.write( image.data(), image.size() ) || !ofs.flush()) {
+                throw Exception( std::format( "Error. Unable to write image {}.", imagePath ));
+            }
+        }
+        fs::rename( temp, imagePath );
+        return header._headerChecksum;
+    }
+
+    // replaces the namespace with an image written by save() and returns its header checksum.
+    // the image is verified and built aside first, so a damaged image leaves the namespace untouched
+    std::uint64_t readImage( const std::string& imagePath ) {
+        MappedFile file( imagePath );
+        VFSImage::View image( file.data(), file.size() );
+        auto corrupted = []() { return Exception( Exception::ErrorCode::CORRUPTED_IMAGE ); };
+
+        SlotMap<IntrusivePtr<Node>> data;
+        std::vector<NodeID> ids;
+        ids.reserve( image.nodeCount() );
+        for (size_t index = 0; index < image.nodeCount(); index++) {
+            auto record = image.node(index);
+            if (index == 0) {
+                if (record._kind != VFSImage::Kind::dir) { throw corrupted(); }
+            } else {
+                auto parent = image.node( record._parent );
+                if (parent._kind != VFSImage::Kind::dir || index < parent._firstChild
+                 || index - parent._firstChild >= parent._childCount) {
+                    throw corrupted();
+                }
+            }
+
+            auto id = data.nextKey();
+            auto parentID = (index == 0) ? 0 : ids[record._parent];
+            auto name = std::string( image.name(record) );
+            if (record._kind == VFSImage::Kind::dir) {
+                data.insert( makeIntrusive<Dir<TContainer>>( id, parentID, name ));
+            } else {
+                auto path = fs::path( std::string( image.path(record) ));
+                data.insert( makeIntrusive<File<TContainer>>( id, parentID, name, path ));
+            }
+            ids.push_back( id );
+        }
+
+        // children of a directory are stored sorted, so every listing is built in bulk
+        for (size_t index = 0; index < image.nodeCount(); index++) {
+            auto record = image.node(index);
+            if (record._kind != VFSImage::Kind::dir || record._childCount == 0) { continue; }
+
+            ArraySequence<Pair<std::string,NodeID>> entries( record._childCount );
+            std::string_view previous;
+            for (size_t child = record._firstChild; child < record._firstChild + record._childCount; child++) {
+                auto childRecord = image.node(child);
+                auto name = image.name(childRecord);
+                if (childRecord._parent != index || (child != record._firstChild && !(previous < name))) {
+                    throw corrupted();
+                }
+                entries.append( Pair<std::string,NodeID>( std::string(name), ids[child] ));
+                previous = name;
+            }
+            data.get( ids[index] )->contents().assignSorted( entries );
+        }
+
+        _data = std::move(data);
+        _rootDir = _data.get( ids[0] );
+        _currentDir = _rootDir;
+        _currentPath = Path("/");
+        _dentries.clear();
+        if (_names) {
+            _names.reset();
+            indexNames();
+        }
+        if (_blobs) { countBlobRefs(); }
+        _tempCount = std::max<size_t>( _tempCount, image.header()._tempCount );
+        return image.header()._headerChecksum;
+    }
+
+    void record( const VFSJournal::Op op, const std::string& first, const std::string& second = "" ) {
+        if (!_journal) { return; }
+        _journal->append( op, first, second );
+        if (_journal->sinceCompaction() >= _journal->policy().compactAfter) {
+            compact();
+        }
+    }
+
+    // applies a record to the namespace alone: the backing files it names were created, and
+    // maybe deleted, by the session that wrote it, and their names may belong to newer files by
+    // now. a record that does not apply is counted in skippedRecords()
+    void replay( const VFSJournal::Record& record ) {
+        try {
+            switch (record._op) {
+                case VFSJournal::Op::mkdir: mkdir( record._first ); break; // the journal is off, nothing is recorded
+                case VFSJournal::Op::attach: {
+                    auto vpath = Path( record._first );
+                    addFile( fileLocation(vpath), vpath.name() + vpath.extension(), record._second );
+                    noteTempPath( record._second );
+                    break;
+                }
+                case VFSJournal::Op::rmdir:  detachSubtree( Path( record._first )); break;
+                case VFSJournal::Op::remove: detachFile( Path( record._first )); break;
+                case VFSJournal::Op::move:   move( record._first, record._second ); break;
+                case VFSJournal::Op::relocate: {
+                    auto node = findByPath( record._first );
+                    if (node->isDir()) { throw Exception( Exception::ErrorCode::INVALID_INPUT ); }
+                    static_cast<File<TContainer>*>( node.get() )->_diskPath = record._second;
+                    noteTempPath( record._second );
+                    break;
+                }
+            }
+        } catch (Exception& ex) {
+            _skippedRecords++;
+        }
+    }
+
+    // gives a file another backing file, the blob references follow
+    void repoint( IntrusivePtr<Node> node, const fs::path& phys ) {
+        auto old = node->path();
+        static_cast<File<TContainer>*>( node.get() )->_diskPath = phys;
+        _mappings.forget( old.string() );
+        if (_blobs && _blobs->owns(phys)) { _blobs->retain(phys); }
+        releaseBlob(old);
+        record( VFSJournal::Op::relocate, absolutePathOf(node), phys.string() );
+    }
+
+    static WritePolicy sizedFor( WritePolicy policy, const size_t size ) {
+        policy.bufferSize = std::min( policy.bufferSize, size );
+        return policy;
+    }
+
+    void releaseBlob( const fs::path& phys ) {
+        if (_blobs && _blobs->owns(phys) && _blobs->release(phys)) {
+            _mappings.forget( phys.string() );
+        }
+    }
+
+    void countBlobRefs() {
+        _blobs->clear();
+        for (auto it = _data.begin(); it != _data.end(); ++it) {
+            if (!(*it)->isDir() && _blobs->owns( (*it)->path() )) { _blobs->retain( (*it)->path() ); }
+        }
+    }
+
+    // every change of a directory listing goes through these to keep the dentry cache
+    // and the name index exact
+    void link( IntrusivePtr<Node> dir, const std::string& name, const NodeID id ) {
+        dir->contents().add( Pair<std::string,NodeID>( name, id ));
+        _dentries.cacheChild( dir->id(), name, id );
+        if (_names) { _names->add( name, id ); }
+    }
+
+    void unlink( IntrusivePtr<Node> dir, const std::string& name, const NodeID id ) {
+        dir->contents().remove( name );
+        _dentries.cacheChild( dir->id(), name, DentryCache::absent );
+        if (_names) { _names->remove( name, id ); }
+    }
+
+    // renames the node in place, so its id and contents stay valid
+    void relink( IntrusivePtr<Node> node, const Path& from
+               , IntrusivePtr<Node> destDir, const std::string& name ) {
+        if (lookup( destDir, name ) != DentryCache::absent) {
+            throw Exception( std::format( "Error. {} already exists.", name ));
+        }
+        auto srcDir = _data.get( node->parent() );
+        if (node->isDir()) {
+            _dentries.forgetPaths( absolute(from).string() );
+        }
+        unlink( srcDir, node->name(), node->id() );
+        node->_name = name;
+        node->_parentID = destDir->id();
+        link( destDir, name, node->id() );
+
+        if (node->isDir()) {
+            _currentPath = Path( absolutePathOf(_currentDir) );
+        }
+    }
 private:
     fs::path resolvePhys( const fs::path& phys ) {
         if (phys.is_absolute()) {
@@ -367,8 +958,24 @@ private:
         }
     }
     
+    // a temp name seen in the journal is never handed out again, even once its file is deleted
+    void noteTempPath( const fs::path& phys ) {
+        if (!isTempFile(phys)) { return; }
+        auto name = phys.filename().string();
+        size_t index = 0;
+        if (name.starts_with("temp(") && name.ends_with(")")
+         && std::from_chars( name.data() + 5, name.data() + name.size() - 1, index ).ec == std::errc()) {
+            _tempCount = std::max( _tempCount, index + 1 );
+        }
+    }
+
+    // skips names taken by files the counter does not know of, e.g. attached by hand
     fs::path newTempPath() {
-        return _tempServiceDir/(std::format("temp({})", _tempCount++));
+        fs::path path;
+        do {
+            path = _tempServiceDir/(std::format("temp({})", _tempCount++));
+        } while (fs::exists(path));
+        return path;
     }
 
     void createTempFile( const fs::path& path ) {
@@ -391,13 +998,25 @@ private:
     //     return result;
     // }
 private:
-    SharedPtr<Node> _currentDir;
-    SharedPtr<Node> _rootDir;
-    IDictionary<NodeID,SharedPtr<Node>,TContainer<NodeID,SharedPtr<Node>>> _data;
-    NodeID _lastID;
+    IntrusivePtr<Node> _currentDir;
+    IntrusivePtr<Node> _rootDir;
+    Path _currentPath; // absolute path of _currentDir
+    SlotMap<IntrusivePtr<Node>> _data; // NodeID is the slot map key
+    mutable DentryCache _dentries;     // lookups fill it, so it is mutable like a memo
+    mutable MappingCache _mappings;    // same for the mappings of read()
 
     fs::path _tempServiceDir;
     size_t _tempCount;
+    size_t _skippedRecords = 0;
+    Reclaimer _reclaimer;
+
+    std::string _imagePath;
+    std::unique_ptr<VFSJournal> _journal; // set by persist()
+    std::unique_ptr<NameIndex> _names;    // set by indexNames()
+    std::unique_ptr<BlobStore> _blobs;    // set by useBlobStore()
+  #if defined(__unix__) || defined(__APPLE__)
+    Launcher _launcher;
+  #endif
 };
 
 #endif // VFS_H
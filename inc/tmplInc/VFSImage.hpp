@@ -0,0 +1,134 @@
+#ifndef VFS_IMAGE_H
+#define VFS_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "util.hpp"
+
+// binary image of a VFS namespace, stored as three sections right after the header:
+//   node table  - one ImageNode per node in breadth-first order, the root first. children of
+//                 a directory are consecutive and sorted by name, so each directory owns a
+//                 sorted entry array that is loaded into its container in bulk
+//   string pool - node names and backing paths of files, without terminators
+// integers are in host byte order. the header and every section carry a checksum.
+namespace VFSImage
+{
+    inline constexpr char magic[8] = { 'V', 'F', 'S', 'I', 'M', 'A', 'G', 'E' };
+    inline constexpr std::uint32_t version = 1;
+
+    enum class Kind : std::uint32_t
+    {
+        dir  = 0,
+        file = 1
+    };
+
+    struct Header
+    {
+        char _magic[8];
+        std::uint32_t _version;
+        std::uint32_t _nodeSize;    // sizeof(ImageNode) of the writer
+        std::uint64_t _nodeCount;
+        std::uint64_t _poolSize;
+        std::uint64_t _tempCount;   // backing files created by touch so far
+        std::uint64_t _nodesChecksum;
+        std::uint64_t _poolChecksum;
+        std::uint64_t _headerChecksum; // of all fields above
+    };
+
+    struct ImageNode
+    {
+        std::uint64_t _name;        // offset of the name in the pool, a file's path follows it
+        std::uint32_t _nameLength;
+        std::uint32_t _pathLength;  // files only
+        std::uint32_t _parent;      // index of the parent, the root refers to itself
+        std::uint32_t _firstChild;  // directories only
+        std::uint32_t _childCount;
+        Kind _kind;
+    };
+
+    // word-at-a-time multiply-rotate hash, fast enough to verify hundreds of megabytes per second
+    inline std::uint64_t checksum( const char* data, const size_t size ) noexcept {
+        const std::uint64_t k1 = 0x87C37B91114253D5ull;
+        const std::uint64_t k2 = 0x4CF5AD432745937Full;
+        std::uint64_t hash = 0x9E3779B97F4A7C15ull ^ (size * k1);
+        size_t pos = 0;
+        for (; pos + 8 <= size; pos += 8) {
+            std::uint64_t word;
+            std::memcpy( &word, data + pos, 8 );
+            hash ^= word * k1;
+            hash = ((hash << 31) | (hash >> 33)) * k2;
+        }
+        std::uint64_t tail = 0;
+        std::memcpy( &tail, data + pos, size - pos );
+        hash ^= tail * k2;
+        hash ^= hash >> 33;
+        hash *= k1;
+        hash ^= hash >> 29;
+        return hash;
+    }
+
+    inline std::uint64_t headerChecksum( const Header& header ) noexcept {
+        return checksum( reinterpret_cast<const char*>(&header), offsetof(Header, _headerChecksum) );
+    }
+
+    // validated read access to an image in memory; throws CORRUPTED_IMAGE or UNSUPPORTED_IMAGE
+    class View
+    {
+    public:
+        View( const char* data, const size_t size ) {
+            if (size < sizeof(Header)) {
+                throw Exception( Exception::ErrorCode::UNSUPPORTED_IMAGE );
+            }
+            std::memcpy( &_header, data, sizeof(Header) );
+            if (std::memcmp( _header._magic, magic, sizeof(magic) ) != 0
+             || _header._version != version || _header._nodeSize != sizeof(ImageNode)) {
+                throw Exception( Exception::ErrorCode::UNSUPPORTED_IMAGE );
+            }
+            if (headerChecksum(_header) != _header._headerChecksum
+             || _header._nodeCount == 0 || _header._nodeCount > UINT32_MAX
+             || (size - sizeof(Header)) / sizeof(ImageNode) < _header._nodeCount
+             || size - sizeof(Header) - _header._nodeCount * sizeof(ImageNode) != _header._poolSize) {
+                throw Exception( Exception::ErrorCode::CORRUPTED_IMAGE );
+            }
+            _nodes = data + sizeof(Header);
+            _pool = _nodes + _header._nodeCount * sizeof(ImageNode);
+            if (checksum( _nodes, _header._nodeCount * sizeof(ImageNode) ) != _header._nodesChecksum
+             || checksum( _pool, _header._poolSize ) != _header._poolChecksum) {
+                throw Exception( Exception::ErrorCode::CORRUPTED_IMAGE );
+            }
+        }
+    public:
+        const Header& header() const noexcept { return _header; }
+        size_t nodeCount() const noexcept { return _header._nodeCount; }
+
+        // bounds of the record are checked, so a node never points outside the image
+        ImageNode node( const size_t index ) const {
+            ImageNode node;
+            std::memcpy( &node, _nodes + index * sizeof(ImageNode), sizeof(ImageNode) );
+            bool dir = node._kind == Kind::dir;
+            if ((!dir && node._kind != Kind::file)
+             || node._parent >= nodeCount() || (index != 0 && node._parent >= index)
+             || node._name > _header._poolSize
+             || _header._poolSize - node._name < std::uint64_t(node._nameLength) + node._pathLength
+             || (dir && (node._firstChild > nodeCount() || nodeCount() - node._firstChild < node._childCount))
+             || (dir && node._childCount != 0 && node._firstChild <= index)) {
+                throw Exception( Exception::ErrorCode::CORRUPTED_IMAGE );
+            }
+            return node;
+        }
+        std::string_view name( const ImageNode& node ) const noexcept {
+            return std::string_view( _pool + node._name, node._nameLength );
+        }
+        std::string_view path( const ImageNode& node ) const noexcept {
+            return std::string_view( _pool + node._name + node._nameLength, node._pathLength );
+        }
+    private:
+        Header _header;
+        const char* _nodes;
+        const char* _pool;
+    };
+}
+
+#endif // VFS_IMAGE_H
@@ -0,0 +1,340 @@
+#ifndef VFS_JOURNAL_H
+#define VFS_JOURNAL_H
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "VFSImage.hpp"
+#include "MappedFile.hpp"
+
+// when a journal syncs its records and when the owner folds it into a new snapshot
+struct JournalPolicy
+{
+    size_t groupSize = 64;                      // a full group is synced by the writer at once
+    std::chrono::milliseconds groupDelay{ 5 };  // a smaller group waits at most this long
+    size_t compactAfter = size_t(1) << 20;      // records since the last snapshot
+};
+
+// append-only log of namespace mutations made after a snapshot. the file starts with a header
+// naming the snapshot (its header checksum, 0 for none), every record is
+//   u32 body length, u32 body checksum, u8 op, u32 length + first path, u32 length + second path
+// records are batched and synced in groups: by the writer once a group is full, by a background
+// thread once the oldest pending record waited groupDelay. a torn tail is cut off on replay
+class VFSJournal
+{
+public:
+    enum class Op : std::uint8_t
+    {
+        mkdir    = 1,
+        attach   = 2,
+        rmdir    = 3,
+        remove   = 4,
+        move     = 5,
+        relocate = 6  // a file got another backing file
+    };
+
+    struct Record
+    {
+        Op _op;
+        std::string _first;
+        std::string _second;
+    };
+private:
+    static constexpr char _magic[8] = { 'V', 'F', 'S', 'J', 'R', 'N', 'L', '1' };
+
+    struct Header
+    {
+        char _magic[8];
+        std::uint64_t _base;
+        std::uint64_t _headerChecksum; // of the fields above
+    };
+public:
+    // opens the journal of the snapshot base, keeping the first validLength bytes returned by
+    // replay(). anything else, a missing file included, starts an empty journal
+    VFSJournal( const std::string& path, const std::uint64_t base
+              , const size_t validLength, const JournalPolicy& policy = JournalPolicy() )
+    : _path( path ), _policy( policy ), _pendingCount( 0 ), _sinceCompaction( 0 ), _stopping( false ) {
+        if (_policy.groupSize == 0) {
+            throw Exception( Exception::ErrorCode::INVALID_SIZE );
+        }
+        if (validLength >= sizeof(Header)) {
+            std::filesystem::resize_file( _path, validLength );
+        } else {
+            create(base);
+        }
+        open();
+        _flusher = std::thread( [this]() { run(); } );
+    }
+
+    VFSJournal( const VFSJournal& other ) = delete;
+    VFSJournal& operator=( const VFSJournal& other ) = delete;
+
+    ~VFSJournal() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_one();
+        _flusher.join();
+        flush();
+        close();
+    }
+public:
+    // feeds every intact record of the journal of the snapshot base to apply and returns the
+    // length of the intact prefix. a journal of another snapshot is stale and yields 0
+    template <typename Apply>
+    static size_t replay( const std::string& path, const std::uint64_t base, Apply apply ) {
+        if (!std::filesystem::exists(path)) { return 0; }
+
+        MappedFile file(path);
+        Header header;
+        if (file.size() < sizeof(Header)) {
+            throw Exception( Exception::ErrorCode::CORRUPTED_IMAGE );
+        }
+        std::memcpy( &header, file.data(), sizeof(Header) );
+        if (std::memcmp( header._magic, _magic, sizeof(_magic) ) != 0) {
+            throw Exception( Exception::ErrorCode::UNSUPPORTED_IMAGE );
+        }
+        if (headerChecksum(header) != header._headerChecksum) {
+            throw Exception( Exception::ErrorCode::CORRUPTED_IMAGE );
+        }
+        if (header._base != base) { return 0; }
+
+        size_t pos = sizeof(Header);
+        Record record;
+        while (decode( file.data(), file.size(), pos, record )) {
+            apply( static_cast<const Record&>(record) );
+        }
+        return pos;
+    }
+
+    void append( const Op op, const std::string& first, const std::string& second = "" ) {
+        bool full;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_error.empty()) {
+                throw Exception(_error);
+            }
+            encode( _pending, op, first, second );
+            _sinceCompaction++;
+            full = ++_pendingCount >= _policy.groupSize;
+        }
+        if (full) {
+            flush();
+        } else {
+            _wake.notify_one();
+        }
+    }
+
+    // every record appended so far is durable on return
+    void sync() {
+        flush();
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error.empty()) {
+            throw Exception(_error);
+        }
+    }
+
+    // starts an empty journal for a new snapshot. pending records are dropped, the snapshot
+    // already holds their effect. until the switch a crash leaves the old journal, whose stale
+    // base makes replay skip it
+    void reset( const std::uint64_t base ) {
+        std::lock_guard<std::mutex> io(_ioMutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.clear();
+            _pendingCount = 0;
+            _sinceCompaction = 0;
+        }
+        close();
+        create(base);
+        open();
+    }
+
+    size_t sinceCompaction() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _sinceCompaction;
+    }
+    const JournalPolicy& policy() const noexcept { return _policy; }
+private:
+    static std::uint64_t headerChecksum( const Header& header ) noexcept {
+        return VFSImage::checksum( reinterpret_cast<const char*>(&header), offsetof(Header, _headerChecksum) );
+    }
+
+    static void putWord( std::string& out, const std::uint32_t word ) {
+        out.append( reinterpret_cast<const char*>(&word), sizeof(word) );
+    }
+
+    static bool getWord( const char* data, const size_t size, size_t& pos, std::uint32_t& word ) {
+        if (size - pos < sizeof(word)) { return false; }
+        std::memcpy( &word, data + pos, sizeof(word) );
+        pos += sizeof(word);
+        return true;
+    }
+
+    static bool getString( const char* data, const size_t size, size_t& pos, std::string& str ) {
+        std::uint32_t length;
+        if (!getWord( data, size, pos, length ) || size - pos < length) { return false; }
+        str.assign( data + pos, length );
+        pos += length;
+        return true;
+    }
+
+    static void encode( std::string& out, const Op op
+                      , const std::string& first, const std::string& second ) {
+        auto start = out.size();
+        putWord( out, 0 );
+        putWord( out, 0 );
+        out += static_cast<char>(op);
+        putWord( out, first.size() );
+        out += first;
+        putWord( out, second.size() );
+        out += second;
+
+        std::uint32_t length = out.size() - start - 2 * sizeof(std::uint32_t);
+        std::uint32_t checksum = VFSImage::checksum( out.data() + start + 2 * sizeof(std::uint32_t), length );
+        std::memcpy( out.data() + start, &length, sizeof(length) );
+        std::memcpy( out.data() + start + sizeof(length), &checksum, sizeof(checksum) );
+    }
+
+    // advances pos past the record on success, leaves it at the torn or damaged record otherwise
+    static bool decode( const char* data, const size_t size, size_t& pos, Record& record ) {
+        size_t next = pos;
+        std::uint32_t length, checksum;
+        if (!getWord( data, size, next, length ) || !getWord( data, size, next, checksum )
+         || size - next < length
+         || static_cast<std::uint32_t>( VFSImage::checksum( data + next, length )) != checksum) {
+            return false;
+        }
+        auto end = next + length;
+        if (length == 0) { return false; }
+        auto op = static_cast<Op>( data[next++] );
+        if (op < Op::mkdir || op > Op::relocate
+         || !getString( data, end, next, record._first ) || !getString( data, end, next, record._second )
+         || next != end) {
+            return false;
+        }
+        record._op = op;
+        pos = end;
+        return true;
+    }
+
+    // the header is written aside and renamed in, so a journal file is never headless
+    void create( const std::uint64_t base ) {
+        Header header{};
+        std::memcpy( header._magic, _magic, sizeof(_magic) );
+        header._base = base;
+        header._headerChecksum = headerChecksum(header);
+
+        auto temp = _path + ".tmp";
+        {
+            std::ofstream ofs( temp, std::ios::binary | std::ios::trunc );
+            if (!ofs || !ofs.write( reinterpret_cast<const char*>(&header), sizeof(header) ) || !ofs.flush()) {
+                throw Exception( std::format( "Error. Unable to write journal {}.", _path ));
+            }
+        }
+        std::filesystem::rename( temp, _path );
+    }
+
+    // the flusher sleeps until a record is pending, then gives the group groupDelay to fill up
+    void run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _wake.wait( lock, [this]() { return _stopping || _pendingCount != 0; } );
+            if (_stopping) { return; }
+            _wake.wait_for( lock, _policy.groupDelay, [this]() { return _stopping || _pendingCount == 0; } );
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+    // one write and one sync per group; groups reach the file in the order they were taken
+    void flush() {
+        std::lock_guard<std::mutex> io(_ioMutex);
+        std::string group;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            group.swap(_pending);
+            _pendingCount = 0;
+        }
+        if (group.empty()) { return; }
+        if (!write(group)) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = std::format( "Error. Unable to write journal {}.", _path );
+        }
+    }
+
+  #if defined(__unix__) || defined(__APPLE__)
+    void open() {
+        _fd = ::open( _path.c_str(), O_WRONLY | O_APPEND );
+        if (_fd == -1) {
+            throw Exception( std::format( "Error. Unable to open journal {}.", _path ));
+        }
+    }
+
+    bool write( const std::string& bytes ) {
+        for (size_t done = 0; done < bytes.size();) {
+            auto written = ::write( _fd, bytes.data() + done, bytes.size() - done );
+            if (written == -1) { return false; }
+            done += written;
+        }
+      #if defined(__APPLE__)
+        return ::fsync(_fd) == 0;
+      #else
+        return ::fdatasync(_fd) == 0;
+      #endif
+    }
+
+    void close() {
+        if (_fd != -1) { ::close(_fd); }
+        _fd = -1;
+    }
+  #else
+    void open() {
+        _ofs.open( _path, std::ios::binary | std::ios::app );
+        if (!_ofs) {
+            throw Exception( std::format( "Error. Unable to open journal {}.", _path ));
+        }
+    }
+
+    bool write( const std::string& bytes ) {
+        return static_cast<bool>( _ofs.write( bytes.data(), bytes.size() ).flush() );
+    }
+
+    void close() {
+        _ofs.close();
+    }
+  #endif
+private:
+    std::string _path;
+    JournalPolicy _policy;
+  #if defined(__unix__) || defined(__APPLE__)
+    int _fd = -1;
+  #else
+    std::ofstream _ofs;
+  #endif
+
+    mutable std::mutex _mutex;  // guards the pending group and the counters
+    std::mutex _ioMutex;        // orders groups on their way to the file
+    std::condition_variable _wake;
+    std::string _pending;
+    size_t _pendingCount;
+    size_t _sinceCompaction;
+    std::string _error;         // a failed background sync surfaces on the next call
+    bool _stopping;
+    std::thread _flusher;
+};
+
+#endif // VFS_JOURNAL_H
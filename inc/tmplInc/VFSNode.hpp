@@ -2,13 +2,15 @@
 #define VFSNODE_H
 
 #include "IDictionary.hpp"
+#include "IntrusivePtr.hpp"
 #include "util.hpp"
 #include <filesystem>
+#include <format>
 
 using NodeID = std::size_t;
 
 template <template<COrdered,class> class TContainer>
-struct VFSNode
+struct VFSNode : IntrusiveRefCounter<>
 {
     VFSNode( const NodeID id, const NodeID parent, const std::string& name )
     : _id(id), _parentID(parent), _name(name) {}
@@ -33,6 +35,13 @@ struct VFSNode
     virtual const std::filesystem::path& path() const {
         throw Exception( std::format( "Error. {} is not a regular file.", _name ) ); 
     } 
+    virtual MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.nodes = sizeof(VFSNode) - sizeof(IntrusiveRefCounter<>);
+        usage.controlBlocks = sizeof(IntrusiveRefCounter<>);
+        usage.payload = ownedBytes(_name);
+        return usage;
+    }
     virtual ~VFSNode() = default;
 
     NodeID _id;
@@ -44,17 +53,25 @@ template <template<COrdered,class> class TContainer>
 struct Dir : VFSNode<TContainer>
 {
     using Dict = IDictionary<std::string,NodeID,TContainer<std::string,NodeID>>;
+    // entries before a directory keeps a Bloom filter, most directories never get one
+    static constexpr ssize_t bloomFrom = 64;
 
     Dir( const NodeID id, const NodeID parent, const std::string& name )
-    : VFSNode<TContainer>( id, parent, name ) {}
+    : VFSNode<TContainer>( id, parent, name ) { _contents.useBloomFilter( bloomFrom ); }
 
     Dir( const NodeID id, const NodeID parent, const std::string& name, Dict& contents )
-    : VFSNode<TContainer>( id, parent, name ), _contents( std::move(contents) ) {}
+    : VFSNode<TContainer>( id, parent, name ), _contents( std::move(contents) ) { _contents.useBloomFilter( bloomFrom ); }
 
     bool isDir() const override { return true; }
     NodeID child( const std::string& name ) const override { return _contents.get(name); }
     bool hasChild( const std::string& name ) const override { return _contents.contains(name); } 
     virtual Dict& contents() { return _contents; }
+    MemoryUsage memoryUsage() const override {
+        auto usage = VFSNode<TContainer>::memoryUsage();
+        usage.nodes += sizeof(Dir) - sizeof(VFSNode<TContainer>);
+        usage += _contents.memoryUsage();
+        return usage;
+    }
     
     ~Dir() = default;
 
@@ -71,6 +88,12 @@ struct File : VFSNode<TContainer>
     , _diskPath( path ) {}
     
     const std::filesystem::path& path() const override { return _diskPath; } 
+    MemoryUsage memoryUsage() const override {
+        auto usage = VFSNode<TContainer>::memoryUsage();
+        usage.nodes += sizeof(File) - sizeof(VFSNode<TContainer>);
+        usage.payload += ownedBytes( _diskPath.native() );
+        return usage;
+    }
 
     ~File() = default;
 
@@ -25,7 +25,7 @@ public:
         std::string res;
         for (size_t i = 0; i < getSize(); i++) {
             res += _tokens[i];
-            if (i != getSize() - 1) res += "/";
+            if (i != getSize() - 1 && _tokens[i] != "/") res += "/"; // the root token is a separator itself
         }
         return res;
     }
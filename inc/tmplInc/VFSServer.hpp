@@ -0,0 +1,335 @@
+#ifndef VFS_SERVER_H
+#define VFS_SERVER_H
+
+#if defined(__linux__)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "consoleApp.hpp"
+#include "VFSProtocol.hpp"
+
+// stream buffer appending to a string, the output of a command goes straight into its reply
+class StringSink : public std::streambuf
+{
+public:
+    void target( std::string* out ) noexcept { _out = out; }
+protected:
+    int_type overflow( int_type ch ) override {
+        if (!traits_type::eq_int_type( ch, traits_type::eof() )) {
+            _out->push_back( traits_type::to_char_type(ch) );
+        }
+        return traits_type::not_eof(ch);
+    }
+    std::streamsize xsputn( const char* data, std::streamsize size ) override {
+        _out->append( data, size );
+        return size;
+    }
+private:
+    std::string* _out = nullptr;
+};
+
+// serves one namespace to local processes over a unix domain socket (wire format in
+// VFSProtocol.hpp). a single thread waits on epoll for every connection, so commands run one at
+// a time against the console app and need no locking. every connection is a session with its own
+// current directory; it may pipeline requests, all complete ones in a read are executed and their
+// replies leave together. a session whose replies pile up is not read until the client catches up
+template <template<COrdered,class> class TContainer >
+class VFSServer
+{
+private:
+    static constexpr size_t readChunk = size_t(64) << 10;
+    static constexpr size_t readLimit = size_t(1) << 20;  // per wakeup, keeps one client from starving the rest
+    static constexpr size_t replyLimit = size_t(4) << 20; // pending reply bytes before reading pauses
+
+    struct Session {
+        int _fd = -1;
+        std::string _in;          // received, read from _inHead on
+        size_t _inHead = 0;
+        std::string _out;         // replies, sent up to _outHead
+        size_t _outHead = 0;
+        std::string _cwd = "/";
+        bool _eof = false;        // the client sends nothing more
+        bool _exited = false;     // after exit the rest of the input is ignored
+        std::uint32_t _events = 0;
+
+        size_t pending() const noexcept { return _out.size() - _outHead; }
+        bool done() const noexcept { return (_eof || _exited) && pending() == 0; }
+    };
+public:
+    // takes over a socket path left by a server that is gone, a live one is an error
+    VFSServer( VFSConsoleApp<TContainer>& app, const std::string& socketPath )
+    : _app( app ), _socketPath( socketPath ), _cwd( app.getCWD() ), _stream( &_sink ) {
+        sockaddr_un address{};
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            throw Exception( std::format( "Error. Socket path {} is too long.", socketPath ));
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy( address.sun_path, socketPath.c_str(), socketPath.size() + 1 );
+
+        struct stat info;
+        if (::lstat( socketPath.c_str(), &info ) == 0) {
+            int probe = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+            bool live = probe != -1 && ::connect( probe, reinterpret_cast<sockaddr*>(&address), sizeof(address) ) == 0;
+            if (probe != -1) { ::close(probe); }
+            if (live || !S_ISSOCK(info.st_mode)) {
+                throw Exception( std::format( "Error. {} is in use.", socketPath ));
+            }
+            ::unlink( socketPath.c_str() );
+        }
+
+        _listen = ::socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+        _epoll = ::epoll_create1( EPOLL_CLOEXEC );
+        _wake = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+        bool ok = _listen != -1 && _epoll != -1 && _wake != -1
+               && ::bind( _listen, reinterpret_cast<sockaddr*>(&address), sizeof(address) ) == 0;
+        _bound = ok;
+        ok = ok && ::chmod( socketPath.c_str(), 0600 ) == 0 // local services of the same user only
+                && ::listen( _listen, SOMAXCONN ) == 0
+                && watch( _listen, EPOLLIN, EPOLL_CTL_ADD ) && watch( _wake, EPOLLIN, EPOLL_CTL_ADD );
+        if (!ok) {
+            release();
+            throw Exception( std::format( "Error. Unable to serve on {}.", socketPath ));
+        }
+    }
+
+    VFSServer( const VFSServer& other ) = delete;
+    VFSServer& operator=( const VFSServer& other ) = delete;
+
+    ~VFSServer() { release(); }
+public:
+    // serves until stop(), the replies not sent by then are dropped
+    void run() {
+        epoll_event events[64];
+        _stopped = false;
+        while (!_stopped) {
+            int ready = ::epoll_wait( _epoll, events, 64, -1 );
+            if (ready == -1) {
+                if (errno == EINTR) { continue; }
+                throw Exception( "Error. The VFS server lost its event loop." );
+            }
+            for (int i = 0; i < ready; i++) {
+                int fd = events[i].data.fd;
+                if (fd == _listen) {
+                    accept();
+                } else if (fd == _wake) {
+                    std::uint64_t count;
+                    (void)::read( _wake, &count, sizeof(count) );
+                    _stopped = true;
+                } else if (static_cast<size_t>(fd) < _sessions.size() && _sessions[fd]) {
+                    serve( *_sessions[fd], events[i].events );
+                }
+            }
+        }
+    }
+
+    // safe from another thread and from a signal handler
+    void stop() noexcept {
+        std::uint64_t one = 1;
+        (void)::write( _wake, &one, sizeof(one) );
+    }
+
+    size_t sessions() const noexcept { return _open; }
+    const std::string& socketPath() const noexcept { return _socketPath; }
+private:
+    bool watch( const int fd, const std::uint32_t events, const int op ) noexcept {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        return ::epoll_ctl( _epoll, op, fd, &event ) == 0;
+    }
+
+    void accept() {
+        while (true) {
+            int fd = ::accept4( _listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+            if (fd == -1) { return; } // drained, or out of descriptors until a session ends
+            if (!watch( fd, EPOLLIN, EPOLL_CTL_ADD )) {
+                ::close(fd);
+                continue;
+            }
+            if (static_cast<size_t>(fd) >= _sessions.size()) { _sessions.resize( fd + 1 ); }
+            _sessions[fd] = std::make_unique<Session>();
+            _sessions[fd]->_fd = fd;
+            _sessions[fd]->_events = EPOLLIN;
+            _open++;
+        }
+    }
+
+    void serve( Session& session, const std::uint32_t events ) {
+        if ((events & EPOLLIN) && !receive(session)) {
+            close(session);
+            return;
+        }
+        if ((events & (EPOLLERR | EPOLLHUP)) && !(events & EPOLLIN)) {
+            close(session);
+            return;
+        }
+        do { // a reply that left at once makes room for the requests held back
+            process(session);
+            if (!send(session)) {
+                close(session);
+                return;
+            }
+        } while (session.pending() == 0 && !session._exited && hasRequest(session));
+        if (session.done()) {
+            close(session);
+            return;
+        }
+        std::uint32_t wanted = (session.pending() < replyLimit && !session._eof && !session._exited) ? std::uint32_t( EPOLLIN ) : 0;
+        if (session.pending() != 0) { wanted |= EPOLLOUT; }
+        if (wanted != session._events && watch( session._fd, wanted, EPOLL_CTL_MOD )) {
+            session._events = wanted;
+        }
+    }
+
+    // false when the connection failed
+    bool receive( Session& session ) {
+        char chunk[readChunk];
+        for (size_t got = 0; got < readLimit;) {
+            auto size = ::recv( session._fd, chunk, sizeof(chunk), 0 );
+            if (size == -1) {
+                if (errno == EINTR) { continue; }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            if (size == 0) {
+                session._eof = true;
+                return true;
+            }
+            session._in.append( chunk, size );
+            got += size;
+        }
+        return true;
+    }
+
+    static bool hasRequest( const Session& session ) noexcept {
+        auto available = session._in.size() - session._inHead;
+        return available >= VFSProtocol::headerSize
+            && available >= VFSProtocol::headerSize + VFSProtocol::getLength( session._in.data() + session._inHead );
+    }
+
+    // runs every complete request while the replies fit
+    void process( Session& session ) {
+        while (!session._exited && session.pending() < replyLimit) {
+            auto available = session._in.size() - session._inHead;
+            if (available < VFSProtocol::headerSize) { break; }
+            auto length = VFSProtocol::getLength( session._in.data() + session._inHead );
+            if (length > VFSProtocol::maxFrame) { // not a client of ours, stop talking to it
+                session._exited = true;
+                session._in.clear();
+                session._inHead = 0;
+                return;
+            }
+            if (available < VFSProtocol::headerSize + length) { break; }
+            std::string_view command( session._in.data() + session._inHead + VFSProtocol::headerSize, length );
+            respond( session, command );
+            session._inHead += VFSProtocol::headerSize + length;
+        }
+        if (session._inHead == session._in.size()) {
+            session._in.clear();
+            session._inHead = 0;
+        } else if (session._inHead > readLimit) {
+            session._in.erase( 0, session._inHead );
+            session._inHead = 0;
+        }
+    }
+
+    void respond( Session& session, std::string_view command ) {
+        if (session._cwd != _cwd) {
+            try {
+                _app.setCWD( session._cwd );
+            } catch (...) { // removed by another session
+                session._cwd = "/";
+                _app.setCWD( session._cwd );
+            }
+        }
+        auto start = session._out.size();
+        VFSProtocol::putLength( session._out, 0 );
+        session._out.push_back( static_cast<char>(VFSProtocol::ok) );
+        _sink.target( &session._out );
+        try {
+            _app.execute( command, _stream );
+        } catch (ExitSignal& sig) {
+            session._exited = true;
+        } catch (std::exception& ex) {
+            session._out.resize( start + VFSProtocol::headerSize );
+            session._out.push_back( static_cast<char>(VFSProtocol::error) );
+            session._out.append( ex.what() );
+        }
+        _stream.clear();
+        VFSProtocol::patchLength( session._out, start );
+        _cwd = _app.getCWD();
+        session._cwd = _cwd;
+    }
+
+    // false when the connection failed
+    bool send( Session& session ) {
+        while (session.pending() != 0) {
+            auto sent = ::send( session._fd, session._out.data() + session._outHead, session.pending(), MSG_NOSIGNAL );
+            if (sent == -1) {
+                if (errno == EINTR) { continue; }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            session._outHead += sent;
+        }
+        if (session.pending() == 0) {
+            session._out.clear();
+            session._outHead = 0;
+        } else if (session._outHead > readLimit) {
+            session._out.erase( 0, session._outHead );
+            session._outHead = 0;
+        }
+        return true;
+    }
+
+    void close( Session& session ) {
+        int fd = session._fd;
+        ::epoll_ctl( _epoll, EPOLL_CTL_DEL, fd, nullptr );
+        ::close(fd);
+        _sessions[fd].reset();
+        _open--;
+    }
+
+    void release() noexcept {
+        for (auto& session : _sessions) {
+            if (session) { ::close( session->_fd ); }
+        }
+        _sessions.clear();
+        _open = 0;
+        for (int* fd : { &_listen, &_epoll, &_wake }) {
+            if (*fd != -1) { ::close(*fd); }
+            *fd = -1;
+        }
+        if (_bound) { ::unlink( _socketPath.c_str() ); }
+        _bound = false;
+    }
+private:
+    VFSConsoleApp<TContainer>& _app;
+    std::string _socketPath;
+    std::string _cwd;       // where the app stands, set by the last request
+    StringSink _sink;
+    std::ostream _stream;   // writes through _sink into the reply being built
+
+    int _listen = -1;
+    int _epoll = -1;
+    int _wake = -1;         // eventfd written by stop()
+    bool _bound = false;    // the socket file is ours to remove
+    bool _stopped = false;
+    std::vector<std::unique_ptr<Session>> _sessions; // indexed by descriptor
+    size_t _open = 0;
+};
+
+#endif // __linux__
+
+#endif // VFS_SERVER_H
@@ -2,7 +2,23 @@
 #define VFS_CONSOLE_H
 
 #include "VFS.hpp"
+#include "CommandLine.hpp"
+#include "PerfectHash.hpp"
+#include <array>
+#include <charconv>
+#include <chrono>
 #include <iostream>
+#include <string_view>
+
+// what a batch run did, see VFSConsoleApp::runBatch
+struct BatchSummary
+{
+    size_t lines = 0;
+    size_t commands = 0;
+    size_t errors = 0;
+    double seconds = 0;
+    bool stopped = false; // by exit or by the first error
+};
 
 template <template<COrdered,class> class TContainer >
 class VFSConsoleApp
@@ -13,45 +29,32 @@ public:
 
     ~VFSConsoleApp() = default;
 public:
-    void execute( const std::string& input ) {
-        auto inputs = split( removeExtraSpaces(input) );
-        if (inputs.getSize() == 0) {
+    // the first word picks the handler through a perfect hash of the command names, a line that
+    // is a single unknown word opens it as a path. the output of the command goes to out
+    void execute( std::string_view input, std::ostream& out = std::cout ) {
+        _out = &out;
+        CommandLine words( input );
+        if (words.isEmpty()) {
             throw Exception( Exception::ErrorCode::INVALID_INPUT );
-        } else if (inputs.getSize() == 1) {
-            if (inputs[0] == "help" || inputs[0] == "h" ) {
-                printManual();
-            } else if (inputs[0] == "exit" ) {
-                throw ExitSignal();
-            } else {
-                _vfs.open( inputs[0] );
-            }
-        } else if (inputs.getSize() == 2) {
-            if (inputs[0] == "cd") {
-                _vfs.cd( inputs[1] ); 
-            } else if (inputs[0] == "rmdir") {
-                _vfs.rmdir( inputs[1] );
-            } else if (inputs[0] == "remove" || inputs[0] == "rm") {
-                _vfs.remove( inputs[1] );
-            } else if (inputs[0] == "touch") {
-                _vfs.touch( inputs[1] );
-            } else if (inputs[0] == "mkdir") {
-                _vfs.mkdir( inputs[1] );
-            } else {
-                throw Exception( Exception::ErrorCode::INVALID_INPUT );
-            }
-        } else {
-            if (inputs[0] == "move" || inputs[0] == "mv") {
-                _vfs.move( inputs[1], inputs[2] ); 
-            } else if (inputs[0] == "attach") {
-                _vfs.attach( inputs[1], inputs[2] );
-            } else {
+        }
+        auto index = _dispatch.find( words[0] );
+        if (index == _dispatch.absent) {
+            if (words.getSize() != 1) {
                 throw Exception( Exception::ErrorCode::INVALID_INPUT );
             }
+            _vfs.open( std::string( words[0] ));
+            return;
+        }
+        auto& command = _commands[index];
+        auto args = words.getSize() - 1;
+        if (args < command._minArgs || args > command._maxArgs) {
+            throw Exception( Exception::ErrorCode::INVALID_INPUT );
         }
+        (this->*command._run)( words );
     }
 
-    static void showError( const Exception& ex ) {
-        std::cout << ex.what() << std::endl;
+    static void showError( const std::exception& ex ) {
+        std::cout << ex.what() << "\n"; // std::cin is tied to std::cout, the prompt flushes it
     }
 
     static void showStart() {
@@ -65,57 +68,295 @@ public:
         return input;
     }
 
+    void persist( const std::string& imagePath ) {
+        _vfs.persist( imagePath );
+        if (_vfs.skippedRecords() != 0) {
+            std::cerr << std::format( "Warning. {} journal records of {} did not apply.\n", _vfs.skippedRecords(), imagePath );
+        }
+    }
+
+    void useBlobStore() {
+        _vfs.useBlobStore();
+    }
+
+    // the absolute current directory and a way back to it, for sessions sharing one namespace
+    std::string getCWD() const {
+        return _vfs.getCWD();
+    }
+    void setCWD( const std::string& path ) {
+        _vfs.cd( path );
+    }
+
+    // batch mode: no prompts and one large output buffer, flushed when it fills and at the end.
+    // must be called before anything is written
+    static void useBatchOutput() {
+        static char buffer[1 << 20];
+        std::ios::sync_with_stdio(false);
+        std::cin.tie(nullptr);
+        std::cout.rdbuf()->pubsetbuf( buffer, sizeof(buffer) );
+    }
+
+    // runs the commands of a script mapped at once, see runLines
+    BatchSummary runScript( const std::string& path, const bool stopOnError ) {
+        BatchSummary summary;
+        auto start = std::chrono::steady_clock::now();
+        MappedFile script( path );
+        runLines( std::string_view( script.data(), script.size() ), summary, stopOnError );
+        return finish( summary, start );
+    }
+
+    // same for commands read from in, 1 MiB at a time
+    BatchSummary runBatch( std::istream& in, const bool stopOnError ) {
+        constexpr size_t chunk = 1 << 20;
+        BatchSummary summary;
+        auto start = std::chrono::steady_clock::now();
+        std::string buffer;
+        while (!summary.stopped) {
+            auto kept = buffer.size();
+            buffer.resize( kept + chunk );
+            in.read( buffer.data() + kept, chunk );
+            buffer.resize( kept + in.gcount() );
+            if (in.gcount() == 0) { // the last line may lack its newline
+                runLines( buffer, summary, stopOnError );
+                break;
+            }
+            auto end = buffer.rfind('\n');
+            if (end == std::string::npos) { continue; }
+            runLines( std::string_view( buffer ).substr( 0, end + 1 ), summary, stopOnError );
+            buffer.erase( 0, end + 1 );
+        }
+        return finish( summary, start );
+    }
+
+    static void showSummary( const BatchSummary& summary ) {
+        std::cerr << std::format( "{} commands, {} errors in {:.3f} s ({:.0f} ops/s)\n"
+                                , summary.commands, summary.errors, summary.seconds
+                                , summary.seconds > 0 ? summary.commands / summary.seconds : 0.0 );
+    }
+
+    // failures of viewers started in the background are reported with the next prompt
     void showCurrent() {
+        auto failures = _vfs.openFailures();
+        for (size_t i = 0; i < failures.getSize(); i++) {
+            std::cout << failures[i] << "\n";
+        }
         std::cout << _vfs.getCD() << " \033[1;32m?\033[0m ";
     }
 private:
-    ArraySequence<std::string> split( const std::string& input ) {
-        ArraySequence<std::string> res;
-        std::string token;
-        for ( size_t i = 0; i <= input.length(); i++ ) {
-            if ( input[i] != ' ' && input[i] != '\0' ) {
-                token += input[i]; 
+    // one command per line, blank lines and lines starting with # are skipped. errors go to
+    // std::cerr with their line number, so std::cout carries only the output of the commands
+    void runLines( std::string_view lines, BatchSummary& summary, const bool stopOnError ) {
+        while (!lines.empty() && !summary.stopped) {
+            auto end = lines.find('\n');
+            auto line = lines.substr( 0, end );
+            lines.remove_prefix( (end == std::string_view::npos) ? lines.size() : end + 1 );
+            summary.lines++;
+
+            if (line.ends_with('\r')) { line.remove_suffix(1); }
+            auto first = line.find_first_not_of(' ');
+            if (first == std::string_view::npos || line[first] == '#') { continue; }
+
+            summary.commands++;
+            try {
+                execute( line );
+            } catch (ExitSignal& sig) {
+                summary.stopped = true;
+            } catch (std::exception& ex) { // std::filesystem errors too, they must not end the batch
+                summary.errors++;
+                std::cout.flush(); // keeps the error after the output before it
+                std::cerr << "line " << summary.lines << ": " << ex.what() << "\n";
+                summary.stopped = stopOnError;
+            }
+        }
+    }
+
+    BatchSummary& finish( BatchSummary& summary, const std::chrono::steady_clock::time_point start ) {
+        _vfs.sync();
+        std::cout.flush();
+        auto failures = _vfs.openFailures();
+        for (size_t i = 0; i < failures.getSize(); i++) {
+            std::cerr << failures[i] << "\n";
+        }
+        summary.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        return summary;
+    }
+
+    void printManual() {
+        *_out << "VFS Commands:\n";
+        *_out << "  cd <path>              - Change directory\n";
+        *_out << "  ls [path] [--limit N] [--after NAME]\n";
+        *_out << "                         - List directory, a page of N entries after NAME\n";
+        *_out << "  mkdir <path>           - Create directory\n";
+        *_out << "  find <path> [-name PATTERN] [-type f|d]\n";
+        *_out << "                         - Search a subtree, PATTERN may use * ? [a-z]\n";
+        *_out << "  locate <name>          - List entries called name, via the name index\n";
+        *_out << "  locate --ext <.ext>    - List entries with the extension\n";
+        *_out << "  cat <path>             - Print the contents of a file\n";
+        *_out << "  touch <path>           - Create empty file\n";
+        *_out << "  write <path> <text>    - Replace the contents of a file with a line of text\n";
+        *_out << "  append <path> <text>   - Add a line of text to the end of a file\n";
+        *_out << "  attach <vpath> <ppath> - Attach physical file to virtual path\n";
+        *_out << "  rmdir <path>           - Remove directory\n";
+        *_out << "  rm/remove <path>       - Remove file\n";
+        *_out << "  mv/move <from> <to>    - Move file/directory\n";
+        *_out << "  <path>                 - Open file/directory\n";
+        *_out << "  open <path>...         - Open files without waiting for them\n";
+        *_out << "  save <ppath>           - Save the namespace to a binary image\n";
+        *_out << "  load <ppath>           - Replace the namespace with a saved image\n";
+        *_out << "  sync                   - Wait until journaled changes are on disk\n";
+        *_out << "  compact                - Fold the journal into the image\n";
+        *_out << "  stats                  - Show memory footprint\n";
+        *_out << "  help/h                 - Show this manual\n";
+        *_out << "  exit                   - Exit application\n";
+    }
+
+    // ls [path] [--limit N] [--after NAME]
+    void list( const CommandLine& inputs ) {
+        std::string path, after;
+        size_t limit = SIZE_MAX;
+        for (size_t i = 1; i < inputs.getSize(); i++) {
+            if (inputs[i] == "--limit" && i + 1 < inputs.getSize()) {
+                auto count = inputs[++i];
+                auto res = std::from_chars( count.data(), count.data() + count.size(), limit );
+                if (res.ec != std::errc() || res.ptr != count.data() + count.size() || limit == 0) {
+                    throw Exception( Exception::ErrorCode::INVALID_INPUT );
+                }
+            } else if (inputs[i] == "--after" && i + 1 < inputs.getSize()) {
+                after = inputs[++i];
+            } else if (path.empty() && !inputs[i].starts_with("--")) {
+                path = inputs[i];
             } else {
-                res.append(token);
-                token = "";
+                throw Exception( Exception::ErrorCode::INVALID_INPUT );
             }
         }
-        return res;
-    }
-
-    std::string removeExtraSpaces( const std::string& str ) {
-        std::string res;
-        bool atBegin = true;
-        for ( size_t i = 0; i < str.length(); i++ ) { 
-            if        (str[i] == ' ' && (str[i+1] == ' ' || str[i+1] == '\0')) {
-                continue;
-            } else if (str[i] == ' ' && (str[i+1] != ' ' || str[i+1] != '\0') && !atBegin) {
-                res += str[i];
-            } else if (str[i] != ' ' && atBegin) {
-                atBegin = false;
-                res += str[i];
-            } else if (!atBegin) {
-                res += str[i];
+        auto next = _vfs.ls( *_out, path, limit, after );
+        if (!next.empty()) {
+            *_out << "-- more, continue with --after " << next << "\n";
+        }
+    }
+
+    // find <root> [-name PATTERN] [-type f|d]
+    void find( const CommandLine& inputs ) {
+        std::string pattern = "*";
+        auto type = VFS<TContainer>::FindType::any;
+        for (size_t i = 2; i < inputs.getSize(); i++) {
+            if (inputs[i] == "-name" && i + 1 < inputs.getSize()) {
+                pattern = inputs[++i];
+            } else if (inputs[i] == "-type" && i + 1 < inputs.getSize() && inputs[i + 1] == "f") {
+                type = VFS<TContainer>::FindType::file;
+                i++;
+            } else if (inputs[i] == "-type" && i + 1 < inputs.getSize() && inputs[i + 1] == "d") {
+                type = VFS<TContainer>::FindType::dir;
+                i++;
+            } else {
+                throw Exception( Exception::ErrorCode::INVALID_INPUT );
             }
         }
-        return res;
+        _vfs.find( *_out, std::string( inputs[1] ), pattern, type );
     }
 
-    void printManual() {
-        std::cout << "VFS Commands:\n";
-        std::cout << "  cd <path>              - Change directory\n";
-        std::cout << "  mkdir <path>           - Create directory\n";
-        std::cout << "  touch <path>           - Create empty file\n";
-        std::cout << "  attach <vpath> <ppath> - Attach physical file to virtual path\n";
-        std::cout << "  rmdir <path>           - Remove directory\n";
-        std::cout << "  rm/remove <path>       - Remove file\n";
-        std::cout << "  mv/move <from> <to>    - Move file/directory\n";
-        std::cout << "  <path>                 - Open file/directory\n";
-        std::cout << "  help/h                 - Show this manual\n";
-        std::cout << "  exit                   - Exit application\n";
+    void printStats() {
+        auto usage = _vfs.memoryUsage();
+        *_out << "Entries:        " << _vfs.nodeCount() << "\n";
+        *_out << "Node structs:   " << usage.nodes << " B\n";
+        *_out << "Payload:        " << usage.payload << " B\n";
+        *_out << "Slack:          " << usage.slack << " B\n";
+        *_out << "Control blocks: " << usage.controlBlocks << " B\n";
+        *_out << "Total:          " << usage.total() << " B\n";
     }
+    // handlers of the dispatch table, the arity is checked before they run
+    void open( const CommandLine& words ) {
+        for (size_t i = 1; i < words.getSize(); i++) { _vfs.open( std::string( words[i] )); }
+    }
+    void help( const CommandLine& ) { printManual(); }
+    void stats( const CommandLine& ) { printStats(); }
+    void sync( const CommandLine& ) { _vfs.sync(); }
+    void compact( const CommandLine& ) { _vfs.compact(); }
+    void exit( const CommandLine& ) { throw ExitSignal(); }
+    void cd( const CommandLine& words ) { _vfs.cd( std::string( words[1] )); }
+    void rmdir( const CommandLine& words ) { _vfs.rmdir( std::string( words[1] )); }
+    void remove( const CommandLine& words ) { _vfs.remove( std::string( words[1] )); }
+    void touch( const CommandLine& words ) { _vfs.touch( std::string( words[1] )); }
+    void mkdir( const CommandLine& words ) { _vfs.mkdir( std::string( words[1] )); }
+    void save( const CommandLine& words ) { _vfs.save( std::string( words[1] )); }
+    void load( const CommandLine& words ) { _vfs.load( std::string( words[1] )); }
+    void move( const CommandLine& words ) { _vfs.move( std::string( words[1] ), std::string( words[2] )); }
+    void attach( const CommandLine& words ) { _vfs.attach( std::string( words[1] ), std::string( words[2] )); }
+
+    void cat( const CommandLine& words ) {
+        auto view = _vfs.read( std::string( words[1] ));
+        _out->write( view.data(), view.size() );
+    }
+
+    // locate <name> | locate --ext <.ext>
+    void locate( const CommandLine& words ) {
+        if (words.getSize() == 2) {
+            _vfs.locate( *_out, std::string( words[1] ));
+        } else if (words[1] == "--ext") {
+            _vfs.locate( *_out, std::string( words[2] ), true );
+        } else {
+            throw Exception( Exception::ErrorCode::INVALID_INPUT );
+        }
+    }
+
+    // write|append <path> <text>...: the words are joined by single spaces and end with a newline
+    void write( const CommandLine& words ) {
+        std::string text;
+        for (size_t i = 2; i < words.getSize(); i++) {
+            text += words[i];
+            text += (i + 1 < words.getSize()) ? ' ' : '\n';
+        }
+        if (words[0] == "write") {
+            _vfs.write( std::string( words[1] ), text );
+        } else {
+            _vfs.append( std::string( words[1] ), text );
+        }
+    }
+private:
+    struct Command
+    {
+        std::string_view _name;
+        size_t _minArgs;
+        size_t _maxArgs;
+        void (VFSConsoleApp::*_run)( const CommandLine& words );
+    };
+
+    static constexpr size_t many = CommandLine::maxWords;
+    static constexpr std::array _commands = {
+        Command{ "ls",      0, many, &VFSConsoleApp::list },
+        Command{ "find",    1, many, &VFSConsoleApp::find },
+        Command{ "open",    1, many, &VFSConsoleApp::open },
+        Command{ "help",    0, 0,    &VFSConsoleApp::help },
+        Command{ "h",       0, 0,    &VFSConsoleApp::help },
+        Command{ "stats",   0, 0,    &VFSConsoleApp::stats },
+        Command{ "sync",    0, 0,    &VFSConsoleApp::sync },
+        Command{ "compact", 0, 0,    &VFSConsoleApp::compact },
+        Command{ "exit",    0, 0,    &VFSConsoleApp::exit },
+        Command{ "cd",      1, 1,    &VFSConsoleApp::cd },
+        Command{ "rmdir",   1, 1,    &VFSConsoleApp::rmdir },
+        Command{ "remove",  1, 1,    &VFSConsoleApp::remove },
+        Command{ "rm",      1, 1,    &VFSConsoleApp::remove },
+        Command{ "touch",   1, 1,    &VFSConsoleApp::touch },
+        Command{ "mkdir",   1, 1,    &VFSConsoleApp::mkdir },
+        Command{ "save",    1, 1,    &VFSConsoleApp::save },
+        Command{ "load",    1, 1,    &VFSConsoleApp::load },
+        Command{ "cat",     1, 1,    &VFSConsoleApp::cat },
+        Command{ "locate",  1, 2,    &VFSConsoleApp::locate },
+        Command{ "move",    2, 2,    &VFSConsoleApp::move },
+        Command{ "mv",      2, 2,    &VFSConsoleApp::move },
+        Command{ "attach",  2, 2,    &VFSConsoleApp::attach },
+        Command{ "write",   2, many, &VFSConsoleApp::write },
+        Command{ "append",  2, many, &VFSConsoleApp::write },
+    };
+
+    static constexpr PerfectHash<_commands.size(), 64> _dispatch{ []() {
+        std::array<std::string_view,_commands.size()> names;
+        for (size_t i = 0; i < _commands.size(); i++) { names[i] = _commands[i]._name; }
+        return names;
+    }() };
 private:
     VFS<TContainer> _vfs;
+    std::ostream* _out = &std::cout; // of the command being executed
 };
 
 #endif // VFS_CONSOLE_H
\ No newline at end of file
@@ -36,6 +36,7 @@ public:
     ArraySequence<T> subArray( const size_t startIndex, const size_t endIndex ) const;
     Sequence<T>* getSubSequence( const size_t startIndex, const size_t endIndex ) const override;
     Sequence<T>* concat( const Sequence<T>& other ) override;
+    void reserve( const size_t capacity );
     void map( const std::function<T(T&)>& func );
     void where( const std::function<bool(T)>& func );
 public:
@@ -44,6 +45,7 @@ public:
 public:
     bool isEmpty() const override;
     size_t getSize() const override;
+    size_t allocatedBytes() const;
 public:
     Sequence<T>* appendImmutable( const T& value ) const override;
     Sequence<T>* prependImmutable( const T& value ) const override;
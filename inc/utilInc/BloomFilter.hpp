@@ -0,0 +1,57 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <cstdint>
+#include <functional>
+#include "MemoryUsage.hpp"
+#include "util.hpp"
+
+// blocked Bloom filter: a key sets 8 bits in a single 64 byte block, one bit per 64 bit word,
+// so a query touches one cache line. it answers "definitely absent" or "maybe present".
+// bits cannot be cleared, so removals are only counted and the owner rebuilds the filter
+// from its keys once needsRebuild() reports that stale or excess keys made it too inaccurate.
+// a default constructed filter has no blocks and reports every key as maybe present.
+template <typename K, typename Hash = std::hash<K>>
+class BloomFilter
+{
+private:
+    struct alignas(64) Block {
+        std::uint64_t _words[8];
+    };
+    static const size_t _bitsPerKey = 12; // about 0.5% false positives at full load
+    static const size_t _keysPerBlock = sizeof(Block) * 8 / _bitsPerKey;
+public:
+    BloomFilter();
+    explicit BloomFilter( const size_t expected ); // sized for expected keys
+
+    BloomFilter( const BloomFilter<K,Hash>& other ) = delete;
+    BloomFilter<K,Hash>& operator=( const BloomFilter<K,Hash>& other ) = delete;
+
+    BloomFilter( BloomFilter<K,Hash>&& other ) noexcept;
+    BloomFilter<K,Hash>& operator=( BloomFilter<K,Hash>&& other ) noexcept;
+
+    ~BloomFilter();
+public:
+    void add( const K& key ) noexcept;
+    bool mayContain( const K& key ) const noexcept;
+    void noteRemoved() noexcept { _removed++; }
+
+    bool isEnabled() const noexcept { return _blockCount != 0; }
+    bool needsRebuild() const noexcept; // overfilled, or most of the added keys are gone
+    size_t capacity() const noexcept { return _blockCount * _keysPerBlock; }
+    MemoryUsage memoryUsage() const noexcept;
+private:
+    static size_t mix( size_t hash ) noexcept;
+    static std::uint64_t bitOf( const std::uint32_t hash, const size_t word ) noexcept;
+    size_t blockOf( const size_t hash ) const noexcept;
+private:
+    Block* _blocks;
+    size_t _blockCount; // a power of two
+    size_t _added;
+    size_t _removed;
+    Hash _hash;
+};
+
+#include "BloomFilter.tpp"
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,59 @@
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+#include <array>
+#include <string_view>
+#include "util.hpp"
+
+// the words of one command line as views into it, nothing is copied or allocated. words are
+// separated by spaces and tabs; a word starting with " or ' runs to the matching quote, which
+// lets names contain spaces, and is stored without its quotes. the line must outlive the words
+class CommandLine
+{
+public:
+    static constexpr size_t maxWords = 64;
+
+    explicit CommandLine( std::string_view line ) : _size( 0 ) {
+        size_t at = 0;
+        while (true) {
+            while (at < line.size() && isBlank( line[at] )) { at++; }
+            if (at == line.size()) { break; }
+            if (_size == maxWords) {
+                throw Exception( Exception::ErrorCode::INVALID_INPUT );
+            }
+
+            size_t start = at, end;
+            if (line[at] == '"' || line[at] == '\'') {
+                auto close = line.find( line[at], at + 1 );
+                if (close == std::string_view::npos) {
+                    throw Exception( "Error. Unterminated quote." );
+                }
+                start = at + 1;
+                end = close;
+                at = close + 1;
+            } else {
+                while (at < line.size() && !isBlank( line[at] )) { at++; }
+                end = at;
+            }
+            _words[_size++] = line.substr( start, end - start );
+        }
+    }
+public:
+    std::string_view operator[]( const size_t index ) const {
+        if (index >= _size) {
+            throw Exception( Exception::ErrorCode::INDEX_OUT_OF_BOUNDS );
+        }
+        return _words[index];
+    }
+    size_t getSize() const noexcept { return _size; }
+    bool isEmpty() const noexcept { return _size == 0; }
+private:
+    static constexpr bool isBlank( const char ch ) noexcept {
+        return ch == ' ' || ch == '\t';
+    }
+private:
+    std::array<std::string_view,maxWords> _words;
+    size_t _size;
+};
+
+#endif // COMMAND_LINE_H
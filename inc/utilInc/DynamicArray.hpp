@@ -2,6 +2,7 @@
 #define DYNAMIC_ARRAY_H
 
 #include "util.hpp"
+#include <algorithm>
 #include <functional>
 
 template <typename T> 
@@ -28,6 +29,7 @@ public:
     void swap( const size_t pos1, const size_t pos2 );
     DynamicArray<T> subArray( const size_t startIndex, const size_t endIndex ) const;
     DynamicArray<T>* concat( const DynamicArray<T>& other );
+    void reserve( const size_t capacity ); // neither grows nor shrinks the buffer while size stays within capacity
 private:
     void extend( const int sizeDiff );
     void shrink( const int sizeDiff );
@@ -38,6 +40,7 @@ public:
 public:
     size_t getSize() const;
     bool isEmpty() const;
+    size_t allocatedBytes() const; // whole buffer including the recentering head-room
 public:
     DynamicArray<T>* appendImmutable( const T& value ) const;
     DynamicArray<T>* prependImmutable( const T& value ) const;
@@ -59,6 +62,7 @@ private:
     size_t _size;
     size_t _capacity;
     size_t _offset;
+    size_t _reserved = 0;
 };
 
 #include "DynamicArray.tpp"
@@ -0,0 +1,287 @@
+#ifndef FILE_WRITER_H
+#define FILE_WRITER_H
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <cerrno>
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "util.hpp"
+
+// how a FileWriter stages its data on the way to the disk
+struct WritePolicy
+{
+    size_t bufferSize = size_t(1) << 20; // staged bytes per write call, rounded up to the alignment
+    size_t preallocate = 0;               // expected length, reserved up front where fallocate exists
+    bool direct = false;                  // bypass the page cache with O_DIRECT where supported
+};
+
+// buffered sequential writer of one file. data is staged in an aligned buffer and handed to the
+// kernel a buffer at a time, a write larger than the buffer skips it. with direct set the aligned
+// blocks go out with O_DIRECT and only the unaligned tail through the page cache; a file system
+// refusing O_DIRECT is written normally. a replacing writer fills a temporary file beside path
+// and renames it over path on close(), so readers and mappings of the old contents never see a
+// torn file. an appending writer creates a missing file. a writer destroyed without close()
+// keeps what it wrote in append mode and discards it in replace mode
+class FileWriter
+{
+public:
+    enum class Mode { replace, append };
+    static constexpr size_t alignment = 4096;
+
+    FileWriter( const std::string& path, const Mode mode, const WritePolicy& policy = WritePolicy() )
+    : _path( path ), _mode( mode ), _policy( policy ) {
+        _capacity = (std::max( _policy.bufferSize, alignment ) + alignment - 1) / alignment * alignment;
+        _buffer = static_cast<char*>( std::aligned_alloc( alignment, _capacity ));
+        if (!_buffer) { throw std::bad_alloc(); }
+        try {
+            openFile();
+        } catch (...) {
+            std::free(_buffer);
+            throw;
+        }
+    }
+
+    FileWriter( const FileWriter& other ) = delete;
+    FileWriter& operator=( const FileWriter& other ) = delete;
+
+    FileWriter( FileWriter&& other ) noexcept { take(other); }
+    FileWriter& operator=( FileWriter&& other ) noexcept {
+        if (this != &other) {
+            abandon();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~FileWriter() { abandon(); }
+public:
+    void write( const char* data, size_t size ) {
+        if (!isOpen()) {
+            throw Exception( std::format( "Error. {} is closed.", _path ));
+        }
+        _written += size;
+        while (size != 0) {
+            if (_used == 0 && !_direct && size >= _capacity) {
+                writeOut( data, size );
+                return;
+            }
+            auto chunk = std::min( size, _capacity - _used );
+            std::memcpy( _buffer + _used, data, chunk );
+            _used += chunk;
+            data += chunk;
+            size -= chunk;
+            if (_used == _capacity) { drain(false); }
+        }
+    }
+    void write( std::string_view data ) {
+        write( data.data(), data.size() );
+    }
+
+    // hands every staged byte to the kernel, an unaligned tail ends direct writing
+    void flush() {
+        if (isOpen()) { drain(true); }
+    }
+
+    // flushes, drops the unused preallocation and, when replacing, puts the file in place
+    void close() {
+        if (!isOpen()) { return; }
+        try {
+            drain(true);
+            finish();
+        } catch (...) {
+            abandon();
+            throw;
+        }
+        release();
+    }
+
+    bool isOpen() const noexcept { return _buffer != nullptr; }
+    size_t written() const noexcept { return _written; }
+    const std::string& path() const noexcept { return _path; }
+private:
+    // in direct mode only whole blocks leave unless all is set, the rest moves to the front
+    void drain( const bool all ) {
+        size_t out = _used;
+        if (_direct && !all) { out -= out % alignment; }
+        if (_direct && out % alignment != 0) { setDirect(false); }
+        if (out != 0) { writeOut( _buffer, out ); }
+        std::memmove( _buffer, _buffer + out, _used - out );
+        _used -= out;
+    }
+
+    void take( FileWriter& other ) noexcept {
+        _path = std::move(other._path);
+        _temp = std::move(other._temp);
+        _mode = other._mode;
+        _policy = other._policy;
+        _buffer = std::exchange( other._buffer, nullptr );
+        _capacity = other._capacity;
+        _used = std::exchange( other._used, 0 );
+        _written = std::exchange( other._written, 0 );
+        _offset = other._offset;
+        _direct = other._direct;
+        _preallocated = other._preallocated;
+      #if defined(__unix__) || defined(__APPLE__)
+        _fd = std::exchange( other._fd, -1 );
+      #else
+        _ofs = std::move(other._ofs);
+      #endif
+    }
+
+    // the destructor path: nothing may throw, a replacement is thrown away
+    void abandon() noexcept {
+        if (!isOpen()) { return; }
+        if (_mode == Mode::append) {
+            try { drain(true); } catch (...) {}
+        }
+        closeFile();
+        if (_mode == Mode::replace) {
+            std::error_code ec;
+            std::filesystem::remove( _temp, ec );
+        }
+        release();
+    }
+
+    void release() noexcept {
+        std::free(_buffer);
+        _buffer = nullptr;
+        _used = 0;
+    }
+
+  #if defined(__unix__) || defined(__APPLE__)
+    void openFile() {
+        if (_mode == Mode::append) {
+            _fd = ::open( _path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666 );
+        } else {
+            struct stat info;
+            bool existing = ::stat( _path.c_str(), &info ) == 0;
+            for (size_t n = 0; _fd == -1; n++) { // the first free name, the file keeps its mode
+                _temp = std::format( "{}.{}.tmp", _path, n );
+                _fd = ::open( _temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666 );
+                if (_fd == -1 && errno != EEXIST) { break; }
+            }
+            if (_fd != -1 && existing) { ::fchmod( _fd, info.st_mode & 07777 ); }
+        }
+        if (_fd == -1) {
+            throw Exception( std::format( "Error. Unable to open {} for writing.", _path ));
+        }
+        struct stat info;
+        _offset = (::fstat( _fd, &info ) == 0) ? static_cast<size_t>(info.st_size) : 0;
+      #if defined(__linux__)
+        if (_policy.preallocate != 0) {
+            _preallocated = ::fallocate( _fd, 0, _offset, _policy.preallocate ) == 0;
+        }
+      #endif
+        if (_policy.direct && _offset % alignment == 0) { setDirect(true); }
+    }
+
+    void setDirect( [[maybe_unused]] const bool on ) noexcept {
+      #if defined(O_DIRECT)
+        int flags = ::fcntl( _fd, F_GETFL );
+        if (flags != -1 && ::fcntl( _fd, F_SETFL, on ? (flags | O_DIRECT) : (flags & ~O_DIRECT) ) == 0) {
+            _direct = on;
+        }
+      #endif
+    }
+
+    void writeOut( const char* data, size_t size ) {
+        while (size != 0) {
+            auto written = ::pwrite( _fd, data, size, _offset );
+            if (written == -1) {
+                if (errno == EINTR) { continue; }
+                if (errno == EINVAL && _direct) { // accepted by fcntl but not by the file system
+                    setDirect(false);
+                    continue;
+                }
+                throw Exception( std::format( "Error. Unable to write {}.", _path ));
+            }
+            data += written;
+            size -= written;
+            _offset += written;
+        }
+    }
+
+    void finish() {
+        bool ok = !_preallocated || ::ftruncate( _fd, _offset ) == 0;
+        ok = (::close( std::exchange( _fd, -1 )) == 0) && ok;
+        if (ok && _mode == Mode::replace) { ok = ::rename( _temp.c_str(), _path.c_str() ) == 0; }
+        if (!ok) {
+            throw Exception( std::format( "Error. Unable to write {}.", _path ));
+        }
+    }
+
+    void closeFile() noexcept {
+        if (_fd == -1) { return; }
+        if (_preallocated) { (void)::ftruncate( _fd, _offset ); }
+        ::close( std::exchange( _fd, -1 ));
+    }
+  #else
+    void openFile() {
+        if (_mode == Mode::append) {
+            _ofs.open( _path, std::ios::binary | std::ios::app );
+        } else {
+            for (size_t n = 0; _temp.empty() || std::filesystem::exists(_temp); n++) {
+                _temp = std::format( "{}.{}.tmp", _path, n );
+            }
+            _ofs.open( _temp, std::ios::binary | std::ios::trunc );
+        }
+        if (!_ofs) {
+            throw Exception( std::format( "Error. Unable to open {} for writing.", _path ));
+        }
+    }
+
+    void setDirect( const bool ) noexcept {}
+
+    void writeOut( const char* data, const size_t size ) {
+        if (!_ofs.write( data, size )) {
+            throw Exception( std::format( "Error. Unable to write {}.", _path ));
+        }
+        _offset += size;
+    }
+
+    void finish() {
+        _ofs.close();
+        if (!_ofs) {
+            throw Exception( std::format( "Error. Unable to write {}.", _path ));
+        }
+        if (_mode == Mode::replace) { std::filesystem::rename( _temp, _path ); }
+    }
+
+    void closeFile() noexcept {
+        _ofs.close();
+    }
+  #endif
+private:
+    std::string _path;
+    std::string _temp; // what a replacing writer fills
+    Mode _mode = Mode::append;
+    WritePolicy _policy;
+
+    char* _buffer = nullptr; // null once closed
+    size_t _capacity = 0;
+    size_t _used = 0;
+    size_t _written = 0;
+    size_t _offset = 0;      // of the next byte in the file
+    bool _direct = false;
+    bool _preallocated = false;
+  #if defined(__unix__) || defined(__APPLE__)
+    int _fd = -1;
+  #else
+    std::ofstream _ofs;
+  #endif
+};
+
+#endif // FILE_WRITER_H
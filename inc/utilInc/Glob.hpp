@@ -0,0 +1,65 @@
+#ifndef GLOB_H
+#define GLOB_H
+
+#include <string_view>
+
+// matches a whole name against a shell wildcard: * is any run of characters, ? is one character,
+// [abc], [a-z] and [!a-z] are classes. a malformed class matches its [ literally
+inline bool globClass( std::string_view pattern, size_t& pos, const char ch, bool& matched ) noexcept {
+    auto at = pos + 1;
+    bool negated = at < pattern.size() && pattern[at] == '!';
+    if (negated) { at++; }
+
+    bool hit = false;
+    for (bool first = true; at < pattern.size() && (first || pattern[at] != ']'); first = false) {
+        if (at + 2 < pattern.size() && pattern[at + 1] == '-' && pattern[at + 2] != ']') {
+            hit |= pattern[at] <= ch && ch <= pattern[at + 2];
+            at += 3;
+        } else {
+            hit |= pattern[at] == ch;
+            at++;
+        }
+    }
+    if (at >= pattern.size()) { return false; } // no closing ]
+    pos = at + 1;
+    matched = hit != negated;
+    return true;
+}
+
+inline bool globMatch( std::string_view pattern, std::string_view name ) noexcept {
+    size_t p = 0, n = 0;
+    size_t starP = std::string_view::npos, starN = 0; // resume point of the last *
+
+    while (n < name.size()) {
+        bool matched = false;
+        size_t next = p;
+        if (p < pattern.size()) {
+            if (pattern[p] == '*') {
+                starP = p++;
+                starN = n;
+                continue;
+            } else if (pattern[p] == '?') {
+                matched = true;
+                next = p + 1;
+            } else if (pattern[p] == '[' && globClass( pattern, next, name[n], matched )) {
+                // next and matched are set by the class
+            } else {
+                matched = pattern[p] == name[n];
+                next = p + 1;
+            }
+        }
+        if (matched) {
+            p = next;
+            n++;
+        } else if (starP != std::string_view::npos) { // let the last * swallow one more character
+            p = starP + 1;
+            n = ++starN;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') { p++; }
+    return p == pattern.size();
+}
+
+#endif // GLOB_H
@@ -0,0 +1,115 @@
+#ifndef INTRUSIVE_PTR_H
+#define INTRUSIVE_PTR_H
+
+#include <concepts>
+#include <type_traits>
+#include <utility>
+#include "util.hpp"
+#include "RefCountPolicy.hpp"
+
+template <typename T>
+class IntrusivePtr;
+
+// mixin keeping the reference count inside the object itself.
+// copies of an object start with a fresh count: references belong to an address, not to a value
+template <typename Policy = SingleThreaded>
+class IntrusiveRefCounter
+{
+public:
+    long refCount() const noexcept { return Policy::load(_refs); }
+protected:
+    IntrusiveRefCounter() noexcept : _refs( 0 ) {}
+
+    IntrusiveRefCounter( const IntrusiveRefCounter& ) noexcept : _refs( 0 ) {}
+    IntrusiveRefCounter& operator=( const IntrusiveRefCounter& ) noexcept { return *this; }
+
+    ~IntrusiveRefCounter() = default;
+private:
+    void acquireRef() const noexcept { Policy::increment(_refs); }
+    bool releaseRef() const noexcept { return Policy::decrement(_refs) == 0; }
+
+    mutable typename Policy::TCounter _refs;
+
+    template <typename T>
+    friend class IntrusivePtr;
+};
+
+// one pointer wide, no control block: T has to derive from IntrusiveRefCounter.
+// since the count lives in the object, IntrusivePtr<T>(this) is always safe for a managed object
+template <typename T>
+class IntrusivePtr
+{
+public:
+    IntrusivePtr() noexcept : _ptr( nullptr ) {}
+    IntrusivePtr( std::nullptr_t ) noexcept : _ptr( nullptr ) {}
+    explicit IntrusivePtr( T* ptr ) noexcept;
+
+    IntrusivePtr( const IntrusivePtr<T>& other ) noexcept;
+    IntrusivePtr<T>& operator=( const IntrusivePtr<T>& other ) noexcept;
+    IntrusivePtr( IntrusivePtr<T>&& other ) noexcept;
+    IntrusivePtr<T>& operator=( IntrusivePtr<T>&& other ) noexcept;
+
+    IntrusivePtr<T>& operator=( T* ptr ) noexcept;
+
+    ~IntrusivePtr();
+public:
+    template <typename T2> requires (std::is_base_of_v<T,T2>)
+    IntrusivePtr( const IntrusivePtr<T2>& other ) noexcept : IntrusivePtr( static_cast<T*>( other._ptr ) ) {}
+    template <typename T2> requires (std::is_base_of_v<T,T2>)
+    IntrusivePtr<T>& operator=( const IntrusivePtr<T2>& other ) noexcept;
+
+    template <typename T2> requires (std::is_base_of_v<T,T2>)
+    IntrusivePtr( IntrusivePtr<T2>&& other ) noexcept : _ptr( other._ptr ) { other._ptr = nullptr; }
+    template <typename T2> requires (std::is_base_of_v<T,T2>)
+    IntrusivePtr<T>& operator=( IntrusivePtr<T2>&& other ) noexcept;
+public:
+    operator T*() const noexcept {
+        return _ptr;
+    }
+    T* operator->() noexcept {
+        return _ptr;
+    }
+    const T* operator->() const noexcept {
+        return _ptr;
+    }
+
+    T& operator*();
+    const T& operator*() const;
+
+    operator bool() const noexcept;
+public:
+    T* get() const noexcept { return _ptr; }
+
+    void reset() noexcept;
+    void swap( IntrusivePtr<T>& other ) noexcept;
+
+    long getCount() const noexcept {
+        return (_ptr) ? _ptr->refCount() : 0;
+    }
+public:
+    bool operator==( const IntrusivePtr<T>& other ) const noexcept { return _ptr == other._ptr; }
+    bool operator==( T* const& other ) const noexcept { return _ptr == other; }
+    bool operator!=( const IntrusivePtr<T>& other ) const noexcept { return _ptr != other._ptr; }
+    bool operator!=( T* const& other ) const noexcept { return _ptr != other; }
+private:
+    static void acquire( T* ptr ) noexcept;
+    static void release( T* ptr ) noexcept;
+    static void destroy( T* ptr ) noexcept;
+private:
+    T* _ptr;
+
+    template <typename T2>
+    friend class IntrusivePtr;
+};
+
+template <typename T, typename ... Ts>
+IntrusivePtr<T> makeIntrusive( Ts&& ... args ) requires (!std::is_abstract_v<T>) {
+    return IntrusivePtr<T>( new T( std::forward<Ts>(args)... ));
+}
+
+template <typename T, typename ... Ts>
+IntrusivePtr<T> makeIntrusive( Ts&& ... args ) requires (std::is_abstract_v<T>) = delete;
+
+#include "IntrusivePtr.tpp"
+
+#endif // INTRUSIVE_PTR_H
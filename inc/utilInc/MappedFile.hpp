@@ -0,0 +1,133 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#else
+  #include <chrono>
+  #include <filesystem>
+  #include <fstream>
+  #include <iterator>
+#endif
+#include <format>
+#include <string>
+#include "util.hpp"
+
+// read-only view of a whole file. on POSIX systems the file is mapped and pages are read
+// on first touch, elsewhere it is read into memory at once. an empty file has no data.
+class MappedFile
+{
+public:
+    // how the pages are going to be read, a hint for the read-ahead of the kernel
+    enum class Access { normal, sequential, random };
+
+    explicit MappedFile( const std::string& path, const Access access = Access::sequential )
+    : _data( nullptr ), _size( 0 ), _path( path ) {
+      #if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+        if (fd == -1) {
+            throw Exception( std::format( "Error. Unable to open {}.", path ));
+        }
+        struct stat info;
+        if (::fstat( fd, &info ) == -1) {
+            ::close(fd);
+            throw Exception( std::format( "Error. Unable to stat {}.", path ));
+        }
+        _size = static_cast<size_t>( info.st_size );
+        _stamp = stampOf(info);
+        if (_size != 0) {
+            void* map = ::mmap( nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if (map == MAP_FAILED) {
+                ::close(fd);
+                throw Exception( std::format( "Error. Unable to map {}.", path ));
+            }
+            _data = static_cast<const char*>(map);
+            advise(access);
+        }
+        _fd = fd; // kept for isCurrent(), the mapping alone would keep the file referenced
+      #else
+        std::ifstream ifs( path, std::ios::binary );
+        if (!ifs) {
+            throw Exception( std::format( "Error. Unable to open {}.", path ));
+        }
+        _buffer.assign( std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() );
+        _data = _buffer.data();
+        _size = _buffer.size();
+        _stamp = stampOf(path);
+      #endif
+    }
+
+    MappedFile( const MappedFile& other ) = delete;
+    MappedFile& operator=( const MappedFile& other ) = delete;
+
+    ~MappedFile() {
+      #if defined(__unix__) || defined(__APPLE__)
+        if (_data) { ::munmap( const_cast<char*>(_data), _size ); }
+        if (_fd != -1) { ::close(_fd); }
+      #endif
+    }
+public:
+    const char* data() const noexcept { return _data; }
+    size_t size() const noexcept { return _size; }
+    const std::string& path() const noexcept { return _path; }
+
+    void advise( [[maybe_unused]] const Access access ) const noexcept {
+      #if defined(__unix__) || defined(__APPLE__)
+        if (!_data) { return; }
+        int advice = (access == Access::sequential) ? MADV_SEQUENTIAL
+                   : (access == Access::random)     ? MADV_RANDOM : MADV_NORMAL;
+        ::madvise( const_cast<char*>(_data), _size, advice );
+      #endif
+    }
+
+    // false once the mapped file was written, truncated or deleted. a file renamed over the
+    // path is not noticed, the check asks the open descriptor rather than walking the path
+    bool isCurrent() const {
+      #if defined(__unix__) || defined(__APPLE__)
+        struct stat info;
+        return ::fstat( _fd, &info ) == 0 && info.st_nlink != 0 && stampOf(info) == _stamp;
+      #else
+        return stampOf(_path) == _stamp;
+      #endif
+    }
+private:
+    struct Stamp {
+        unsigned long long _size = 0;
+        long long _modified = 0; // nanoseconds
+        bool operator==( const Stamp& other ) const = default;
+    };
+
+  #if defined(__unix__) || defined(__APPLE__)
+    static Stamp stampOf( const struct stat& info ) noexcept {
+      #if defined(__APPLE__)
+        auto& modified = info.st_mtimespec;
+      #else
+        auto& modified = info.st_mtim;
+      #endif
+        return Stamp{ static_cast<unsigned long long>(info.st_size)
+                    , static_cast<long long>(modified.tv_sec) * 1000000000LL + modified.tv_nsec };
+    }
+  #else
+    static Stamp stampOf( const std::string& path ) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size( path, ec );
+        auto modified = std::filesystem::last_write_time( path, ec ).time_since_epoch();
+        return Stamp{ size, std::chrono::duration_cast<std::chrono::nanoseconds>(modified).count() };
+    }
+  #endif
+private:
+    const char* _data;
+    size_t _size;
+    std::string _path;
+    Stamp _stamp;
+  #if defined(__unix__) || defined(__APPLE__)
+    int _fd = -1;
+  #else
+    std::string _buffer;
+  #endif
+};
+
+#endif // MAPPED_FILE_H
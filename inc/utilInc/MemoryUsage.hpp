@@ -0,0 +1,43 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+#include <string>
+#include "Pair.hpp"
+
+// byte breakdown reported by memoryUsage() of containers:
+// nodes - node structs and child links, payload - stored keys and values,
+// slack - allocated but unused array capacity, controlBlocks - reference counters.
+struct MemoryUsage
+{
+    size_t nodes = 0;
+    size_t payload = 0;
+    size_t slack = 0;
+    size_t controlBlocks = 0;
+
+    size_t total() const noexcept { return nodes + payload + slack + controlBlocks; }
+
+    MemoryUsage& operator+=( const MemoryUsage& other ) noexcept {
+        nodes += other.nodes;
+        payload += other.payload;
+        slack += other.slack;
+        controlBlocks += other.controlBlocks;
+        return *this;
+    }
+};
+
+// heap bytes a value owns beyond its own sizeof
+template <typename T>
+size_t ownedBytes( const T& ) noexcept { return 0; }
+
+inline size_t ownedBytes( const std::string& str ) noexcept {
+    // short strings are kept in the inline buffer
+    return ( str.capacity() > std::string().capacity() ) ? str.capacity() + 1 : 0;
+}
+
+template <typename T1, typename T2>
+size_t ownedBytes( const Pair<T1,T2>& pair ) noexcept {
+    return ownedBytes( pair.first() ) + ownedBytes( pair.second() );
+}
+
+#endif // MEMORY_USAGE_H
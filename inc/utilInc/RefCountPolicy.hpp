@@ -0,0 +1,55 @@
+#ifndef REFCOUNT_POLICY_H
+#define REFCOUNT_POLICY_H
+
+#include <atomic>
+
+// counter policies for RefCount/SharedPtr/WeakPtr.
+// each policy provides the counter type and the operations performed on it:
+// increment() is only called by an owner of an existing reference, decrement() returns the new value,
+// incrementIfNonZero() takes a new reference only if the count has not dropped to zero yet (WeakPtr::lock()).
+
+// plain counters for pointers that never cross threads
+struct SingleThreaded
+{
+    using TCounter = long;
+
+    static long load( const TCounter& counter ) noexcept { return counter; }
+    static void increment( TCounter& counter ) noexcept { counter++; }
+    static long decrement( TCounter& counter ) noexcept { return --counter; }
+    static bool incrementIfNonZero( TCounter& counter ) noexcept {
+        if (counter == 0) { return false; }
+        counter++;
+        return true;
+    }
+};
+
+// atomic counters, safe to copy, destroy and lock from several threads at once
+struct MultiThreaded
+{
+    using TCounter = std::atomic<long>;
+
+    static long load( const TCounter& counter ) noexcept { 
+        return counter.load( std::memory_order_acquire ); 
+    }
+    // a new reference is only made from an existing one, nothing has to be ordered
+    static void increment( TCounter& counter ) noexcept { 
+        counter.fetch_add( 1, std::memory_order_relaxed ); 
+    }
+    // release publishes writes made through this reference, acquire makes them visible to the one who destroys
+    static long decrement( TCounter& counter ) noexcept { 
+        return counter.fetch_sub( 1, std::memory_order_acq_rel ) - 1; 
+    }
+    static bool incrementIfNonZero( TCounter& counter ) noexcept {
+        long expected = counter.load( std::memory_order_relaxed );
+        while (expected != 0) {
+            if (counter.compare_exchange_weak( expected, expected + 1
+                                             , std::memory_order_acq_rel
+                                             , std::memory_order_relaxed )) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif // REFCOUNT_POLICY_H
@@ -4,26 +4,26 @@
 #include "util.hpp"
 #include "WeakPtr.hpp"
 
-template <typename T>
+template <typename T, typename Policy>
 class EnableSharedFromThis
 {
 public:
-    SharedPtr<T> sharedFromThis() { return SharedPtr<T>( _self ); }
-    const SharedPtr<T> sharedFromThis() const { return SharedPtr<T>( _self ); }
+    SharedPtr<T,Policy> sharedFromThis() { return SharedPtr<T,Policy>( _self ); }
+    const SharedPtr<T,Policy> sharedFromThis() const { return SharedPtr<T,Policy>( _self ); }
 
-    WeakPtr<T> weakFromThis() { return _self; }
-    const WeakPtr<T> weakFromThis() const { return _self; }
+    WeakPtr<T,Policy> weakFromThis() { return _self; }
+    const WeakPtr<T,Policy> weakFromThis() const { return _self; }
 protected:
     EnableSharedFromThis() = default;
      
-    EnableSharedFromThis( const EnableSharedFromThis<T>& other ) = default;
-    EnableSharedFromThis<T>& operator=( const EnableSharedFromThis<T>& other ) = default;
+    EnableSharedFromThis( const EnableSharedFromThis<T,Policy>& other ) = default;
+    EnableSharedFromThis<T,Policy>& operator=( const EnableSharedFromThis<T,Policy>& other ) = default;
 
     ~EnableSharedFromThis() = default;
 private:
-    WeakPtr<T> _self;
+    WeakPtr<T,Policy> _self;
      
-    friend class SharedPtr<T>;
+    friend class SharedPtr<T,Policy>;
 };
 
 #endif // SHARED_FROM_THIS_H
\ No newline at end of file
@@ -1,123 +1,159 @@
 #ifndef SHARED_PTR
 #define SHARED_PTR
 
+#include <new>
 #include "util.hpp"
+#include "RefCountPolicy.hpp"
 
 template <typename T>
 class UniquePtr;
-template <typename T>
+template <typename T, typename Policy = SingleThreaded>
 class WeakPtr;
-template <typename T>
+template <typename T, typename Policy = SingleThreaded>
 class EnableSharedFromThis;
 
+// while any hard refs exist they collectively own one weak ref, 
+// so the block is freed by whoever drops the last reference of either kind
+template <typename Policy = SingleThreaded>
 struct RefCount
 {
 public:
     RefCount() : _hardRefs( 0 ), _weakRefs( 0 ) {}
     RefCount( const long& hardRefs, const long& weakRefs ) 
-    : _hardRefs( hardRefs ), _weakRefs( weakRefs ) {}
-    ~RefCount() {}
+    : _hardRefs( hardRefs ), _weakRefs( weakRefs + (hardRefs != 0) ) {}
+    virtual ~RefCount() {}
 public:
-    long hardRefs() { return _hardRefs; }
-    long weakRefs() { return _weakRefs; }
+    // blocks produced by makeShared() hold the object itself, see InplaceRefCount
+    virtual bool isInplace() const noexcept { return false; }
+    virtual void destroyObject() noexcept {}
+public:
+    long hardRefs() const noexcept { return Policy::load(_hardRefs); }
+    long weakRefs() const noexcept { 
+        auto hard = hardRefs();
+        return Policy::load(_weakRefs) - (hard != 0); 
+    }
 
-    bool hasHardRefs() { return _hardRefs != 0; }
-    bool hasWeakRefs() { return _weakRefs != 0; }
+    bool hasHardRefs() const noexcept { return hardRefs() != 0; }
+    bool hasWeakRefs() const noexcept { return weakRefs() != 0; }
 
-    void increaseHardRefs() { _hardRefs++; }
-    void increaseWeakRefs() { _weakRefs++; }
-    
-    void decreaseHardRefs() { _hardRefs--; }
-    void decreaseWeakRefs() { _weakRefs--; }
+    void acquireHard() noexcept { Policy::increment(_hardRefs); }
+    bool tryAcquireHard() noexcept { return Policy::incrementIfNonZero(_hardRefs); }
+    void acquireWeak() noexcept { Policy::increment(_weakRefs); }
+
+    // true if the caller dropped the last hard ref and has to destroy the object
+    bool releaseHard() noexcept { return Policy::decrement(_hardRefs) == 0; }
+    // true if the caller dropped the last ref of any kind and has to free the block
+    bool releaseWeak() noexcept { return Policy::decrement(_weakRefs) == 0; }
 private: 
-    long _hardRefs;
-    long _weakRefs;
+    typename Policy::TCounter _hardRefs;
+    typename Policy::TCounter _weakRefs;
 };
 
-template <class T>
+// control block and object share one allocation: the object is destroyed when hard refs reach zero,
+// the storage is released together with the block when weak refs reach zero as well
+template <typename T, typename Policy = SingleThreaded>
+struct InplaceRefCount : RefCount<Policy>
+{
+public:
+    template <typename... Ts>
+    InplaceRefCount( Ts&&... args ) : RefCount<Policy>( 1, 0 ) {
+        new (_storage) T( std::forward<Ts>(args)... );
+    }
+    ~InplaceRefCount() override {}
+public:
+    T* object() noexcept { return std::launder( reinterpret_cast<T*>( _storage ) ); }
+
+    bool isInplace() const noexcept override { return true; }
+    void destroyObject() noexcept override { object()->~T(); }
+private:
+    alignas(T) unsigned char _storage[sizeof(T)];
+};
+
+template <class T, class Policy = SingleThreaded>
 class SharedPtr
 {
 private:
-    SharedPtr( T* ptr ) : _ptr( ptr ), _controlBlock( new RefCount(1, 0) ) { hookSharedToThis(ptr); }
-    SharedPtr( T* ptr, RefCount* count ) : _ptr( ptr ), _controlBlock( count ) {
+    using TCount = RefCount<Policy>;
+
+    SharedPtr( T* ptr ) : _ptr( ptr ), _controlBlock( new TCount(1, 0) ) { hookSharedToThis(ptr); }
+    // adopts a hard ref that has already been accounted for in count
+    SharedPtr( T* ptr, TCount* count ) : _ptr( ptr ), _controlBlock( count ) {
         if (_controlBlock) {
-            _controlBlock->increaseHardRefs();
             hookSharedToThis(ptr);
         }
     }
 
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr( T2* ptr ) : _ptr( ptr ), _controlBlock( new RefCount(1, 0) ) { hookSharedToThis(_ptr); }
+    SharedPtr( T2* ptr ) : _ptr( ptr ), _controlBlock( new TCount(1, 0) ) { hookSharedToThis(_ptr); }
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr( T2* ptr, RefCount* count ) : _ptr( ptr ), _controlBlock( count ) {
+    SharedPtr( T2* ptr, TCount* count ) : _ptr( ptr ), _controlBlock( count ) {
         if (_controlBlock) {
-            _controlBlock->increaseHardRefs();
             hookSharedToThis(ptr);
         }
     }
     
-    friend class EnableSharedFromThis<T>;
-    friend class WeakPtr<T>;
-    template <typename T2> 
+    friend class EnableSharedFromThis<T,Policy>;
+    friend class WeakPtr<T,Policy>;
+    template <typename T2, typename P2> 
     friend class SharedPtr;
-    template <typename T2>
+    template <typename T2, typename P2>
     friend class WeakPtr;
-    template <typename T2, typename... Ts>
-    friend SharedPtr<T2> makeShared(Ts&&... args) requires (!std::is_abstract_v<T2>);
-    template <typename T2, typename... Ts>
-    friend SharedPtr<T2> makeShared(Ts&&... args) requires (std::is_abstract_v<T2>);
+    template <typename T2, typename P2, typename... Ts>
+    friend SharedPtr<T2,P2> makeShared(Ts&&... args) requires (!std::is_abstract_v<T2>);
+    template <typename T2, typename P2, typename... Ts>
+    friend SharedPtr<T2,P2> makeShared(Ts&&... args) requires (std::is_abstract_v<T2>);
 
     template <typename T2> requires (std::is_base_of_v<T,T2>)
     void hookSharedToThis( T2* ptr );
-    static void manageControlChange( T *& ptr, RefCount *& controlBlock );
+    static void manageControlChange( T *& ptr, TCount *& controlBlock );
 public:
     SharedPtr() : _ptr(nullptr) , _controlBlock( nullptr ) { hookSharedToThis(_ptr); }
 
-    SharedPtr( UniquePtr<T>&& other, RefCount* count ) : _ptr(other.release()), _controlBlock( count ) { hookSharedToThis(_ptr); }
-    SharedPtr( UniquePtr<T>&& other ) : _ptr(other.release()), _controlBlock( new RefCount(1, 0)) { hookSharedToThis(_ptr); }
-    SharedPtr<T>& operator=( UniquePtr<T>&& other );
+    SharedPtr( UniquePtr<T>&& other, TCount* count ) : _ptr(other.release()), _controlBlock( count ) { hookSharedToThis(_ptr); }
+    SharedPtr( UniquePtr<T>&& other ) : _ptr(other.release()), _controlBlock( new TCount(1, 0)) { hookSharedToThis(_ptr); }
+    SharedPtr<T,Policy>& operator=( UniquePtr<T>&& other );
 
-    SharedPtr( const SharedPtr<T>& other );
-    SharedPtr<T>& operator=( const SharedPtr<T>& other );
-    SharedPtr( SharedPtr<T>&& other );
-    SharedPtr<T>& operator=( SharedPtr<T>&& other );
+    SharedPtr( const SharedPtr<T,Policy>& other );
+    SharedPtr<T,Policy>& operator=( const SharedPtr<T,Policy>& other );
+    SharedPtr( SharedPtr<T,Policy>&& other );
+    SharedPtr<T,Policy>& operator=( SharedPtr<T,Policy>&& other );
 
-    SharedPtr( const WeakPtr<T>& other );
-    SharedPtr<T>& operator=( const WeakPtr<T>& other );
-    SharedPtr( WeakPtr<T>&& other );
-    SharedPtr<T>& operator=( WeakPtr<T>&& other );
+    SharedPtr( const WeakPtr<T,Policy>& other );
+    SharedPtr<T,Policy>& operator=( const WeakPtr<T,Policy>& other );
+    SharedPtr( WeakPtr<T,Policy>&& other );
+    SharedPtr<T,Policy>& operator=( WeakPtr<T,Policy>&& other );
 
     ~SharedPtr();
 public:
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr( UniquePtr<T2>&& other, RefCount* count ) : _ptr(other.release()), _controlBlock( count ) { hookSharedToThis(_ptr); }
+    SharedPtr( UniquePtr<T2>&& other, TCount* count ) : _ptr(other.release()), _controlBlock( count ) { hookSharedToThis(_ptr); }
 
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr( UniquePtr<T2>&& other ) : _ptr(other.release()), _controlBlock( new RefCount(1, 0)) { hookSharedToThis(_ptr); }
+    SharedPtr( UniquePtr<T2>&& other ) : _ptr(other.release()), _controlBlock( new TCount(1, 0)) { hookSharedToThis(_ptr); }
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr<T>& operator=( UniquePtr<T2>&& other );
+    SharedPtr<T,Policy>& operator=( UniquePtr<T2>&& other );
 
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr( const SharedPtr<T2>& other ) : _ptr( other._ptr ), _controlBlock(other._controlBlock) { 
-        if (_controlBlock) { _controlBlock->increaseHardRefs(); }
+    SharedPtr( const SharedPtr<T2,Policy>& other ) : _ptr( other._ptr ), _controlBlock(other._controlBlock) { 
+        if (_controlBlock) { _controlBlock->acquireHard(); }
     }
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr<T>& operator=( const SharedPtr<T2>& other );
+    SharedPtr<T,Policy>& operator=( const SharedPtr<T2,Policy>& other );
 
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr( SharedPtr<T2>&& other );
+    SharedPtr( SharedPtr<T2,Policy>&& other );
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr<T>& operator=( SharedPtr<T2>&& other );
+    SharedPtr<T,Policy>& operator=( SharedPtr<T2,Policy>&& other );
 
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr( const WeakPtr<T2>& other );
+    SharedPtr( const WeakPtr<T2,Policy>& other );
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr<T>& operator=( const WeakPtr<T2>& other );
+    SharedPtr<T,Policy>& operator=( const WeakPtr<T2,Policy>& other );
 
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr( WeakPtr<T2>&& other );
+    SharedPtr( WeakPtr<T2,Policy>&& other );
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    SharedPtr<T>& operator=( WeakPtr<T2>&& other );
+    SharedPtr<T,Policy>& operator=( WeakPtr<T2,Policy>&& other );
 public:
     operator T*() noexcept {
         return _ptr;
@@ -139,7 +175,7 @@ public:
 public:
     void reset() noexcept;
 
-    void swap( SharedPtr<T>& other ) noexcept;
+    void swap( SharedPtr<T,Policy>& other ) noexcept;
     bool isUnique() const noexcept {
         return _controlBlock->hardRefs() == 1;
     }
@@ -148,34 +184,35 @@ public:
         return _controlBlock->hardRefs();
     }
 public:
-    bool operator==( const SharedPtr<T>& other ) const noexcept;
+    bool operator==( const SharedPtr<T,Policy>& other ) const noexcept;
     bool operator==( T* const& other ) const noexcept;
-    bool operator!=( const SharedPtr<T>& other ) const noexcept;
+    bool operator!=( const SharedPtr<T,Policy>& other ) const noexcept;
     bool operator!=( T* const& other ) const noexcept;
 
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    bool operator==( const SharedPtr<T2>& other ) const noexcept;
+    bool operator==( const SharedPtr<T2,Policy>& other ) const noexcept;
     template <typename T2> requires (std::is_base_of_v<T,T2>)
     bool operator==( T2* const& other ) const noexcept;
     template <typename T2> requires (std::is_base_of_v<T,T2>)
-    bool operator!=( const SharedPtr<T2>& other ) const noexcept;
+    bool operator!=( const SharedPtr<T2,Policy>& other ) const noexcept;
     template <typename T2> requires (std::is_base_of_v<T,T2>)
     bool operator!=( T2* const& other ) const noexcept;
 private:
     T* _ptr;
 
-    RefCount* _controlBlock;
+    TCount* _controlBlock;
 
-    using weakType = WeakPtr<T>;
+    using weakType = WeakPtr<T,Policy>;
 };
 
-template <typename T, typename ... Ts>
-SharedPtr<T> makeShared(Ts&& ... args ) requires(!std::is_abstract_v<T>) {
-    return SharedPtr<T>( new T( std::forward<Ts>(args)...));
+template <typename T, typename Policy = SingleThreaded, typename ... Ts>
+SharedPtr<T,Policy> makeShared(Ts&& ... args ) requires(!std::is_abstract_v<T>) {
+    auto* block = new InplaceRefCount<T,Policy>( std::forward<Ts>(args)... );
+    return SharedPtr<T,Policy>( block->object(), block );
 }
 
-template <typename T, typename ... Ts>
-SharedPtr<T> makeShared(Ts&& ... args ) requires(std::is_abstract_v<T>) = delete;
+template <typename T, typename Policy = SingleThreaded, typename ... Ts>
+SharedPtr<T,Policy> makeShared(Ts&& ... args ) requires(std::is_abstract_v<T>) = delete;
 
 #include "SharedPtr.tpp"
 
@@ -0,0 +1,118 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <cstdint>
+#include <iterator>
+#include "ArraySequence.hpp"
+#include "DynamicArray.hpp"
+#include "MemoryUsage.hpp"
+#include "util.hpp"
+
+// dense table addressed by generational keys: the low 32 bits of a key are a slot index,
+// the high 32 bits the generation of that slot. removing bumps the generation, so stale keys
+// are detected and freed slots are reused through a free list. generations start at 1,
+// hence a key is never 0.
+template <typename T>
+class SlotMap
+{
+public:
+    using Key = std::uint64_t;
+private:
+    struct Slot {
+        T _value;
+        std::uint32_t _generation = 1;
+        std::uint32_t _nextFree = 0;
+        bool _occupied = false;
+    };
+    static const std::uint32_t _noFree = UINT32_MAX;
+public:
+    SlotMap();
+
+    SlotMap( const SlotMap<T>& other ) = delete;
+    SlotMap<T>& operator=( const SlotMap<T>& other ) = delete;
+
+    SlotMap( SlotMap<T>&& other ) = default;
+    SlotMap<T>& operator=( SlotMap<T>&& other ) = default;
+
+    ~SlotMap() = default;
+public:
+    Key insert( const T& value );
+    void remove( const Key key );
+    void removeMany( const ArraySequence<Key>& keys ); // distinct keys, all or none are removed
+
+    T& get( const Key key );
+    const T& get( const Key key ) const;
+    bool contains( const Key key ) const noexcept;
+
+    Key nextKey() const noexcept; // key the next insert() is going to return
+public:
+    ssize_t getSize() const noexcept { return _size; }
+    bool isEmpty() const noexcept { return _size == 0; }
+    MemoryUsage memoryUsage() const;
+public:
+    template <bool isConst>
+    class SlotMapIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type = T;
+        using pointer    = std::conditional_t<isConst, const T*, T*>;
+        using reference  = std::conditional_t<isConst, const T&, T&>;
+        using TSlots     = std::conditional_t<isConst, const DynamicArray<Slot>, DynamicArray<Slot>>;
+    public:
+        SlotMapIterator( TSlots& slots, const size_t index ) : _slots( &slots ), _index( index ) { skipFree(); }
+
+        reference operator*() { return (*_slots)[_index]._value; }
+        pointer operator->() { return std::addressof( (*_slots)[_index]._value ); }
+
+        SlotMapIterator& operator++() {
+            _index++;
+            skipFree();
+            return *this;
+        }
+        SlotMapIterator operator++(int) {
+            auto res = *this;
+            ++(*this);
+            return res;
+        }
+        Key key() const { return makeKey( (*_slots)[_index]._generation, _index ); }
+
+        friend bool operator==( const SlotMapIterator& lhs, const SlotMapIterator& rhs ) noexcept {
+            return lhs._slots == rhs._slots && lhs._index == rhs._index;
+        }
+        friend bool operator!=( const SlotMapIterator& lhs, const SlotMapIterator& rhs ) noexcept {
+            return !( lhs == rhs );
+        }
+    private:
+        void skipFree() {
+            while (_index < _slots->getSize() && !(*_slots)[_index]._occupied) { _index++; }
+        }
+
+        TSlots* _slots;
+        size_t _index;
+    };
+
+    using TIter = SlotMapIterator<false>;
+    using constTIter = SlotMapIterator<true>;
+
+    TIter begin() { return TIter( _slots, 0 ); }
+    TIter end() { return TIter( _slots, _slots.getSize() ); }
+    constTIter begin() const { return constTIter( _slots, 0 ); }
+    constTIter end() const { return constTIter( _slots, _slots.getSize() ); }
+private:
+    static Key makeKey( const std::uint32_t generation, const size_t index ) noexcept {
+        return (static_cast<Key>(generation) << 32) | static_cast<Key>(index);
+    }
+    static size_t indexOf( const Key key ) noexcept { return static_cast<std::uint32_t>(key); }
+    static std::uint32_t generationOf( const Key key ) noexcept { return static_cast<std::uint32_t>(key >> 32); }
+
+    size_t checkedIndex( const Key key ) const;
+private:
+    DynamicArray<Slot> _slots;
+    std::uint32_t _freeHead;
+    ssize_t _size;
+};
+
+#include "SlotMap.tpp"
+
+#endif // SLOT_MAP_H
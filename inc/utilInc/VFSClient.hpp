@@ -0,0 +1,146 @@
+#ifndef VFS_CLIENT_H
+#define VFS_CLIENT_H
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+#include "VFSProtocol.hpp"
+#include "util.hpp"
+
+// blocking client of a VFS server (see VFSServer.hpp). call() runs one command and waits for its
+// reply; send() queues commands and receive() takes their replies in order, which lets a client
+// keep many requests in flight on one connection. the server keeps the current directory of
+// every connection apart. it stops reading a connection with 4 MiB of replies unsent, so flush()
+// reads the replies that come back while it sends: any number of requests may be in flight, the
+// replies not taken yet are held in memory here
+class VFSClient
+{
+public:
+    struct Reply
+    {
+        bool ok = false;
+        std::string output; // of the command, or its error message
+    };
+
+    explicit VFSClient( const std::string& socketPath ) {
+        sockaddr_un address{};
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            throw Exception( std::format( "Error. Socket path {} is too long.", socketPath ));
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy( address.sun_path, socketPath.c_str(), socketPath.size() + 1 );
+
+        _fd = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        if (_fd == -1 || ::connect( _fd, reinterpret_cast<sockaddr*>(&address), sizeof(address) ) == -1) {
+            close();
+            throw Exception( std::format( "Error. Unable to connect to {}.", socketPath ));
+        }
+    }
+
+    VFSClient( const VFSClient& other ) = delete;
+    VFSClient& operator=( const VFSClient& other ) = delete;
+
+    ~VFSClient() { close(); }
+public:
+    Reply call( std::string_view command ) {
+        send(command);
+        return receive();
+    }
+
+    // queues a request, it leaves with the next flush() or receive()
+    void send( std::string_view command ) {
+        VFSProtocol::putRequest( _pending, command );
+        _inFlight++;
+    }
+
+    void flush() {
+        for (size_t done = 0; done < _pending.size();) {
+            pollfd ready{ _fd, POLLIN | POLLOUT, 0 };
+            if (::poll( &ready, 1, -1 ) == -1) {
+                if (errno == EINTR) { continue; }
+                throw Exception( "Error. Lost the connection to the VFS server." );
+            }
+            if (ready.revents & POLLIN) { drain(); } // a server waiting for us to read goes on
+            if (!(ready.revents & (POLLOUT | POLLERR | POLLHUP))) { continue; }
+            auto written = ::send( _fd, _pending.data() + done, _pending.size() - done, MSG_NOSIGNAL | MSG_DONTWAIT );
+            if (written == -1) {
+                if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) { continue; }
+                throw Exception( "Error. Lost the connection to the VFS server." );
+            }
+            done += written;
+        }
+        _pending.clear();
+    }
+
+    // the reply to the oldest request without one
+    Reply receive() {
+        if (_inFlight == 0) {
+            throw Exception( Exception::ErrorCode::EMPTY_STRUCTURE );
+        }
+        flush();
+        fill( VFSProtocol::headerSize );
+        auto length = VFSProtocol::getLength( _buffer.data() + _head );
+        if (length == 0) {
+            throw Exception( "Error. Malformed reply of the VFS server." );
+        }
+        fill( VFSProtocol::headerSize + length );
+
+        auto frame = _buffer.data() + _head + VFSProtocol::headerSize;
+        Reply reply{ frame[0] == VFSProtocol::ok, std::string( frame + 1, length - 1 ) };
+        _head += VFSProtocol::headerSize + length;
+        _inFlight--;
+        return reply;
+    }
+
+    size_t inFlight() const noexcept { return _inFlight; }
+private:
+    // reads until size unread bytes are buffered
+    void fill( const size_t size ) {
+        if (_head != 0 && _buffer.size() - _head < size) {
+            _buffer.erase( 0, _head );
+            _head = 0;
+        }
+        char chunk[1 << 16];
+        while (_buffer.size() - _head < size) {
+            auto got = ::recv( _fd, chunk, sizeof(chunk), 0 );
+            if (got == -1 && errno == EINTR) { continue; }
+            if (got <= 0) {
+                throw Exception( "Error. Lost the connection to the VFS server." );
+            }
+            _buffer.append( chunk, got );
+        }
+    }
+
+    // buffers whatever replies arrived, without waiting for more
+    void drain() {
+        char chunk[1 << 16];
+        while (true) {
+            auto got = ::recv( _fd, chunk, sizeof(chunk), MSG_DONTWAIT );
+            if (got == -1 && errno == EINTR) { continue; }
+            if (got == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) { return; }
+            if (got <= 0) {
+                throw Exception( "Error. Lost the connection to the VFS server." );
+            }
+            _buffer.append( chunk, got );
+        }
+    }
+
+    void close() noexcept {
+        if (_fd != -1) { ::close(_fd); }
+        _fd = -1;
+    }
+private:
+    int _fd = -1;
+    std::string _pending;  // requests not sent yet
+    std::string _buffer;   // replies received, read from _head on
+    size_t _head = 0;
+    size_t _inFlight = 0;
+};
+
+#endif // VFS_CLIENT_H
@@ -0,0 +1,47 @@
+#ifndef VFS_PROTOCOL_H
+#define VFS_PROTOCOL_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// wire format of the VFS server, one frame per request and per response, integers little endian:
+//   request   u32 length, command line in console syntax (length bytes)
+//   response  u32 length, u8 status, output of the command or error message (length - 1 bytes)
+// a connection may send any number of requests before reading, responses come back in order.
+// a request longer than maxFrame closes the connection, a response may be as long as its output
+struct VFSProtocol
+{
+    enum Status : std::uint8_t { ok = 0, error = 1 };
+
+    static constexpr size_t headerSize = sizeof(std::uint32_t);
+    static constexpr size_t maxFrame = size_t(16) << 20;
+
+    static void putLength( std::string& out, const std::uint32_t length ) {
+        unsigned char bytes[headerSize] = { static_cast<unsigned char>(length)
+                                          , static_cast<unsigned char>(length >> 8)
+                                          , static_cast<unsigned char>(length >> 16)
+                                          , static_cast<unsigned char>(length >> 24) };
+        out.append( reinterpret_cast<const char*>(bytes), headerSize );
+    }
+    // overwrites the length of a frame that starts at offset and ends at the end of out
+    static void patchLength( std::string& out, const size_t offset ) {
+        std::uint32_t length = static_cast<std::uint32_t>( out.size() - offset - headerSize );
+        for (size_t i = 0; i < headerSize; i++) { out[offset + i] = static_cast<char>( length >> (8 * i) ); }
+    }
+    static std::uint32_t getLength( const char* bytes ) {
+        std::uint32_t length = 0;
+        for (size_t i = 0; i < headerSize; i++) {
+            length |= std::uint32_t( static_cast<unsigned char>( bytes[i] )) << (8 * i);
+        }
+        return length;
+    }
+
+    static void putRequest( std::string& out, std::string_view command ) {
+        putLength( out, static_cast<std::uint32_t>( command.size() ));
+        out.append( command );
+    }
+};
+
+#endif // VFS_PROTOCOL_H
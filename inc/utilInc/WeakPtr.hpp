@@ -4,31 +4,31 @@
 #include "util.hpp"
 #include "SharedPtr.hpp"
 
-struct RefCount;
-
-template <class T>
+template <class T, class Policy>
 class WeakPtr 
 {
+private:
+    using TCount = RefCount<Policy>;
 public: 
     WeakPtr() : _ptr( nullptr ), _controlBlock( nullptr ) {}
 
-    WeakPtr( const WeakPtr<T>& other );
-    WeakPtr& operator=( const WeakPtr<T>& other );
+    WeakPtr( const WeakPtr<T,Policy>& other );
+    WeakPtr& operator=( const WeakPtr<T,Policy>& other );
 
-    WeakPtr( const SharedPtr<T>& other );
-    WeakPtr<T>& operator=( const SharedPtr<T>& other );
+    WeakPtr( const SharedPtr<T,Policy>& other );
+    WeakPtr<T,Policy>& operator=( const SharedPtr<T,Policy>& other );
 
     ~WeakPtr();
 public:
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    WeakPtr( const WeakPtr<T2>& other );
+    WeakPtr( const WeakPtr<T2,Policy>& other );
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    WeakPtr& operator=( const WeakPtr<T2>& other );
+    WeakPtr& operator=( const WeakPtr<T2,Policy>& other );
 
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    WeakPtr( const SharedPtr<T2>& other );
+    WeakPtr( const SharedPtr<T2,Policy>& other );
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    WeakPtr<T>& operator=( const SharedPtr<T2>& other );
+    WeakPtr<T,Policy>& operator=( const SharedPtr<T2,Policy>& other );
 public:
     void reset() noexcept;
 
@@ -38,44 +38,47 @@ public:
     long getWeakCount() const noexcept {
         return this->_controlBlock->weakRefs();
     }
-    SharedPtr<T> lock() const noexcept;
+    // takes a hard ref only if the object is still alive, safe against a concurrent release with MultiThreaded
+    SharedPtr<T,Policy> lock() const noexcept;
 
-    void swap( WeakPtr<T>& other ) noexcept;
+    void swap( WeakPtr<T,Policy>& other ) noexcept;
 
     operator bool() const noexcept;
 
-    bool isExpired() { 
+    bool isExpired() const { 
         return (_controlBlock) ? !_controlBlock->hasHardRefs() : true;
     }
 public:
-    bool operator==( const WeakPtr<T>& other ) const noexcept;
-    bool operator==( const SharedPtr<T>& other ) const noexcept;
+    bool operator==( const WeakPtr<T,Policy>& other ) const noexcept;
+    bool operator==( const SharedPtr<T,Policy>& other ) const noexcept;
     bool operator==( T* const& other ) const noexcept;
-    bool operator!=( const WeakPtr<T>& other ) const noexcept;
-    bool operator!=( const SharedPtr<T>& other ) const noexcept;
+    bool operator!=( const WeakPtr<T,Policy>& other ) const noexcept;
+    bool operator!=( const SharedPtr<T,Policy>& other ) const noexcept;
     bool operator!=( T* const& other ) const noexcept;
 
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    bool operator==( const WeakPtr<T2>& other ) const noexcept;
+    bool operator==( const WeakPtr<T2,Policy>& other ) const noexcept;
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    bool operator==( const SharedPtr<T2>& other ) const noexcept;
+    bool operator==( const SharedPtr<T2,Policy>& other ) const noexcept;
     template<typename T2> requires (std::is_base_of_v<T,T2>)
     bool operator==( T2* const& other ) const noexcept;
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    bool operator!=( const WeakPtr<T2>& other ) const noexcept;
+    bool operator!=( const WeakPtr<T2,Policy>& other ) const noexcept;
     template<typename T2> requires (std::is_base_of_v<T,T2>)
-    bool operator!=( const SharedPtr<T2>& other ) const noexcept;
+    bool operator!=( const SharedPtr<T2,Policy>& other ) const noexcept;
     template<typename T2> requires (std::is_base_of_v<T,T2>)
     bool operator!=( T2* const& other ) const noexcept;
+private:
+    void release() noexcept;
 private:
     T* _ptr;
     
-    RefCount* _controlBlock;
+    TCount* _controlBlock;
 
-    friend class SharedPtr<T>;
-    template <typename T2>
+    friend class SharedPtr<T,Policy>;
+    template <typename T2, typename P2>
     friend class SharedPtr;
-    template <typename T2>
+    template <typename T2, typename P2>
     friend class WeakPtr;
 };
 
@@ -34,7 +34,9 @@ public:
         CONCAT_WITH_ABS_PATH = 19,
         FORK_FAILURE = 20,
         EXEC_FAILURE = 21,
-        WAITPID_FAILURE = 22
+        WAITPID_FAILURE = 22,
+        CORRUPTED_IMAGE = 23,
+        UNSUPPORTED_IMAGE = 24
     };
 public:
     explicit Exception( std::exception& ex ) : ex(ex) {
@@ -121,6 +123,12 @@ public:
         case ErrorCode::WAITPID_FAILURE:
             this->message = "Error. waitpid() failed.";
             break;
+        case ErrorCode::CORRUPTED_IMAGE:
+            this->message = "Error. Image is corrupted: checksum or structure mismatch.";
+            break;
+        case ErrorCode::UNSUPPORTED_IMAGE:
+            this->message = "Error. Not a VFS image or unsupported image version.";
+            break;
         case ErrorCode::UNKNOWN_ERROR:
             this->message = "Unknown error.";
             break;
@@ -205,6 +205,20 @@ size_t ArraySequence<T>::getSize() const {
     return this->array.getSize();
 }
 
+template <typename T>
+void ArraySequence<T>::reserve( const size_t capacity ) {
+    try {
+        this->array.reserve( capacity );
+    } catch ( std::bad_alloc &ex ) {
+        throw Exception(ex);
+    }
+}
+
+template <typename T>
+size_t ArraySequence<T>::allocatedBytes() const {
+    return this->array.allocatedBytes();
+}
+
 template <typename T>
 Sequence<T>* ArraySequence<T>::appendImmutable( const T& value ) const {
     try {
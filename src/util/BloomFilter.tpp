@@ -0,0 +1,98 @@
+template <typename K, typename Hash>
+BloomFilter<K,Hash>::BloomFilter() : _blocks( nullptr ), _blockCount( 0 ), _added( 0 ), _removed( 0 ), _hash() {}
+
+template <typename K, typename Hash>
+BloomFilter<K,Hash>::BloomFilter( const size_t expected ) : _blocks( nullptr ), _blockCount( 1 ), _added( 0 ), _removed( 0 ), _hash() {
+    while (_blockCount * _keysPerBlock < expected) { _blockCount *= 2; }
+    _blocks = new Block[_blockCount]();
+}
+
+template <typename K, typename Hash>
+BloomFilter<K,Hash>::BloomFilter( BloomFilter<K,Hash>&& other ) noexcept
+: _blocks( other._blocks ), _blockCount( other._blockCount ), _added( other._added )
+, _removed( other._removed ), _hash( std::move(other._hash) ) {
+    other._blocks = nullptr;
+    other._blockCount = 0;
+    other._added = 0;
+    other._removed = 0;
+}
+
+template <typename K, typename Hash>
+BloomFilter<K,Hash>& BloomFilter<K,Hash>::operator=( BloomFilter<K,Hash>&& other ) noexcept {
+    if (this != &other) {
+        delete[] _blocks;
+        _blocks = other._blocks;
+        _blockCount = other._blockCount;
+        _added = other._added;
+        _removed = other._removed;
+        _hash = std::move(other._hash);
+        other._blocks = nullptr;
+        other._blockCount = 0;
+        other._added = 0;
+        other._removed = 0;
+    }
+    return *this;
+}
+
+template <typename K, typename Hash>
+BloomFilter<K,Hash>::~BloomFilter() {
+    delete[] _blocks;
+}
+
+template <typename K, typename Hash>
+void BloomFilter<K,Hash>::add( const K& key ) noexcept {
+    if (!isEnabled()) { return; }
+    auto hash = mix( _hash(key) );
+    auto& block = _blocks[blockOf(hash)];
+    for (size_t word = 0; word < 8; word++) {
+        block._words[word] |= bitOf( static_cast<std::uint32_t>(hash), word );
+    }
+    _added++;
+}
+
+template <typename K, typename Hash>
+bool BloomFilter<K,Hash>::mayContain( const K& key ) const noexcept {
+    if (!isEnabled()) { return true; }
+    auto hash = mix( _hash(key) );
+    auto& block = _blocks[blockOf(hash)];
+    bool res = true;
+    for (size_t word = 0; word < 8; word++) { // no early exit, the loop is branch-free
+        res &= (block._words[word] & bitOf( static_cast<std::uint32_t>(hash), word )) != 0;
+    }
+    return res;
+}
+
+template <typename K, typename Hash>
+bool BloomFilter<K,Hash>::needsRebuild() const noexcept {
+    return isEnabled() && (_added > capacity() || 2 * _removed > _added);
+}
+
+template <typename K, typename Hash>
+MemoryUsage BloomFilter<K,Hash>::memoryUsage() const noexcept {
+    MemoryUsage usage;
+    usage.nodes = _blockCount * sizeof(Block);
+    return usage;
+}
+
+template <typename K, typename Hash>
+size_t BloomFilter<K,Hash>::mix( size_t hash ) noexcept {
+    hash ^= hash >> 32;
+    hash *= 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+template <typename K, typename Hash>
+std::uint64_t BloomFilter<K,Hash>::bitOf( const std::uint32_t hash, const size_t word ) noexcept {
+    // odd multipliers give every word an independent bit from the same 32 hash bits
+    static const std::uint32_t salts[8] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+    return std::uint64_t(1) << ((hash * salts[word]) >> 26);
+}
+
+template <typename K, typename Hash>
+size_t BloomFilter<K,Hash>::blockOf( const size_t hash ) const noexcept {
+    return (hash >> 32) & (_blockCount - 1);
+}
@@ -37,8 +37,15 @@ DynamicArray<T>::DynamicArray( const DynamicArray<T>& other ) {
 
 template <typename T>
 DynamicArray<T>& DynamicArray<T>::operator=( const DynamicArray<T>& other ) {
-    if ( this != &other ) {
+    if ( this != &other && other._size <= _reserved ) {
+        _size = other._size;
+        _data = _allocBegin + _offset;
+        for ( size_t index = 0; index < _size; index++ ) {
+            _data[index] = other._data[index];
+        }
+    } else if ( this != &other ) {
         delete[] _allocBegin;
+        _reserved = 0;
 
         _size = other._size;
         _capacity = other._capacity;
@@ -63,8 +70,10 @@ DynamicArray<T>::DynamicArray( DynamicArray<T>&& other ) {
     _allocBegin = other._allocBegin;
     _data = other._data;
     _allocEnd = other._allocEnd;
+    _reserved = other._reserved;
 
     other._size = 0;
+    other._reserved = 0;
     other._capacity = 2;
     other._offset = 1;
     other._allocBegin = new T[other._capacity + other._offset];
@@ -83,8 +92,10 @@ DynamicArray<T>& DynamicArray<T>::operator=( DynamicArray<T>&& other ) {
         _allocBegin = other._allocBegin;
         _data = other._data;
         _allocEnd = other._allocEnd;
+        _reserved = other._reserved;
 
         other._size = 0;
+        other._reserved = 0;
         other._capacity = 2;
         other._offset = 1;
         other._allocBegin = new T[other._capacity + other._offset];
@@ -124,8 +135,8 @@ void DynamicArray<T>::insertAt( const T& value, const size_t pos ) {
     else if (pos == _size) { append(value); }
     else {
         extend(1);
-        for (size_t index = _size - 1; index >= pos; index--) {
-            _data[index + 1] = _data[index];
+        for (size_t index = _size - 1; index > pos; index--) {
+            _data[index] = _data[index - 1];
         }
         _data[pos] = value;
     }
@@ -171,6 +182,7 @@ void DynamicArray<T>::extend( int sizeDiff ) {
     }
 
     _size += sizeDiff;
+    if ( _size <= _reserved ) { return; }
     auto newCapacity = _capacity;
 
     if ( newCapacity < 10000 ) {
@@ -178,8 +190,8 @@ void DynamicArray<T>::extend( int sizeDiff ) {
             ? newCapacity * 2
             : newCapacity;
     } else {
-        newCapacity = ( _size > newCapacity * 0.25 )
-            ? newCapacity + 1000
+        newCapacity = ( _size > newCapacity * 0.75 )
+            ? newCapacity + newCapacity / 2
             : newCapacity;
     }
     if ( newCapacity != _capacity ) {
@@ -207,15 +219,8 @@ void DynamicArray<T>::shrink( const int sizeDiff ) {
     _size -= sizeDiff;
     auto newCapacity = _capacity;
 
-    if ( newCapacity < 10000 ) {
-        newCapacity = ( _size < newCapacity * 0.25 )
-            ? newCapacity / 2
-            : newCapacity;
-    } else {
-        newCapacity = ( _size < newCapacity * 0.75 )
-            ? newCapacity - 1000
-            : newCapacity;
-    }
+    if ( _size < newCapacity * 0.25 ) { newCapacity /= 2; }
+    if ( newCapacity < _reserved ) { newCapacity = _capacity; }
     if ( newCapacity != _capacity ) {
         _offset = newCapacity / 4 + 1;
         T* newAllocBegin = new T[newCapacity + _offset];
@@ -234,17 +239,29 @@ void DynamicArray<T>::shrink( const int sizeDiff ) {
 
 template <typename T>
 void DynamicArray<T>::recenter() {
-    _offset = _capacity / 4 + 1;
-    T* newAllocBegin = new T[_capacity + _offset];
-    T* newData = newAllocBegin + _offset;
-    T* newAllocEnd = newAllocBegin + (_capacity + _offset);
-    for ( size_t index = 0; index < _size; index++ ) {
-        newData[index] = _data[index];
-    }
-    delete[] _allocBegin;
-    _allocBegin = newAllocBegin;
+    // the buffer always holds _capacity + _offset slots, so the head-room is restored in place
+    T* newData = _allocBegin + _offset;
+    std::move_backward( _data, _data + _size, newData + _size );
     _data = newData;
-    _allocEnd = newAllocEnd;    
+}
+
+template <typename T>
+void DynamicArray<T>::reserve( const size_t capacity ) {
+    if ( capacity > _capacity ) {
+        auto offset = capacity / 4 + 1;
+        T* newAllocBegin = new T[capacity + offset];
+        T* newData = newAllocBegin + offset;
+        for ( size_t index = 0; index < _size; index++ ) {
+            newData[index] = _data[index];
+        }
+        delete[] _allocBegin;
+        _capacity = capacity;
+        _offset = offset;
+        _allocBegin = newAllocBegin;
+        _data = newData;
+        _allocEnd = newAllocBegin + (capacity + offset);
+    }
+    _reserved = std::max( _reserved, capacity );
 }
 
 template <typename T>
@@ -291,6 +308,10 @@ const T& DynamicArray<T>::operator[]( const size_t index ) const {
 template <typename T>
 void DynamicArray<T>::clear() {
     _size = 0;
+    if ( _reserved > 0 ) {
+        _data = _allocBegin + _offset;
+        return;
+    }
     _offset = 1;
     _capacity = 2;
 
@@ -306,6 +327,11 @@ size_t DynamicArray<T>::getSize() const {
     return _size;
 }
 
+template <typename T>
+size_t DynamicArray<T>::allocatedBytes() const {
+    return (_capacity + _offset) * sizeof(T);
+}
+
 template <typename T>
 size_t DynamicArray<T>::getCapacity() const {
     return _capacity;
@@ -0,0 +1,106 @@
+template <typename T>
+void IntrusivePtr<T>::acquire( T* ptr ) noexcept {
+    if (ptr) { ptr->acquireRef(); }
+}
+
+template <typename T>
+void IntrusivePtr<T>::release( T* ptr ) noexcept {
+    if (ptr && ptr->releaseRef()) {
+        destroy( ptr );
+    }
+}
+
+// the cold path kept out of line: inlined, gcc 12 at -O3 cannot tell two releases of one object
+// apart from a use after free (-Wuse-after-free)
+template <typename T>
+[[gnu::noinline, gnu::cold]] void IntrusivePtr<T>::destroy( T* ptr ) noexcept {
+    delete ptr;
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr( T* ptr ) noexcept : _ptr( ptr ) {
+    acquire( _ptr );
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr( const IntrusivePtr<T>& other ) noexcept : _ptr( other._ptr ) {
+    acquire( _ptr );
+}
+
+template <typename T>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=( const IntrusivePtr<T>& other ) noexcept {
+    return (*this = other._ptr);
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr( IntrusivePtr<T>&& other ) noexcept : _ptr( other._ptr ) {
+    other._ptr = nullptr;
+}
+
+template <typename T>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=( IntrusivePtr<T>&& other ) noexcept {
+    if (this != &other) { // other is taken before the release, it may live in the old object
+        release( std::exchange( _ptr, std::exchange( other._ptr, nullptr )));
+    }
+    return *this;
+}
+
+// acquiring before releasing keeps self-assignment and assignment of an object owned by the old one safe
+template <typename T>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=( T* ptr ) noexcept {
+    acquire( ptr );
+    release( _ptr );
+    _ptr = ptr;
+    return *this;
+}
+
+template <typename T>
+IntrusivePtr<T>::~IntrusivePtr() {
+    release( _ptr );
+}
+
+template <typename T>
+template <typename T2> requires (std::is_base_of_v<T,T2>)
+IntrusivePtr<T>& IntrusivePtr<T>::operator=( const IntrusivePtr<T2>& other ) noexcept {
+    return (*this = static_cast<T*>( other._ptr ));
+}
+
+template <typename T>
+template <typename T2> requires (std::is_base_of_v<T,T2>)
+IntrusivePtr<T>& IntrusivePtr<T>::operator=( IntrusivePtr<T2>&& other ) noexcept {
+    release( std::exchange( _ptr, static_cast<T*>( std::exchange( other._ptr, nullptr ))));
+    return *this;
+}
+
+template <typename T>
+T& IntrusivePtr<T>::operator*() {
+    if (!_ptr) {
+        throw Exception( Exception::ErrorCode::NULL_DEREFERENCE );
+    }
+    return *_ptr;
+}
+
+template <typename T>
+const T& IntrusivePtr<T>::operator*() const {
+    if (!_ptr) {
+        throw Exception( Exception::ErrorCode::NULL_DEREFERENCE );
+    }
+    return *_ptr;
+}
+
+template <typename T>
+IntrusivePtr<T>::operator bool() const noexcept {
+    return _ptr != nullptr;
+}
+
+template <typename T>
+void IntrusivePtr<T>::reset() noexcept {
+    release( std::exchange( _ptr, nullptr )); // this may live in the released object
+}
+
+template <typename T>
+void IntrusivePtr<T>::swap( IntrusivePtr<T>& other ) noexcept {
+    auto temp = _ptr;
+    _ptr = other._ptr;
+    other._ptr = temp;
+}
@@ -1,9 +1,9 @@
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-void SharedPtr<T>::hookSharedToThis( T2* ptr ) {
+void SharedPtr<T,Policy>::hookSharedToThis( T2* ptr ) {
     if (ptr) {
-        if constexpr( std::is_base_of_v<EnableSharedFromThis<T>,T2> ) {
-            auto *base = static_cast<EnableSharedFromThis<T>*>( ptr );
+        if constexpr( std::is_base_of_v<EnableSharedFromThis<T,Policy>,T2> ) {
+            auto *base = static_cast<EnableSharedFromThis<T,Policy>*>( ptr );
             if (base->_self.isExpired()) {
                 base->_self = *this;
             }
@@ -11,63 +11,63 @@ void SharedPtr<T>::hookSharedToThis( T2* ptr ) {
     }
 }
 
-template <typename T>
-void SharedPtr<T>::manageControlChange( T *& ptr, RefCount *& controlBlock ) {
+template <typename T, typename Policy>
+void SharedPtr<T,Policy>::manageControlChange( T *& ptr, TCount *& controlBlock ) {
     if (controlBlock) {
-        controlBlock->decreaseHardRefs();
-        bool noHard = !controlBlock->hasHardRefs();
-        bool noWeak = !controlBlock->hasWeakRefs();
-        if (noHard) { 
-            delete ptr; 
-            ptr = nullptr;
-            if (noWeak) {
+        if (controlBlock->releaseHard()) {
+            if (controlBlock->isInplace()) { controlBlock->destroyObject(); }
+            else { delete ptr; }
+            // the weak ref owned by hard refs keeps the block alive while the object dies,
+            // even if the object held weak refs to its own block (EnableSharedFromThis)
+            if (controlBlock->releaseWeak()) {
                 delete controlBlock;
-                controlBlock = nullptr;
             }
         }
+        ptr = nullptr;
+        controlBlock = nullptr;
     }
 }
 
-template <typename T>
-SharedPtr<T>& SharedPtr<T>::operator=( UniquePtr<T>&& other ) {
+template <typename T, typename Policy>
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( UniquePtr<T>&& other ) {
     manageControlChange( _ptr, _controlBlock );
     _ptr = other.release();
-    _controlBlock = new RefCount(1, 0);
+    _controlBlock = new TCount(1, 0);
     hookSharedToThis(_ptr);
     return *this;    
 }
 
-template <typename T>
-SharedPtr<T>::SharedPtr( const SharedPtr<T>& other ) : _ptr( other._ptr ) { 
+template <typename T, typename Policy>
+SharedPtr<T,Policy>::SharedPtr( const SharedPtr<T,Policy>& other ) : _ptr( other._ptr ) { 
     _controlBlock = other._controlBlock;
     if (_controlBlock) {
-        _controlBlock->increaseHardRefs();
+        _controlBlock->acquireHard();
     }
 }
 
-template <typename T>
-SharedPtr<T>& SharedPtr<T>::operator=( const SharedPtr<T>& other ) {
+template <typename T, typename Policy>
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( const SharedPtr<T,Policy>& other ) {
     if (this != &other) {
         manageControlChange( _ptr, _controlBlock );
         _ptr = other._ptr;
         _controlBlock = other._controlBlock;
         if (_controlBlock) {
-            _controlBlock->increaseHardRefs();
+            _controlBlock->acquireHard();
         }
     }
     return *this;
 }
 
-template <typename T>
-SharedPtr<T>::SharedPtr( SharedPtr<T>&& other ) {
+template <typename T, typename Policy>
+SharedPtr<T,Policy>::SharedPtr( SharedPtr<T,Policy>&& other ) {
     _ptr = other._ptr;
     _controlBlock = other._controlBlock;
     other._ptr = nullptr;
     other._controlBlock = nullptr;
 }
 
-template <typename T>
-SharedPtr<T>& SharedPtr<T>::operator=( SharedPtr<T>&& other ) {
+template <typename T, typename Policy>
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( SharedPtr<T,Policy>&& other ) {
     if (this != &other) {
         manageControlChange( _ptr, _controlBlock );
         _ptr = other._ptr;
@@ -78,82 +78,73 @@ SharedPtr<T>& SharedPtr<T>::operator=( SharedPtr<T>&& other ) {
     return *this;
 }
 
-
-template <typename T>
-SharedPtr<T>::SharedPtr( const WeakPtr<T>& other ) : _ptr( other._ptr ) { 
-    _controlBlock = other._controlBlock;
-    _controlBlock->increaseHardRefs();
+// construction from a WeakPtr yields an empty pointer if the object has already expired
+template <typename T, typename Policy>
+SharedPtr<T,Policy>::SharedPtr( const WeakPtr<T,Policy>& other ) : _ptr( nullptr ), _controlBlock( nullptr ) { 
+    if (other._controlBlock && other._controlBlock->tryAcquireHard()) {
+        _ptr = other._ptr;
+        _controlBlock = other._controlBlock;
+    }
 }
 
-template <typename T>
-SharedPtr<T>& SharedPtr<T>::operator=( const WeakPtr<T>& other ) {
-    manageControlChange( _ptr, _controlBlock );
-    _ptr = other._ptr;
-    _controlBlock = other._controlBlock;
-    if (_controlBlock) _controlBlock->increaseHardRefs();
-    
+template <typename T, typename Policy>
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( const WeakPtr<T,Policy>& other ) {
+    SharedPtr<T,Policy> locked( other );
+    swap( locked );
     return *this;
 }
 
-template <typename T>
-SharedPtr<T>::SharedPtr( WeakPtr<T>&& other ) {
-    _ptr = other._ptr;
-    _controlBlock = other._controlBlock;
-    other._ptr = nullptr;
-    other._controlBlock = nullptr;
+template <typename T, typename Policy>
+SharedPtr<T,Policy>::SharedPtr( WeakPtr<T,Policy>&& other ) : SharedPtr( static_cast<const WeakPtr<T,Policy>&>(other) ) {
+    other.reset();
 }
 
-template <typename T>
-SharedPtr<T>& SharedPtr<T>::operator=( WeakPtr<T>&& other ) {
-    if (this != &other) {
-        manageControlChange( _ptr, _controlBlock );
-        _ptr = other._ptr;
-        _controlBlock = other._controlBlock;
-        other._ptr = nullptr;
-        other._controlBlock = nullptr;
-    }
+template <typename T, typename Policy>
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( WeakPtr<T,Policy>&& other ) {
+    SharedPtr<T,Policy> locked( std::move(other) );
+    swap( locked );
     return *this;
 }
 
-template <typename T>
-SharedPtr<T>::~SharedPtr() {
+template <typename T, typename Policy>
+SharedPtr<T,Policy>::~SharedPtr() {
     manageControlChange( _ptr, _controlBlock );
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-SharedPtr<T>& SharedPtr<T>::operator=( UniquePtr<T2>&& other ) {
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( UniquePtr<T2>&& other ) {
     manageControlChange( _ptr, _controlBlock );
     _ptr = other.release();
-    _controlBlock = new RefCount(1, 0);
+    _controlBlock = new TCount(1, 0);
     hookSharedToThis(_ptr);
 
     return *this;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-SharedPtr<T>& SharedPtr<T>::operator=( const SharedPtr<T2>& other ) {
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( const SharedPtr<T2,Policy>& other ) {
+    if (other._controlBlock) other._controlBlock->acquireHard();
     manageControlChange( _ptr, _controlBlock );
     _ptr = other._ptr;
     _controlBlock = other._controlBlock;
-    if (_controlBlock) _controlBlock->increaseHardRefs();
     
     return *this;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-SharedPtr<T>::SharedPtr( SharedPtr<T2>&& other ) {
+SharedPtr<T,Policy>::SharedPtr( SharedPtr<T2,Policy>&& other ) {
     _ptr = other._ptr;
     _controlBlock = other._controlBlock;
     other._ptr = nullptr;
     other._controlBlock = nullptr;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-SharedPtr<T>& SharedPtr<T>::operator=( SharedPtr<T2>&& other ) {
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( SharedPtr<T2,Policy>&& other ) {
     if (static_cast<void*>(this) != static_cast<void*>(&other)) {
         manageControlChange( _ptr, _controlBlock );
         _ptr = other._ptr;
@@ -164,75 +155,65 @@ SharedPtr<T>& SharedPtr<T>::operator=( SharedPtr<T2>&& other ) {
     return *this;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-SharedPtr<T>::SharedPtr( const WeakPtr<T2>& other ) : _ptr(other._ptr) {
-    _controlBlock = other._controlBlock;
-    if (_controlBlock) _controlBlock->increaseHardRefs();
-}
-
-template <typename T>
-template <typename T2> requires (std::is_base_of_v<T,T2>)
-SharedPtr<T>& SharedPtr<T>::operator=( const WeakPtr<T2>& other ) {
-    if (this != &other) {
-        manageControlChange( _ptr, _controlBlock );
+SharedPtr<T,Policy>::SharedPtr( const WeakPtr<T2,Policy>& other ) : _ptr( nullptr ), _controlBlock( nullptr ) {
+    if (other._controlBlock && other._controlBlock->tryAcquireHard()) {
         _ptr = other._ptr;
         _controlBlock = other._controlBlock;
-        if (_controlBlock) _controlBlock->increaseHardRefs();
     }
+}
+
+template <typename T, typename Policy>
+template <typename T2> requires (std::is_base_of_v<T,T2>)
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( const WeakPtr<T2,Policy>& other ) {
+    SharedPtr<T,Policy> locked( other );
+    swap( locked );
     return *this;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-SharedPtr<T>::SharedPtr( WeakPtr<T2>&& other ) {
-    _ptr = other._ptr;
-    _controlBlock = other._controlBlock;
-    other._ptr = nullptr;
-    other._controlBlock = nullptr;
+SharedPtr<T,Policy>::SharedPtr( WeakPtr<T2,Policy>&& other ) : SharedPtr( static_cast<const WeakPtr<T2,Policy>&>(other) ) {
+    other.reset();
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-SharedPtr<T>& SharedPtr<T>::operator=( WeakPtr<T2>&& other ) {
-    if (static_cast<void*>(this) != static_cast<void*>(&other)) {
-        manageControlChange( _ptr, _controlBlock );
-        _ptr = other._ptr;
-        _controlBlock = other._controlBlock;
-        other._ptr = nullptr;
-        other._controlBlock = nullptr;
-    }
+SharedPtr<T,Policy>& SharedPtr<T,Policy>::operator=( WeakPtr<T2,Policy>&& other ) {
+    SharedPtr<T,Policy> locked( std::move(other) );
+    swap( locked );
     return *this;
 }
 
-template <typename T>
-T& SharedPtr<T>::operator*() {
+template <typename T, typename Policy>
+T& SharedPtr<T,Policy>::operator*() {
     if (!_ptr) {
         throw Exception( Exception::ErrorCode::NULL_DEREFERENCE );
     } 
     return *_ptr;
 }
 
-template <typename T>
-const T& SharedPtr<T>::operator*() const {
+template <typename T, typename Policy>
+const T& SharedPtr<T,Policy>::operator*() const {
     if (!_ptr) {
         throw Exception( Exception::ErrorCode::NULL_DEREFERENCE );
     } 
     return *_ptr;
 }
 
-template <typename T>
-SharedPtr<T>::operator bool() const noexcept {
+template <typename T, typename Policy>
+SharedPtr<T,Policy>::operator bool() const noexcept {
     return _ptr != nullptr;
 }
 
-template <typename T>
-void SharedPtr<T>::reset() noexcept {
+template <typename T, typename Policy>
+void SharedPtr<T,Policy>::reset() noexcept {
     manageControlChange( _ptr, _controlBlock );
 }
 
-template <typename T>
-void SharedPtr<T>::swap( SharedPtr<T>& other ) noexcept {
+template <typename T, typename Policy>
+void SharedPtr<T,Policy>::swap( SharedPtr<T,Policy>& other ) noexcept {
     auto temp1 = _ptr;
     _ptr = other._ptr;
     other._ptr = temp1;
@@ -242,48 +223,48 @@ void SharedPtr<T>::swap( SharedPtr<T>& other ) noexcept {
     other._controlBlock = temp2;
 }
 
-template <typename T>
-bool SharedPtr<T>::operator==( const SharedPtr<T>& other ) const noexcept {
+template <typename T, typename Policy>
+bool SharedPtr<T,Policy>::operator==( const SharedPtr<T,Policy>& other ) const noexcept {
     return _ptr == other._ptr;
 }
 
-template <typename T>
-bool SharedPtr<T>::operator==( T* const& other ) const noexcept {
+template <typename T, typename Policy>
+bool SharedPtr<T,Policy>::operator==( T* const& other ) const noexcept {
     return _ptr == other;
 }
 
 
-template <typename T>
-bool SharedPtr<T>::operator!=( const SharedPtr<T>& other ) const noexcept {
+template <typename T, typename Policy>
+bool SharedPtr<T,Policy>::operator!=( const SharedPtr<T,Policy>& other ) const noexcept {
     return _ptr != other._ptr;
 }
 
-template <typename T>
-bool SharedPtr<T>::operator!=( T* const& other ) const noexcept {
+template <typename T, typename Policy>
+bool SharedPtr<T,Policy>::operator!=( T* const& other ) const noexcept {
     return _ptr != other;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-bool SharedPtr<T>::operator==( const SharedPtr<T2>& other ) const noexcept {
+bool SharedPtr<T,Policy>::operator==( const SharedPtr<T2,Policy>& other ) const noexcept {
     return _ptr == other._ptr;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-bool SharedPtr<T>::operator==( T2* const& other ) const noexcept {
+bool SharedPtr<T,Policy>::operator==( T2* const& other ) const noexcept {
     return _ptr == other;
 }
 
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-bool SharedPtr<T>::operator!=( const SharedPtr<T2>& other ) const noexcept {
+bool SharedPtr<T,Policy>::operator!=( const SharedPtr<T2,Policy>& other ) const noexcept {
     return _ptr != other._ptr;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template <typename T2> requires (std::is_base_of_v<T,T2>)
-bool SharedPtr<T>::operator!=( T2* const& other ) const noexcept {
+bool SharedPtr<T,Policy>::operator!=( T2* const& other ) const noexcept {
     return _ptr != other;
-}
\ No newline at end of file
+}
@@ -0,0 +1,93 @@
+template <typename T>
+SlotMap<T>::SlotMap() : _slots(), _freeHead( _noFree ), _size( 0 ) {}
+
+template <typename T>
+typename SlotMap<T>::Key SlotMap<T>::insert( const T& value ) {
+    size_t index;
+    if (_freeHead != _noFree) {
+        index = _freeHead;
+        _freeHead = _slots[index]._nextFree;
+    } else {
+        if (_slots.getSize() >= _noFree) {
+            throw Exception( Exception::ErrorCode::INVALID_SIZE );
+        }
+        index = _slots.getSize();
+        _slots.append( Slot() );
+    }
+    auto& slot = _slots[index];
+    slot._value = value;
+    slot._occupied = true;
+    _size++;
+    return makeKey( slot._generation, index );
+}
+
+template <typename T>
+void SlotMap<T>::remove( const Key key ) {
+    auto index = checkedIndex(key);
+    auto& slot = _slots[index];
+
+    slot._value = T();
+    slot._occupied = false;
+    slot._generation = (slot._generation == UINT32_MAX) ? 1 : slot._generation + 1;
+    slot._nextFree = _freeHead;
+    _freeHead = static_cast<std::uint32_t>(index);
+    _size--;
+}
+
+template <typename T>
+void SlotMap<T>::removeMany( const ArraySequence<Key>& keys ) {
+    for (size_t i = 0; i < keys.getSize(); i++) {
+        checkedIndex( keys[i] );
+    }
+    for (size_t i = 0; i < keys.getSize(); i++) {
+        remove( keys[i] );
+    }
+}
+
+template <typename T>
+T& SlotMap<T>::get( const Key key ) {
+    return _slots[checkedIndex(key)]._value;
+}
+
+template <typename T>
+const T& SlotMap<T>::get( const Key key ) const {
+    return _slots[checkedIndex(key)]._value;
+}
+
+template <typename T>
+bool SlotMap<T>::contains( const Key key ) const noexcept {
+    auto index = indexOf(key);
+    return index < _slots.getSize()
+        && _slots[index]._occupied
+        && _slots[index]._generation == generationOf(key);
+}
+
+template <typename T>
+typename SlotMap<T>::Key SlotMap<T>::nextKey() const noexcept {
+    if (_freeHead != _noFree) {
+        return makeKey( _slots[_freeHead]._generation, _freeHead );
+    } else {
+        return makeKey( 1, _slots.getSize() );
+    }
+}
+
+template <typename T>
+MemoryUsage SlotMap<T>::memoryUsage() const {
+    MemoryUsage usage;
+    auto slotCount = _slots.getSize();
+    usage.nodes = slotCount * (sizeof(Slot) - sizeof(T));
+    usage.payload = _size * sizeof(T);
+    usage.slack = _slots.allocatedBytes() - usage.nodes - usage.payload;
+    for (auto it = begin(); it != end(); ++it) {
+        usage.payload += ownedBytes( *it );
+    }
+    return usage;
+}
+
+template <typename T>
+size_t SlotMap<T>::checkedIndex( const Key key ) const {
+    if (!contains(key)) {
+        throw Exception( Exception::ErrorCode::ABSENT_KEY );
+    }
+    return indexOf(key);
+}
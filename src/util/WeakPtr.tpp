@@ -1,182 +1,172 @@
-template <typename T>
-WeakPtr<T>::WeakPtr( const WeakPtr<T>& other ) : _ptr(other._ptr) { 
+template <typename T, typename Policy>
+void WeakPtr<T,Policy>::release() noexcept {
+    if (_controlBlock && _controlBlock->releaseWeak()) {
+        delete _controlBlock;
+    }
+    _ptr = nullptr;
+    _controlBlock = nullptr;
+}
+
+template <typename T, typename Policy>
+WeakPtr<T,Policy>::WeakPtr( const WeakPtr<T,Policy>& other ) : _ptr(other._ptr) { 
     _controlBlock = other._controlBlock;
-    if (_controlBlock) { _controlBlock->increaseWeakRefs(); }
+    if (_controlBlock) { _controlBlock->acquireWeak(); }
 }
 
-template <typename T>
-WeakPtr<T>& WeakPtr<T>::operator=( const WeakPtr<T>& other ) {
-    if (_controlBlock) {
-        _controlBlock->decreaseWeakRefs();
-        if (!_controlBlock->hasWeakRefs() && !_controlBlock->hasHardRefs()) { delete _controlBlock; }
-    }
+template <typename T, typename Policy>
+WeakPtr<T,Policy>& WeakPtr<T,Policy>::operator=( const WeakPtr<T,Policy>& other ) {
+    if (other._controlBlock) { other._controlBlock->acquireWeak(); }
+    release();
     _ptr = other._ptr;
     _controlBlock = other._controlBlock;
-    if (_controlBlock) { _controlBlock->increaseWeakRefs(); }
     return *this;
 }
 
-template <typename T>
-WeakPtr<T>::WeakPtr( const SharedPtr<T>& other ) : _ptr(other._ptr) {
+template <typename T, typename Policy>
+WeakPtr<T,Policy>::WeakPtr( const SharedPtr<T,Policy>& other ) : _ptr(other._ptr) {
     _controlBlock = other._controlBlock;
-    if (_controlBlock) { _controlBlock->increaseWeakRefs(); }
+    if (_controlBlock) { _controlBlock->acquireWeak(); }
 }
 
-template <typename T>
-WeakPtr<T>& WeakPtr<T>::operator=( const SharedPtr<T>& other ) {
-    if (_controlBlock) {
-        _controlBlock->decreaseWeakRefs();
-        if (!_controlBlock->hasWeakRefs() && !_controlBlock->hasHardRefs()) { delete _controlBlock; }
-    }
+template <typename T, typename Policy>
+WeakPtr<T,Policy>& WeakPtr<T,Policy>::operator=( const SharedPtr<T,Policy>& other ) {
+    if (other._controlBlock) { other._controlBlock->acquireWeak(); }
+    release();
     _ptr = other._ptr;
     _controlBlock = other._controlBlock;
-    if (_controlBlock) { _controlBlock->increaseWeakRefs(); }
     return *this;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-WeakPtr<T>::WeakPtr( const WeakPtr<T2>& other ) : _ptr(other._ptr) { 
+WeakPtr<T,Policy>::WeakPtr( const WeakPtr<T2,Policy>& other ) : _ptr(other._ptr) { 
     _controlBlock = other._controlBlock;
-    if (_controlBlock) { _controlBlock->increaseWeakRefs(); }
+    if (_controlBlock) { _controlBlock->acquireWeak(); }
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-WeakPtr<T>& WeakPtr<T>::operator=( const WeakPtr<T2>& other ) {
-    if (_controlBlock) {
-        _controlBlock->decreaseWeakRefs();
-        if (!_controlBlock->hasWeakRefs() && !_controlBlock->hasHardRefs()) { delete _controlBlock; }
-    }
+WeakPtr<T,Policy>& WeakPtr<T,Policy>::operator=( const WeakPtr<T2,Policy>& other ) {
+    if (other._controlBlock) { other._controlBlock->acquireWeak(); }
+    release();
     _ptr = other._ptr;
     _controlBlock = other._controlBlock;
-    if (_controlBlock) { _controlBlock->increaseWeakRefs(); }
     return *this;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-WeakPtr<T>::WeakPtr( const SharedPtr<T2>& other ) : _ptr(other._ptr) {
+WeakPtr<T,Policy>::WeakPtr( const SharedPtr<T2,Policy>& other ) : _ptr(other._ptr) {
     _controlBlock = other._controlBlock;
-    if (_controlBlock) { _controlBlock->increaseWeakRefs(); }
+    if (_controlBlock) { _controlBlock->acquireWeak(); }
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-WeakPtr<T>& WeakPtr<T>::operator=( const SharedPtr<T2>& other ) {
-    if (_controlBlock) {
-        _controlBlock->decreaseWeakRefs();
-        if (!_controlBlock->hasWeakRefs() && !_controlBlock->hasHardRefs()) { delete _controlBlock; }
-    }
+WeakPtr<T,Policy>& WeakPtr<T,Policy>::operator=( const SharedPtr<T2,Policy>& other ) {
+    if (other._controlBlock) { other._controlBlock->acquireWeak(); }
+    release();
     _ptr = other._ptr;
     _controlBlock = other._controlBlock;
-    if (_controlBlock) { _controlBlock->increaseWeakRefs(); }
     return *this;
 }
 
-template <typename T>
-WeakPtr<T>::~WeakPtr() {
-    if (_controlBlock) {
-        _controlBlock->decreaseWeakRefs();
-        if ( !_controlBlock->hasWeakRefs() && !_controlBlock->hasHardRefs() ) {
-            delete _controlBlock;
-        }
-    }
+template <typename T, typename Policy>
+WeakPtr<T,Policy>::~WeakPtr() {
+    release();
 }
 
-template <typename T>
-void WeakPtr<T>::reset() noexcept {
-    _ptr = nullptr;
-    _controlBlock->decreaseWeakRefs();
-    if (_controlBlock->weakRefs() == 0 && _controlBlock->hardRefs() == 0) {
-        delete _controlBlock;
-    }
-    _controlBlock = nullptr;
+template <typename T, typename Policy>
+void WeakPtr<T,Policy>::reset() noexcept {
+    release();
 }
 
-template <typename T>
-SharedPtr<T> WeakPtr<T>::lock() const noexcept {
-    return SharedPtr<T>(_ptr, _controlBlock);
+template <typename T, typename Policy>
+SharedPtr<T,Policy> WeakPtr<T,Policy>::lock() const noexcept {
+    if (_controlBlock && _controlBlock->tryAcquireHard()) {
+        return SharedPtr<T,Policy>(_ptr, _controlBlock);
+    }
+    return SharedPtr<T,Policy>();
 }
 
-template <typename T>
-void WeakPtr<T>::swap( WeakPtr<T>& other ) noexcept {
+template <typename T, typename Policy>
+void WeakPtr<T,Policy>::swap( WeakPtr<T,Policy>& other ) noexcept {
     auto *temp = _ptr;
     _ptr = other._ptr;
     other._ptr = temp;
 
     auto *tempCount = _controlBlock;
     _controlBlock = other._controlBlock;
-    other._controlBlock = temp;
+    other._controlBlock = tempCount;
 }
 
-template <typename T>
-WeakPtr<T>::operator bool() const noexcept {
+template <typename T, typename Policy>
+WeakPtr<T,Policy>::operator bool() const noexcept {
     return _ptr != nullptr;
 }
 
-template <typename T>
-bool WeakPtr<T>::operator==( const WeakPtr<T>& other ) const noexcept {
+template <typename T, typename Policy>
+bool WeakPtr<T,Policy>::operator==( const WeakPtr<T,Policy>& other ) const noexcept {
     return _ptr == other._ptr;
 }
 
-template <typename T>
-bool WeakPtr<T>::operator==( const SharedPtr<T>& other ) const noexcept {
+template <typename T, typename Policy>
+bool WeakPtr<T,Policy>::operator==( const SharedPtr<T,Policy>& other ) const noexcept {
     return _ptr == other._ptr;
 }
 
-template <typename T>
-bool WeakPtr<T>::operator==( T* const& other ) const noexcept {
+template <typename T, typename Policy>
+bool WeakPtr<T,Policy>::operator==( T* const& other ) const noexcept {
     return _ptr == other;
 }
 
-template <typename T>
-bool WeakPtr<T>::operator!=( const WeakPtr<T>& other ) const noexcept {
+template <typename T, typename Policy>
+bool WeakPtr<T,Policy>::operator!=( const WeakPtr<T,Policy>& other ) const noexcept {
     return _ptr != other._ptr;
 }
 
-template <typename T>
-bool WeakPtr<T>::operator!=( const SharedPtr<T>& other ) const noexcept {
+template <typename T, typename Policy>
+bool WeakPtr<T,Policy>::operator!=( const SharedPtr<T,Policy>& other ) const noexcept {
     return _ptr != other._ptr;
 }
 
-template <typename T>
-bool WeakPtr<T>::operator!=( T* const& other ) const noexcept {
+template <typename T, typename Policy>
+bool WeakPtr<T,Policy>::operator!=( T* const& other ) const noexcept {
     return _ptr != other;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-bool WeakPtr<T>::operator==( const WeakPtr<T2>& other ) const noexcept {
+bool WeakPtr<T,Policy>::operator==( const WeakPtr<T2,Policy>& other ) const noexcept {
     return _ptr == other._ptr;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-bool WeakPtr<T>::operator==( const SharedPtr<T2>& other ) const noexcept {
+bool WeakPtr<T,Policy>::operator==( const SharedPtr<T2,Policy>& other ) const noexcept {
     return _ptr == other._ptr;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-bool WeakPtr<T>::operator==( T2* const& other ) const noexcept {
+bool WeakPtr<T,Policy>::operator==( T2* const& other ) const noexcept {
     return _ptr == other;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-bool WeakPtr<T>::operator!=( const WeakPtr<T2>& other ) const noexcept {
+bool WeakPtr<T,Policy>::operator!=( const WeakPtr<T2,Policy>& other ) const noexcept {
     return _ptr != other._ptr;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-bool WeakPtr<T>::operator!=( const SharedPtr<T2>& other ) const noexcept {
+bool WeakPtr<T,Policy>::operator!=( const SharedPtr<T2,Policy>& other ) const noexcept {
     return _ptr != other._ptr;
 }
 
-template <typename T>
+template <typename T, typename Policy>
 template<typename T2> requires (std::is_base_of_v<T,T2>)
-bool WeakPtr<T>::operator!=( T2* const& other ) const noexcept {
+bool WeakPtr<T,Policy>::operator!=( T2* const& other ) const noexcept {
     return _ptr != other;
-}
\ No newline at end of file
+}
@@ -1,8 +1,33 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include "BPlusTree.hpp"
 #include "BTree.hpp"
+#include "HashMap.hpp"
+#include "RadixTree.hpp"
+#include "IDictionary.hpp"
 #include "Pair.hpp"
+#include "SharedPtr.hpp"
+#include "WeakPtr.hpp"
+#include "IntrusivePtr.hpp"
+#include "MemoryUsage.hpp"
+#include "SlotMap.hpp"
+#include "BloomFilter.hpp"
+#include "DentryCache.hpp"
+#include "NameIndex.hpp"
+#include "MappingCache.hpp"
+#include "Launcher.hpp"
+#include "Reclaimer.hpp"
+#include "CommandLine.hpp"
+#include "PerfectHash.hpp"
+#include "VFSServer.hpp"
+#include "VFSClient.hpp"
+#include "VFS.hpp"
 
 // BTree Tests
 class BTreeTest : public ::testing::Test {
@@ -15,6 +40,7 @@ TEST_F(BTreeTest, EmptyTree) {
     EXPECT_TRUE(tree.isEmpty());
     EXPECT_EQ(tree.getSize(), 0);
     EXPECT_FALSE(tree.contains(1));
+    EXPECT_TRUE(tree.begin() == tree.end());
 }
 
 TEST_F(BTreeTest, SingleInsert) {
@@ -143,6 +169,7 @@ TEST_F(BPlusTreeTest, EmptyTree) {
     EXPECT_TRUE(tree.isEmpty());
     EXPECT_EQ(tree.getSize(), 0);
     EXPECT_FALSE(tree.contains(1));
+    EXPECT_TRUE(tree.begin() == tree.end());
 }
 
 TEST_F(BPlusTreeTest, SingleInsert) {
@@ -273,6 +300,24 @@ TEST_F(BPlusTreeTest, SequentialAccess) {
     EXPECT_EQ(count, 101);
 }
 
+TEST_F(BPlusTreeTest, FindSkipsSeparatorKeys) {
+    for (int i = 0; i < 2000; ++i) {
+        tree.insert(Pair<int, std::string>(i, std::to_string(i)));
+    }
+    // separators are copies of leaf keys, they must not be taken for entries
+    for (int i = 0; i < 2000; ++i) {
+        auto it = tree.find(i);
+        ASSERT_NE(it, tree.end());
+        EXPECT_EQ(*it, std::to_string(i));
+    }
+    for (int i = 0; i < 2000; i += 2) {
+        tree.remove(i);
+    }
+    for (int i = 0; i < 2000; ++i) {
+        EXPECT_EQ(tree.find(i) == tree.end(), i % 2 == 0);
+    }
+}
+
 // Stress Tests
 TEST(StressTest, BTreeRandomOperations) {
     BTree<int, int> tree;
@@ -338,6 +383,1492 @@ TEST(StressTest, BPlusTreeRandomOperations) {
     }
 }
 
+TEST(StressTest, BPlusTreeDeepRemovalsKeepOrder) {
+    BPlusTree<int, int, 2> tree; // small nodes, the tree gets deep enough for inner rotations
+    std::set<int> reference;
+    for (int i = 0; i < 3000; ++i) {
+        int key = (i * 7919) % 3000;
+        tree.insert(Pair<int, int>(key, key));
+        reference.insert(key);
+    }
+    for (int i = 0; i < 2500; ++i) {
+        int key = (i * 104729) % 3000;
+        if (reference.erase(key) == 0) { continue; }
+        tree.remove(key);
+        if (i % 250 != 0) { continue; }
+        for (int kept : reference) {
+            ASSERT_TRUE(tree.contains(kept));
+            ASSERT_NE(tree.find(kept), tree.end());
+        }
+        auto expected = reference.begin();
+        for (auto it = tree.begin(); it != tree.end(); ++it, ++expected) {
+            ASSERT_NE(expected, reference.end());
+            ASSERT_EQ(*it, *expected);
+        }
+        ASSERT_EQ(expected, reference.end());
+    }
+    EXPECT_EQ(tree.getSize(), static_cast<ssize_t>(reference.size()));
+}
+
+// DynamicArray Tests
+TEST(DynamicArrayTest, GrowsAndShrinksGeometrically) {
+    DynamicArray<int> array;
+    size_t reallocations = 0, bytes = array.allocatedBytes();
+    for (int i = 0; i < 200000; i++) {
+        array.append(i);
+        if (array.allocatedBytes() != bytes) { reallocations++; }
+        bytes = array.allocatedBytes();
+    }
+    EXPECT_LT(reallocations, 40u);
+    EXPECT_LT(bytes, 200000 * sizeof(int) * 3); // capacity and head-room stay within a constant factor
+
+    reallocations = 0;
+    while (array.getSize() > 100) {
+        array.removeAt(array.getSize() - 1);
+        if (array.allocatedBytes() != bytes) { reallocations++; }
+        bytes = array.allocatedBytes();
+    }
+    EXPECT_LT(reallocations, 40u);
+    EXPECT_LT(bytes, 10000 * sizeof(int));
+    for (int i = 0; i < 100; i++) { EXPECT_EQ(array[i], i); }
+}
+
+TEST(DynamicArrayTest, InsertAtStaysInBounds) {
+    DynamicArray<int> full;
+    full.reserve(4); // the buffer does not grow, the shift must end at the last element
+    full.append(0);
+    full.append(1);
+    full.append(3);
+    full.insertAt(2, 2);
+    ASSERT_EQ(full.getSize(), 4u);
+    for (int i = 0; i < 4; i++) { EXPECT_EQ(full[i], i); }
+
+    DynamicArray<int> array;
+    std::vector<int> reference;
+    for (int i = 0; i < 1000; i++) {
+        size_t pos = reference.empty() ? 0 : (i * 7919) % (reference.size() + 1);
+        array.insertAt(i, pos);
+        reference.insert(reference.begin() + pos, i);
+    }
+    for (size_t i = 0; i < reference.size(); i++) { EXPECT_EQ(array[i], reference[i]); }
+}
+
+// SharedPtr Tests
+struct Tracked {
+    static inline int alive = 0;
+    int value;
+    Tracked( int v ) : value(v) { alive++; }
+    ~Tracked() { alive--; }
+};
+
+TEST(SharedPtrTest, MakeSharedLifetime) {
+    {
+        auto p = makeShared<Tracked>(42);
+        auto q = p;
+        EXPECT_EQ(Tracked::alive, 1);
+        EXPECT_EQ(p.getCount(), 2);
+        EXPECT_EQ(q->value, 42);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(SharedPtrTest, WeakOutlivesObject) {
+    WeakPtr<Tracked> weak;
+    {
+        auto p = makeShared<Tracked>(7);
+        weak = p;
+        EXPECT_FALSE(weak.isExpired());
+        EXPECT_EQ(weak.getWeakCount(), 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+    EXPECT_TRUE(weak.isExpired());
+}
+
+TEST(SharedPtrTest, ExpiredLockIsEmpty) {
+    auto p = makeShared<Tracked>(1);
+    WeakPtr<Tracked> weak = p;
+    p.reset();
+    EXPECT_FALSE(weak.lock());
+    EXPECT_FALSE(SharedPtr<Tracked>(weak));
+}
+
+TEST(SharedPtrTest, MultiThreadedCopyAndLock) {
+    auto p = makeShared<Tracked,MultiThreaded>(3);
+    WeakPtr<Tracked,MultiThreaded> weak = p;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&p, &weak]() {
+            for (int i = 0; i < 10000; ++i) {
+                auto copy = p;
+                auto locked = weak.lock();
+                EXPECT_EQ(locked->value, 3);
+            }
+        });
+    }
+    for (auto& thread : threads) { thread.join(); }
+
+    EXPECT_EQ(p.getCount(), 1);
+    EXPECT_EQ(weak.getWeakCount(), 1);
+    p.reset();
+    EXPECT_TRUE(weak.isExpired());
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+// IntrusivePtr Tests
+struct IntrusiveTracked : IntrusiveRefCounter<> {
+    static inline int alive = 0;
+    int value;
+    IntrusiveTracked( int v ) : value(v) { alive++; }
+    virtual ~IntrusiveTracked() { alive--; }
+};
+
+struct IntrusiveDerived : IntrusiveTracked {
+    IntrusiveDerived( int v ) : IntrusiveTracked(v) {}
+};
+
+TEST(IntrusivePtrTest, SinglePointerWide) {
+    EXPECT_EQ(sizeof(IntrusivePtr<IntrusiveTracked>), sizeof(void*));
+}
+
+TEST(IntrusivePtrTest, Lifetime) {
+    {
+        IntrusivePtr<IntrusiveTracked> p = makeIntrusive<IntrusiveDerived>(5);
+        auto q = p;
+        EXPECT_EQ(p.getCount(), 2);
+        EXPECT_EQ(q->value, 5);
+
+        IntrusivePtr<IntrusiveTracked> fromRaw( q.get() );
+        EXPECT_EQ(p.getCount(), 3);
+        q.reset();
+        EXPECT_EQ(p.getCount(), 2);
+        EXPECT_EQ(IntrusiveTracked::alive, 1);
+    }
+    EXPECT_EQ(IntrusiveTracked::alive, 0);
+}
+
+struct IntrusiveLink : IntrusiveRefCounter<> {
+    static inline int alive = 0;
+    IntrusivePtr<IntrusiveLink> _next;
+    IntrusiveLink() { alive++; }
+    ~IntrusiveLink() { alive--; }
+};
+
+TEST(IntrusivePtrTest, AssignmentFromInsideTheReleasedObject) {
+    IntrusivePtr<IntrusiveLink> head = makeIntrusive<IntrusiveLink>();
+    auto tail = head;
+    for (int i = 0; i < 10; i++) {
+        tail->_next = makeIntrusive<IntrusiveLink>();
+        tail = tail->_next;
+    }
+    tail.reset();
+    EXPECT_EQ(IntrusiveLink::alive, 11);
+
+    auto walker = std::move(head);
+    walker = std::move(walker->_next); // the source lives in the object the assignment frees
+    EXPECT_EQ(IntrusiveLink::alive, 10);
+    while (walker) { walker = walker->_next; }
+    EXPECT_EQ(IntrusiveLink::alive, 0);
+
+    head = makeIntrusive<IntrusiveLink>();
+    head->_next = makeIntrusive<IntrusiveLink>();
+    auto second = head->_next.get();
+    second->_next = head;              // a cycle: head is owned by second too
+    head.reset();
+    second->_next.reset();             // frees second, which holds the pointer being reset
+    EXPECT_EQ(IntrusiveLink::alive, 0);
+}
+
+// MemoryUsage Tests
+TEST(MemoryUsageTest, BTreeAccountsEveryPart) {
+    BTree<int, int> tree;
+    auto empty = tree.memoryUsage();
+    EXPECT_EQ(empty.payload, 0u);
+    EXPECT_GT(empty.slack, 0u);
+
+    for (int i = 0; i < 100; i++) { tree.insert(i); }
+    auto usage = tree.memoryUsage();
+    EXPECT_EQ(usage.payload, 100 * sizeof(int));
+    EXPECT_GT(usage.nodes, empty.nodes);
+    EXPECT_EQ(usage.controlBlocks % sizeof(IntrusiveRefCounter<>), 0u);
+    EXPECT_EQ(usage.total(), usage.nodes + usage.payload + usage.slack + usage.controlBlocks);
+}
+
+TEST(MemoryUsageTest, BPlusTreeCountsOwnedStrings) {
+    BPlusTree<int, std::string> tree;
+    tree.insert(Pair<int, std::string>(1, "a"));
+    auto shortUsage = tree.memoryUsage();
+
+    BPlusTree<int, std::string> other;
+    std::string longValue(100, 'x');
+    other.insert(Pair<int, std::string>(1, longValue));
+    auto longUsage = other.memoryUsage();
+
+    EXPECT_GE(longUsage.payload - shortUsage.payload, longValue.size());
+    EXPECT_EQ(longUsage.nodes, shortUsage.nodes);
+}
+
+// Batch lookup Tests
+TEST(BatchLookupTest, TreesMatchSingleLookups) {
+    BTree<int, long, 3> btree;
+    BPlusTree<int, long, 3> bplustree;
+    for (int i = 0; i < 200; i += 2) {
+        btree.insert(Pair<int, long>(i, i * 10));
+        bplustree.insert(Pair<int, long>(i, i * 10));
+    }
+
+    ArraySequence<int> keys;
+    for (int i = 250; i >= -10; i -= 3) { keys.append(i); }
+    keys.append(4);
+    keys.append(4);
+
+    ArraySequence<Option<long>> values;
+    ArraySequence<bool> found;
+    btree.getMany(keys, values);
+    bplustree.containsMany(keys, found);
+
+    ASSERT_EQ(values.getSize(), keys.getSize());
+    for (size_t i = 0; i < keys.getSize(); i++) {
+        EXPECT_EQ(values[i].hasValue(), btree.contains(keys[i]));
+        EXPECT_EQ(found[i], bplustree.contains(keys[i]));
+        if (values[i]) { EXPECT_EQ(values[i].get(), keys[i] * 10); }
+    }
+}
+
+TEST(BatchLookupTest, IDictionaryFallsBackPerKey) {
+    IDictionary<int, long, HashMap<int, long>> dict;
+    dict.add(1, 10);
+    dict.add(3, 30);
+
+    ArraySequence<int> keys;
+    keys.append(3);
+    keys.append(2);
+    ArraySequence<Option<long>> values;
+    dict.getMany(keys, values);
+    EXPECT_EQ(values[0].get(), 30);
+    EXPECT_FALSE(values[1].hasValue());
+}
+
+// HashMap Tests
+TEST(HashMapTest, InsertGetRemove) {
+    HashMap<int, std::string> map;
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_FALSE(map.contains(1));
+
+    map.insert(Pair<int, std::string>(1, "one"));
+    map.insert(Pair<int, std::string>(2, "two"));
+    EXPECT_EQ(map.get(1), "one");
+    EXPECT_THROW(map.insert(Pair<int, std::string>(1, "again")), Exception);
+
+    map.get(2) = "deux";
+    EXPECT_EQ(map.get(2), "deux");
+
+    map.remove(1);
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_THROW(map.get(1), Exception);
+    EXPECT_EQ(map.getSize(), 1);
+}
+
+TEST(HashMapTest, ChurnWithoutTombstones) {
+    HashMap<int, int> set;
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 1000; i++) { set.insert(round * 1000 + i); }
+        for (int i = 0; i < 1000; i += 2) { set.remove(round * 1000 + i); }
+    }
+    EXPECT_EQ(set.getSize(), 20 * 500);
+    for (int round = 0; round < 20; round++) {
+        EXPECT_FALSE(set.contains(round * 1000));
+        EXPECT_TRUE(set.contains(round * 1000 + 1));
+    }
+
+    ssize_t visited = 0;
+    for (auto it = set.begin(); it != set.end(); ++it) {
+        EXPECT_EQ(*it % 2, 1);
+        visited++;
+    }
+    EXPECT_EQ(visited, set.getSize());
+}
+
+TEST(HashMapTest, BacksIDictionary) {
+    IDictionary<std::string, int, HashMap<std::string, int>> dict;
+    dict.add("a", 1);
+    dict.add("b", 2);
+    dict.get("a") = 10;
+    EXPECT_EQ(dict.get("a"), 10);
+    EXPECT_TRUE(dict.contains("b"));
+    dict.remove("b");
+    EXPECT_FALSE(dict.contains("b"));
+    EXPECT_GT(dict.memoryUsage().total(), 0u);
+}
+
+// SlotMap Tests
+TEST(SlotMapTest, InsertGetRemove) {
+    SlotMap<std::string> map;
+    auto predicted = map.nextKey();
+    auto a = map.insert("a");
+    auto b = map.insert("b");
+    EXPECT_EQ(a, predicted);
+    EXPECT_NE(a, 0u);
+    EXPECT_EQ(map.get(a), "a");
+    EXPECT_EQ(map.get(b), "b");
+
+    map.remove(a);
+    EXPECT_FALSE(map.contains(a));
+    EXPECT_THROW(map.get(a), Exception);
+    EXPECT_THROW(map.remove(a), Exception);
+    EXPECT_EQ(map.getSize(), 1);
+}
+
+TEST(SlotMapTest, ReusesSlotsWithNewGeneration) {
+    SlotMap<int> map;
+    auto first = map.insert(1);
+    map.remove(first);
+
+    auto predicted = map.nextKey();
+    auto second = map.insert(2);
+    EXPECT_EQ(second, predicted);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(second & 0xFFFFFFFFu, first & 0xFFFFFFFFu);
+    EXPECT_FALSE(map.contains(first));
+    EXPECT_EQ(map.get(second), 2);
+
+    int sum = 0;
+    for (auto it = map.begin(); it != map.end(); ++it) { sum += *it; }
+    EXPECT_EQ(sum, 2);
+}
+
+// RadixTree Tests
+TEST(RadixTreeTest, PrefixKeysAndOrderedIteration) {
+    RadixTree<std::string, int> tree;
+    std::vector<std::string> keys = { "b", "abc", "", "a", "ab", "abd", "abcdef", "ba" };
+    for (size_t i = 0; i < keys.size(); i++) {
+        tree.insert(Pair<std::string, int>(keys[i], i));
+    }
+    EXPECT_EQ(tree.getSize(), 8);
+    EXPECT_EQ(tree.get("abc"), 1);
+    EXPECT_EQ(tree.get(""), 2);
+    EXPECT_FALSE(tree.contains("abcd"));
+    EXPECT_THROW(tree.insert(Pair<std::string, int>("ab", 0)), Exception);
+
+    std::sort(keys.begin(), keys.end());
+    size_t index = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it) {
+        EXPECT_EQ(it.key(), keys[index++]);
+    }
+    EXPECT_EQ(index, keys.size());
+
+    tree.remove("ab");
+    tree.remove("a");
+    EXPECT_FALSE(tree.contains("ab"));
+    EXPECT_EQ(tree.get("abd"), 5);
+    EXPECT_THROW(tree.remove("ab"), Exception);
+}
+
+TEST(RadixTreeTest, GrowsAndShrinksNodes) {
+    RadixTree<std::string, int> tree;
+    for (int i = 0; i < 256; i++) {
+        tree.insert(Pair<std::string, int>(std::string("dir/") + static_cast<char>(i), i));
+    }
+    for (int i = 0; i < 256; i++) {
+        EXPECT_EQ(tree.get(std::string("dir/") + static_cast<char>(i)), i);
+    }
+    auto it = tree.end();
+    --it;
+    EXPECT_EQ(*it, 255);
+
+    for (int i = 0; i < 255; i++) {
+        tree.remove(std::string("dir/") + static_cast<char>(i));
+    }
+    EXPECT_EQ(tree.getSize(), 1);
+    EXPECT_EQ(*tree.begin(), 255);
+    EXPECT_LT(tree.memoryUsage().total(), 256u);
+}
+
+TEST(RadixTreeTest, UpperBoundSeeksByKeyBytes) {
+    RadixTree<std::string, int> tree;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 300; i++) {
+        auto key = std::string("f") + std::to_string(i * 7 % 300);
+        if (i % 3 == 0) { key += static_cast<char>(0x80 + i % 100); } // bytes above 0x7f sort last
+        keys.push_back(key);
+    }
+    for (auto key : { "", "f", "f1x", "g" }) { keys.push_back(key); } // "f1" is among the keys already
+    for (size_t i = 0; i < keys.size(); i++) { tree.insert(Pair<std::string, int>(keys[i], static_cast<int>(i))); }
+    std::sort(keys.begin(), keys.end());
+
+    auto probes = keys;
+    for (auto probe : { "e", "f0a", "f15", "f299z", "f\xff", "fz", "h", "\xff" }) { probes.push_back(probe); }
+    for (auto& key : keys) { probes.push_back(key + "!"); }
+    for (auto& probe : probes) {
+        auto expected = std::upper_bound(keys.begin(), keys.end(), probe);
+        auto it = tree.upperBound(probe);
+        if (expected == keys.end()) {
+            EXPECT_TRUE(it == tree.end()) << probe;
+        } else {
+            ASSERT_TRUE(it != tree.end()) << probe;
+            EXPECT_EQ(it.key(), *expected) << probe;
+        }
+    }
+
+    IDictionary<std::string, long, RadixTree<std::string, long>> dict;
+    dict.add("a.txt", 1);
+    dict.add("b.txt", 2);
+    dict.add("c.txt", 3);
+    EXPECT_EQ(dict.upperBound("a.txt").key(), "b.txt");
+    EXPECT_TRUE(dict.upperBound("c.txt") == dict.end());
+}
+
+TEST(RadixTreeTest, BacksIDictionary) {
+    IDictionary<std::string, long, RadixTree<std::string, long>> dict;
+    dict.add("readme.txt", 1);
+    dict.add("src", 2);
+    EXPECT_TRUE(dict.contains("src"));
+    EXPECT_EQ(dict.get("readme.txt"), 1);
+    dict.remove("src");
+    EXPECT_EQ(dict.getSize(), 1);
+}
+
+// BloomFilter Tests
+TEST(BloomFilterTest, NoFalseNegativesFewFalsePositives) {
+    BloomFilter<int> filter(10000);
+    for (int i = 0; i < 10000; i++) { filter.add(i); }
+    for (int i = 0; i < 10000; i++) { EXPECT_TRUE(filter.mayContain(i)); }
+
+    int falsePositives = 0;
+    for (int i = 10000; i < 110000; i++) { falsePositives += filter.mayContain(i); }
+    EXPECT_LT(falsePositives, 2000);
+
+    BloomFilter<int> disabled;
+    EXPECT_TRUE(disabled.mayContain(42));
+}
+
+TEST(BloomFilterTest, IDictionaryStaysExactAcrossRebuilds) {
+    IDictionary<std::string, long, BPlusTree<std::string, long>> dict;
+    dict.useBloomFilter();
+    for (long i = 0; i < 2000; i++) { dict.add(std::to_string(i), i); }
+    for (long i = 0; i < 1500; i++) { dict.remove(std::to_string(i)); }
+
+    for (long i = 0; i < 2000; i++) {
+        EXPECT_EQ(dict.contains(std::to_string(i)), i >= 1500);
+    }
+    dict.add("7", 7);
+    EXPECT_TRUE(dict.contains("7"));
+    EXPECT_GT(dict.memoryUsage().nodes, 0u);
+}
+
+TEST(BloomFilterTest, DirectoriesGetAFilterOnceTheyGrow) {
+    Dir<BPlusTree> dir(1, 0, "d");
+    auto emptyBytes = dir.memoryUsage().total();
+    for (NodeID i = 0; i + 1 < Dir<BPlusTree>::bloomFrom; i++) {
+        dir.contents().add(std::to_string(i), i);
+    }
+    EXPECT_FALSE(dir.contents().hasBloomFilter());
+    dir.contents().add("last", 0);
+    EXPECT_TRUE(dir.contents().hasBloomFilter());
+    EXPECT_TRUE(dir.contents().contains("last"));
+    EXPECT_FALSE(dir.contents().contains("absent"));
+
+    Dir<BPlusTree> empty(2, 0, "e");
+    EXPECT_FALSE(empty.contents().hasBloomFilter());
+    EXPECT_EQ(empty.memoryUsage().total(), emptyBytes);
+}
+
+// DentryCache Tests
+TEST(DentryCacheTest, NegativeEntriesAndPrefixInvalidation) {
+    DentryCache cache(8);
+    cache.cachePath( "//a", 1 );
+    cache.cachePath( "//a/b", 2 );
+    cache.cachePath( "//ab", 3 );
+    cache.cacheChild( 1, "x", DentryCache::absent );
+    cache.cacheChild( 1, "y", 4 );
+
+    EXPECT_FALSE( cache.child( 1, "z" ).hasValue() );
+    EXPECT_EQ( cache.child( 1, "x" ).get(), DentryCache::absent );
+
+    cache.forgetPaths( "//a" );
+    EXPECT_FALSE( cache.path( "//a" ).hasValue() );
+    EXPECT_FALSE( cache.path( "//a/b" ).hasValue() );
+    EXPECT_EQ( cache.path( "//ab" ).get(), 3u );
+
+    cache.forgetChildrenOf(1);
+    EXPECT_FALSE( cache.child( 1, "y" ).hasValue() );
+    EXPECT_EQ( cache.getSize(), 1 );
+}
+
+TEST(DentryCacheTest, StaysBounded) {
+    DentryCache cache(16);
+    for (NodeID id = 1; id <= 100; id++) {
+        cache.cacheChild( 1, std::to_string(id), id );
+        cache.child( 1, "1" ); // keeps the first entry referenced
+    }
+    EXPECT_EQ( cache.getSize(), 16 );
+    EXPECT_EQ( cache.child( 1, "1" ).get(), 1u );
+    EXPECT_EQ( cache.child( 1, "100" ).get(), 100u );
+}
+
+TEST(DentryCacheTest, VFSMoveAndRmdirInvalidate) {
+    VFS<BPlusTree> vfs;
+    vfs.mkdir("/a");
+    vfs.mkdir("/a/b");
+    vfs.mkdir("/a/b/c");
+    vfs.cd("/a/b/c");
+    vfs.cd("/a/b");
+
+    vfs.move( "/a/b", "/d" );
+    EXPECT_THROW( vfs.cd("/a/b/c"), Exception );
+    vfs.cd("/d/c");
+    EXPECT_EQ( vfs.getCD(), "c" );
+
+    vfs.mkdir("/a/b");
+    vfs.cd("/a/b");
+    EXPECT_EQ( vfs.getCD(), "b" );
+    EXPECT_THROW( vfs.cd("/a/b/c"), Exception );
+
+    vfs.move( "/d", "/a/b" );
+    vfs.cd("/a/b/d/c");
+    EXPECT_THROW( vfs.move( "/a", "/a/b/d" ), Exception );
+
+    vfs.mkdir("/a/b/d/c/e");
+    vfs.cd("/a/b/d/c/e");
+    vfs.cd("/");
+    vfs.rmdir("/a/b/d/c");
+    EXPECT_THROW( vfs.cd("/a/b/d/c"), Exception );
+    EXPECT_THROW( vfs.cd("/a/b/d/c/e"), Exception );
+    vfs.mkdir("/a/b/d/c");
+    vfs.cd("/a/b/d/c");
+    EXPECT_EQ( vfs.getCD(), "c" );
+}
+
+// VFS Tests
+TEST(VFSTest, RecursiveRmdirDropsWholeSubtree) {
+    auto tempFiles = []() {
+        return std::distance( fs::directory_iterator(".temp"), fs::directory_iterator() );
+    };
+    ssize_t before = 0;
+    {
+        VFS<BPlusTree> vfs;
+        before = tempFiles();
+        auto baseCount = vfs.nodeCount();
+
+        vfs.mkdir("/a");
+        vfs.mkdir("/a/b");
+        vfs.mkdir("/a/b/c");
+        vfs.mkdir("/a/b/empty");
+        vfs.touch("/a/b/c/f.txt");
+        vfs.touch("/a/g.txt");
+        vfs.mkdir("/keep");
+        EXPECT_EQ( tempFiles(), before + 2 );
+
+        vfs.rmdir("/a/b/empty");
+        vfs.cd("/a/b/c");
+        vfs.rmdir("/a");
+        EXPECT_EQ( vfs.nodeCount(), baseCount + 1 );
+        EXPECT_EQ( vfs.getCD(), "/" );
+        EXPECT_THROW( vfs.cd("/a/b"), Exception );
+
+        vfs.mkdir("/a");
+        vfs.cd("/a");
+        EXPECT_EQ( vfs.getCD(), "a" );
+    } // the destructor waits for the background reclaim
+    EXPECT_EQ( tempFiles(), before );
+}
+
+TEST(VFSTest, RemoveReclaimsBackingFilesInTheBackground) {
+    auto dir = fs::temp_directory_path() / ("vfs-reclaim-" + std::to_string( ::getpid() ));
+    fs::create_directories(dir);
+    Reclaimer reclaimer;
+    for (int batch = 0; batch < 3; batch++) {
+        ArraySequence<fs::path> paths;
+        for (int i = 0; i < 100; i++) {
+            auto path = dir / std::format( "{}-{}", batch, i );
+            std::ofstream( path ) << i;
+            paths.append( path );
+        }
+        reclaimer.remove( std::move(paths) ); // queued, the previous batch is not waited for
+    }
+    reclaimer.wait();
+    EXPECT_EQ( reclaimer.pending(), 0u );
+    EXPECT_TRUE( fs::is_empty(dir) );
+    fs::remove(dir);
+
+    auto tempFiles = []() {
+        return std::distance( fs::directory_iterator(".temp"), fs::directory_iterator() );
+    };
+    ssize_t before = 0;
+    {
+        VFS<BPlusTree> vfs;
+        before = tempFiles();
+        vfs.touch("/a.txt");
+        vfs.touch("/b.txt");
+        vfs.mkdir("/d");
+        vfs.touch("/d/c.txt");
+        EXPECT_EQ( tempFiles(), before + 3 );
+        vfs.remove("/a.txt");
+        vfs.rmdir("/d");
+        vfs.remove("/b.txt");
+    }
+    EXPECT_EQ( tempFiles(), before );
+}
+
+TEST(VFSTest, MoveIntoRootAndDirectoryReferences) {
+    VFS<BPlusTree> vfs;
+    vfs.mkdir("/a");
+    vfs.mkdir("/a/b");
+    vfs.touch("/a/f.txt");
+    vfs.touch("/a/b/g.txt");
+    vfs.cd("/a");
+
+    vfs.move("/a/f.txt", "/");
+    std::ostringstream listing;
+    vfs.find( listing, "/", "*" );
+    EXPECT_NE( listing.str().find("/f.txt"), std::string::npos );
+    EXPECT_EQ( listing.str().find("//"), std::string::npos );
+    EXPECT_THROW( vfs.read("/a/f.txt"), Exception );
+    EXPECT_NO_THROW( vfs.read("/f.txt") );
+
+    vfs.move("b/g.txt", ".."); // relative to the current directory /a
+    EXPECT_NO_THROW( vfs.read("/g.txt") );
+    vfs.move("/f.txt", ".");
+    EXPECT_NO_THROW( vfs.read("/a/f.txt") );
+
+    EXPECT_THROW( vfs.move("/a/f.txt", ""), Exception );
+    EXPECT_THROW( vfs.move("/a", "/a/b"), Exception );
+    EXPECT_THROW( vfs.move("/", "/a"), Exception );
+}
+
+// Snapshot Tests
+TEST(SnapshotTest, BPlusTreeAssignSortedBuildsValidTree) {
+    for (int count : { 0, 1, 63, 64, 2000, 50000 }) {
+        ArraySequence<Pair<int,long>> sorted;
+        for (int i = 0; i < count; i++) { sorted.append( Pair<int,long>( 2 * i, i ) ); }
+
+        BPlusTree<int,long> tree;
+        tree.insert( Pair<int,long>( -5, 0 ) );
+        tree.assignSorted( sorted );
+        ASSERT_EQ( tree.getSize(), count );
+        EXPECT_FALSE( tree.contains(-5) );
+
+        long expected = 0;
+        for (auto it = tree.begin(); it != tree.end(); ++it) { EXPECT_EQ( *it, expected++ ); }
+        EXPECT_EQ( expected, count );
+
+        for (int i = 0; i < count; i += 3) { tree.insert( Pair<int,long>( 2 * i + 1, -1 ) ); }
+        for (int i = 0; i < count; i += 2) { tree.remove( 2 * i ); }
+        for (int i = 0; i < count; i++) {
+            EXPECT_EQ( tree.contains( 2 * i ), i % 2 == 1 );
+            EXPECT_EQ( tree.contains( 2 * i + 1 ), i % 3 == 0 );
+        }
+    }
+    BPlusTree<int,long> tree;
+    ArraySequence<Pair<int,long>> unsorted;
+    unsorted.append( Pair<int,long>( 2, 0 ) );
+    unsorted.append( Pair<int,long>( 1, 0 ) );
+    EXPECT_THROW( tree.assignSorted( unsorted ), Exception );
+}
+
+TEST(SnapshotTest, VFSImageRoundTripAndCorruption) {
+    const std::string imagePath = "snapshot_test.img";
+    ssize_t nodeCount = 0;
+    {
+        VFS<BPlusTree> vfs;
+        vfs.mkdir("/a");
+        vfs.mkdir("/b");
+        for (int i = 0; i < 300; i++) { vfs.mkdir( "/a/d" + std::to_string(i) ); }
+        vfs.mkdir("/a/d7/deep");
+        vfs.touch("/b/f.txt");
+        nodeCount = vfs.nodeCount();
+        vfs.save( imagePath );
+        vfs.rmdir("/b");
+    }
+
+    VFS<HashMap> loaded;
+    loaded.load( imagePath );
+    EXPECT_EQ( loaded.nodeCount(), nodeCount );
+    loaded.cd("/a/d7/deep");
+    EXPECT_EQ( loaded.getCD(), "deep" );
+    loaded.move( "/b/f.txt", "/a/g.txt" );
+    loaded.mkdir("/a/d300");
+    EXPECT_THROW( loaded.mkdir("/a/d299"), Exception );
+
+    std::string bytes;
+    {
+        std::ifstream ifs( imagePath, std::ios::binary );
+        bytes.assign( std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() );
+    }
+    bytes[bytes.size() - 3] ^= 0x20;
+    {
+        std::ofstream ofs( imagePath, std::ios::binary | std::ios::trunc );
+        ofs.write( bytes.data(), bytes.size() );
+    }
+    EXPECT_THROW( loaded.load( imagePath ), Exception );
+    EXPECT_EQ( loaded.nodeCount(), nodeCount + 1 );
+    loaded.cd("/a/d300");
+    fs::remove( imagePath );
+}
+
+// Journal Tests
+TEST(JournalTest, ReplayRestoresMutationsAndCutsTornTail) {
+    const std::string imagePath = "journal_test.img";
+    JournalPolicy policy;
+    policy.groupSize = 4;
+    ssize_t nodeCount = 0;
+    {
+        VFS<BPlusTree> vfs;
+        vfs.persist( imagePath, policy );
+        vfs.mkdir("/a");
+        vfs.mkdir("/a/b");
+        vfs.cd("/a");
+        vfs.touch("f.txt");
+        vfs.mkdir("d");
+        vfs.move( "b", "/c" );
+        vfs.move( "/a/f.txt", "/c" );
+        vfs.rmdir("/a/d");
+        vfs.mkdir("/e");
+        vfs.remove("/c/f.txt");
+        nodeCount = vfs.nodeCount();
+    }
+    {
+        std::ofstream ofs( imagePath + ".journal", std::ios::binary | std::ios::app );
+        ofs.write( "\x20\0\0\0torn", 8 );
+    }
+
+    VFS<BPlusTree> restored;
+    restored.persist( imagePath, policy );
+    EXPECT_EQ( restored.nodeCount(), nodeCount );
+    restored.cd("/c");
+    EXPECT_THROW( restored.cd("/a/b"), Exception );
+    EXPECT_THROW( restored.cd("/a/d"), Exception );
+    EXPECT_THROW( restored.mkdir("/e"), Exception );
+    restored.mkdir("/g");
+    restored.sync();
+
+    VFS<HashMap> again;
+    again.persist( imagePath, policy );
+    EXPECT_EQ( again.nodeCount(), nodeCount + 1 );
+    again.cd("/g");
+    fs::remove( imagePath );
+    fs::remove( imagePath + ".journal" );
+}
+
+TEST(JournalTest, CompactionFoldsJournalIntoImage) {
+    const std::string imagePath = "compact_test.img";
+    JournalPolicy policy;
+    policy.compactAfter = 10;
+    {
+        VFS<BPlusTree> vfs;
+        vfs.persist( imagePath, policy );
+        for (int i = 0; i < 25; i++) { vfs.mkdir( "/d" + std::to_string(i) ); }
+        vfs.sync();
+        EXPECT_TRUE( fs::exists(imagePath) );
+        EXPECT_LT( fs::file_size( imagePath + ".journal" ), 200u );
+    }
+    VFS<BPlusTree> restored;
+    restored.persist( imagePath, policy );
+    EXPECT_EQ( restored.nodeCount(), 26 );
+    restored.cd("/d24");
+
+    restored.mkdir("/after");
+    restored.compact();
+    VFS<BPlusTree> again;
+    again.persist( imagePath, policy );
+    EXPECT_EQ( again.nodeCount(), 27 );
+    fs::remove( imagePath );
+    fs::remove( imagePath + ".journal" );
+}
+
+TEST(JournalTest, ReplayLeavesBackingFilesAlone) {
+    const std::string imagePath = (fs::temp_directory_path()/std::format( "vfs-replay-{}.img", ::getpid() )).string();
+    {
+        VFS<BPlusTree> vfs;
+        vfs.persist( imagePath );
+        vfs.mkdir("/d");
+        vfs.touch("/d/a.txt");
+        vfs.rmdir("/d");
+    }
+    {
+        VFS<BPlusTree> vfs;
+        vfs.persist( imagePath );
+        vfs.touch("/c.txt"); // must not get the temp file of /d/a.txt back
+        vfs.write( "/c.txt", "kept" );
+    }
+    for (int restart = 0; restart < 3; restart++) {
+        VFS<BPlusTree> vfs;
+        vfs.persist( imagePath );
+        EXPECT_EQ( vfs.skippedRecords(), 0u );
+        EXPECT_EQ( vfs.read("/c.txt").view(), "kept" );
+    }
+    fs::remove( imagePath + ".journal" );
+
+    {
+        VFS<BPlusTree> vfs;
+        vfs.useBlobStore();
+        vfs.persist( imagePath );
+        vfs.mkdir("/d");
+        vfs.touch("/d/a.txt");
+        vfs.rmdir("/d");        // drops the empty blob
+        vfs.touch("/b.txt");    // and brings it back
+    }
+    for (int restart = 0; restart < 3; restart++) {
+        VFS<BPlusTree> vfs;
+        vfs.useBlobStore();
+        vfs.persist( imagePath );
+        EXPECT_EQ( vfs.skippedRecords(), 0u );
+        EXPECT_NO_THROW( vfs.read("/b.txt") );
+    }
+    fs::remove( imagePath + ".journal" );
+}
+
+// Listing Tests
+TEST(ListingTest, BPlusTreeUpperBoundSeeksAcrossLeaves) {
+    BPlusTree<int, long, 3> tree;
+    EXPECT_TRUE( tree.upperBound(5) == tree.end() );
+    for (int i = 0; i < 200; i += 2) { tree.insert( Pair<int,long>( i, i * 10 )); }
+    for (int key = -1; key < 200; key++) {
+        auto it = tree.upperBound(key);
+        int expected = (key < 0) ? 0 : key + 1 + (key % 2 == 0 ? 1 : 0);
+        if (expected >= 200) {
+            EXPECT_TRUE( it == tree.end() );
+        } else {
+            EXPECT_EQ( it.key(), expected );
+            EXPECT_EQ( *it, expected * 10 );
+        }
+    }
+}
+
+TEST(ListingTest, LsPagesThroughSortedDirectory) {
+    VFS<BPlusTree> vfs;
+    vfs.mkdir("/big");
+    std::vector<std::string> expected;
+    for (int i = 0; i < 500; i++) {
+        auto name = std::string("e") + std::to_string(i * 7919 % 500);
+        vfs.mkdir( "/big/" + name );
+        expected.push_back( name + "/" );
+    }
+    vfs.touch("/big/note.txt");
+    expected.push_back("note.txt");
+    std::sort( expected.begin(), expected.end() );
+
+    std::ostringstream whole;
+    EXPECT_EQ( vfs.ls( whole, "/big" ), "" );
+
+    std::string paged, after;
+    int pages = 0;
+    do {
+        std::ostringstream page;
+        after = vfs.ls( page, "/big", 64, after );
+        paged += page.str();
+        pages++;
+    } while (!after.empty());
+    EXPECT_EQ( pages, 8 );
+    EXPECT_EQ( paged, whole.str() );
+
+    std::string joined;
+    for (auto& line : expected) { joined += line + "\n"; }
+    EXPECT_EQ( whole.str(), joined );
+
+    std::ostringstream tail;
+    vfs.cd("/big");
+    vfs.ls( tail, "", 2, "e98" );
+    EXPECT_EQ( tail.str(), "e99/\nnote.txt\n" );
+    EXPECT_THROW( vfs.ls( tail, "/big/note.txt" ), Exception );
+}
+
+TEST(ListingTest, LsRefusesToPageInHashOrder) {
+    VFS<HashMap> vfs;
+    vfs.mkdir("/d");
+    for (int i = 0; i < 100; i++) { vfs.mkdir( "/d/e" + std::to_string(i) ); }
+
+    std::ostringstream whole;
+    EXPECT_EQ( vfs.ls( whole, "/d" ), "" );
+    auto listing = whole.str();
+    EXPECT_EQ( std::count( listing.begin(), listing.end(), '\n' ), 100 );
+
+    std::ostringstream page;
+    EXPECT_THROW( vfs.ls( page, "/d", 10 ), Exception );
+    EXPECT_THROW( vfs.ls( page, "/d", SIZE_MAX, "e5" ), Exception );
+    EXPECT_TRUE( page.str().empty() );
+}
+
+// Find Tests
+TEST(FindTest, GlobMatchesWildcardsAndClasses) {
+    EXPECT_TRUE( globMatch( "*", "" ) );
+    EXPECT_TRUE( globMatch( "*.txt", "notes.txt" ) );
+    EXPECT_FALSE( globMatch( "*.txt", "notes.txt.bak" ) );
+    EXPECT_TRUE( globMatch( "a*b*c", "aXbYbZc" ) );
+    EXPECT_FALSE( globMatch( "a*b*c", "aXbYbZ" ) );
+    EXPECT_TRUE( globMatch( "f?le[0-9]", "file7" ) );
+    EXPECT_FALSE( globMatch( "f?le[!0-9]", "file7" ) );
+    EXPECT_TRUE( globMatch( "[ab]", "b" ) );
+    EXPECT_TRUE( globMatch( "x[", "x[" ) );
+}
+
+TEST(FindTest, ParallelFindMatchesSequentialWalk) {
+    VFS<BPlusTree> vfs;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 20; i++) {
+        auto dir = "/d" + std::to_string(i);
+        vfs.mkdir(dir);
+        for (int j = 0; j < 30; j++) {
+            auto sub = dir + "/s" + std::to_string(j);
+            vfs.mkdir(sub);
+            if (j % 3 == 0) {
+                vfs.touch( sub + "/log" + std::to_string(j) + ".txt" );
+                expected.push_back( sub + "/log" + std::to_string(j) + ".txt" );
+            }
+        }
+    }
+    std::sort( expected.begin(), expected.end() );
+
+    for (size_t threads : { 1, 4 }) {
+        std::ostringstream out;
+        EXPECT_EQ( vfs.find( out, "/", "log*.txt", VFS<BPlusTree>::FindType::file, threads ), expected.size() );
+        std::vector<std::string> found;
+        std::istringstream lines( out.str() );
+        for (std::string line; std::getline( lines, line );) { found.push_back(line); }
+        std::sort( found.begin(), found.end() );
+        EXPECT_EQ( found, expected );
+    }
+
+    std::ostringstream dirs;
+    vfs.cd("/d3");
+    EXPECT_EQ( vfs.find( dirs, ".", "s1*", VFS<BPlusTree>::FindType::dir, 3 ), 11u );
+    std::ostringstream none;
+    EXPECT_EQ( vfs.find( none, "/d3", "log*", VFS<BPlusTree>::FindType::dir ), 0u );
+    EXPECT_THROW( vfs.find( none, "/missing", "*" ), Exception );
+}
+
+// Name Index Tests
+TEST(NameIndexTest, RunsOfOneTermStayApart) {
+    NameIndex index;
+    index.add( "a.log", 7 );
+    index.add( "a.log", 3 );
+    index.add( "a", 5 );
+    index.add( "a.logs", 9 );
+    index.add( "b.log", 11 );
+    EXPECT_EQ( index.byName("a.log").getSize(), 2u );
+    EXPECT_EQ( index.byName("a").getSize(), 1u );
+    EXPECT_EQ( index.byName("a")[0], 5u );
+    EXPECT_EQ( index.byExtension(".log").getSize(), 3u );
+    EXPECT_EQ( index.byExtension("logs").getSize(), 1u );
+    index.remove( "a.log", 7 );
+    EXPECT_EQ( index.byName("a.log").getSize(), 1u );
+    EXPECT_EQ( index.byName("a.log")[0], 3u );
+    EXPECT_EQ( index.byExtension("log").getSize(), 2u );
+    EXPECT_EQ( index.byName("c").getSize(), 0u );
+}
+
+TEST(NameIndexTest, SharedExtensionIsKeptOnce) {
+    const size_t count = 20000;
+    NameIndex withExtension, without;
+    ArraySequence<Pair<std::string,NodeID>> entries;
+    for (size_t i = 0; i < count; i++) {
+        withExtension.add( std::format( "file{}.txt", i ), i );
+        without.add( std::format( "file{}_txt", i ), i ); // same length, no extension
+        entries.append( Pair<std::string,NodeID>( std::format( "file{}.txt", i ), i ));
+    }
+    // a run holds an id per name, no copy of the extension: about 32 bytes a name with the
+    // slack of the leaves, over 100 with a key per name
+    auto perName = double( withExtension.memoryUsage().total() - without.memoryUsage().total() ) / count;
+    EXPECT_LT( perName, 48.0 );
+    EXPECT_EQ( withExtension.byExtension("txt").getSize(), count );
+
+    NameIndex loaded;
+    loaded.assign( entries );
+    EXPECT_EQ( loaded.byExtension(".txt").getSize(), count );
+    EXPECT_EQ( loaded.byName("file7.txt").getSize(), 1u );
+    for (size_t i = 0; i < count; i++) { loaded.remove( std::format( "file{}.txt", i ), i ); }
+    EXPECT_EQ( loaded.byExtension("txt").getSize(), 0u );
+    EXPECT_EQ( loaded.getSize(), 0 );
+}
+
+TEST(NameIndexTest, LocateFollowsEveryMutation) {
+    VFS<BPlusTree> vfs;
+    vfs.mkdir("/etc");
+    vfs.touch("/etc/config.json");
+    vfs.touch("/etc/app.log");
+    auto lines = [&vfs]( const std::string& name, const bool byExtension ) {
+        std::ostringstream out;
+        vfs.locate( out, name, byExtension );
+        std::vector<std::string> found;
+        std::istringstream in( out.str() );
+        for (std::string line; std::getline( in, line );) { found.push_back(line); }
+        std::sort( found.begin(), found.end() );
+        return found;
+    };
+    EXPECT_EQ( lines( "config.json", false ), std::vector<std::string>{ "/etc/config.json" } );
+
+    vfs.mkdir("/var");
+    vfs.mkdir("/var/logs");
+    vfs.touch("/var/logs/sys.log");
+    vfs.touch("/var/logs/config.json");
+    vfs.move( "/etc/app.log", "/var/logs" );
+    vfs.move( "/var/logs/sys.log", "/var/kernel.log" );
+    EXPECT_EQ( lines( ".log", true ), ( std::vector<std::string>{ "/var/kernel.log", "/var/logs/app.log" } ));
+    EXPECT_EQ( lines( "config.json", false ), ( std::vector<std::string>{ "/etc/config.json", "/var/logs/config.json" } ));
+    EXPECT_EQ( lines( "sys.log", false ), std::vector<std::string>{} );
+
+    vfs.move( "/var/logs", "/etc" );
+    EXPECT_EQ( lines( "logs", false ), std::vector<std::string>{ "/etc/logs" } );
+    vfs.remove("/etc/config.json");
+    vfs.rmdir("/etc/logs");
+    EXPECT_EQ( lines( "config.json", false ), std::vector<std::string>{} );
+    EXPECT_EQ( lines( "log", true ), std::vector<std::string>{ "/var/kernel.log" } );
+}
+
+// Blob Store Tests
+TEST(BlobStoreTest, IdenticalContentIsStoredOnce) {
+    auto blobDir = fs::current_path()/".temp"/"blobs";
+    fs::remove_all( blobDir );
+    auto source = [&]( const std::string& name, const std::string& content ) {
+        auto path = fs::absolute( "blob_test_" + name );
+        std::ofstream( path, std::ios::binary ) << content;
+        return path.string();
+    };
+    auto blobCount = [&blobDir]() {
+        return std::distance( fs::directory_iterator(blobDir), fs::directory_iterator() );
+    };
+    std::string same( 100000, 'x' );
+    auto a = source( "a", same );
+    auto b = source( "b", same );
+    auto c = source( "c", same + "y" );
+    {
+        VFS<BPlusTree> vfs;
+        vfs.useBlobStore();
+        vfs.mkdir("/copies");
+        for (int i = 0; i < 50; i++) {
+            vfs.attach( "/copies/f" + std::to_string(i) + ".txt", (i % 2) ? a : b );
+        }
+        vfs.attach( "/other.txt", c );
+        vfs.touch( "/e1.txt" );
+        vfs.touch( "/e2.txt" );
+        EXPECT_EQ( blobCount(), 3 );
+
+        std::ofstream( a, std::ios::binary | std::ios::trunc ) << "changed";
+        vfs.attach( "/changed.txt", a );
+        EXPECT_EQ( blobCount(), 4 );
+        vfs.remove( "/changed.txt" );
+        vfs.rmdir( "/copies" );
+    }
+    EXPECT_EQ( blobCount(), 2 );
+    fs::remove(a);
+    fs::remove(b);
+    fs::remove(c);
+    fs::remove_all( blobDir );
+}
+
+TEST(BlobStoreTest, ReleasedBlobCanBeTakenAgainAtOnce) {
+    auto blobDir = fs::current_path()/".temp"/"blobs";
+    fs::remove_all( blobDir );
+    auto source = fs::absolute( "blob_test_again" ).string();
+    std::ofstream( source, std::ios::binary ) << "same";
+    {
+        VFS<BPlusTree> vfs;
+        vfs.useBlobStore();
+        for (int i = 0; i < 100; i++) { // no pause between dropping the last reference and the next one
+            vfs.touch("/a.txt");
+            vfs.remove("/a.txt");
+            vfs.touch("/b.txt");
+            vfs.mkdir("/d");
+            vfs.attach( "/d/f.txt", source );
+            vfs.rmdir("/d");
+            vfs.attach( "/g.txt", source );
+            ASSERT_NO_THROW( vfs.read("/b.txt") );
+            ASSERT_EQ( vfs.read("/g.txt").view(), "same" );
+            if (i != 99) {
+                vfs.remove("/b.txt");
+                vfs.remove("/g.txt");
+            }
+        }
+    } // the destructor lets the reclaimer finish, nothing queued may touch the blobs in use
+    EXPECT_EQ( std::distance( fs::directory_iterator(blobDir), fs::directory_iterator() ), 2 );
+    fs::remove(source);
+    fs::remove_all( blobDir );
+}
+
+// Read Tests
+TEST(ReadTest, MappingCacheEvictsLeastRecentlyUsed) {
+    auto dir = fs::temp_directory_path()/"vfs_mapping_cache";
+    fs::create_directories(dir);
+    auto source = [&dir]( const std::string& name, const std::string& content ) {
+        auto path = dir/name;
+        std::ofstream( path, std::ios::binary | std::ios::trunc ) << content;
+        return path.string();
+    };
+    auto a = source( "a", "alpha" );
+    auto b = source( "b", "beta" );
+    auto c = source( "c", "gamma" );
+    {
+        MappingCache cache( 2 );
+        EXPECT_EQ( cache.get(a).view(), "alpha" );
+        EXPECT_EQ( cache.get(b).view(), "beta" );
+        EXPECT_EQ( cache.get(a).view(), "alpha" );
+        auto kept = cache.get(b);
+        cache.get(c);
+        EXPECT_FALSE( cache.contains(a) );
+        EXPECT_TRUE( cache.contains(b) );
+        EXPECT_TRUE( cache.contains(c) );
+
+        cache.forget(b);
+        EXPECT_EQ( cache.getSize(), 1 );
+        EXPECT_EQ( kept.view(), "beta" ); // a view outlives its entry
+
+        source( "c", "gamma ray" );
+        EXPECT_EQ( cache.get(c).view(), "gamma ray" );
+        EXPECT_THROW( cache.get( (dir/"missing").string() ), Exception );
+    }
+    fs::remove_all(dir);
+}
+
+TEST(ReadTest, ReadsThroughTheNamespace) {
+    auto phys = fs::temp_directory_path()/"vfs_read_source.txt";
+    std::string content( 10000, 'r' );
+    std::ofstream( phys, std::ios::binary | std::ios::trunc ) << content;
+    {
+        VFS<BPlusTree> vfs;
+        vfs.mkdir("/docs");
+        vfs.attach( "/docs/a.txt", phys.string() );
+        vfs.touch( "/docs/empty.txt" );
+
+        EXPECT_EQ( vfs.read("/docs/a.txt").view(), content );
+        EXPECT_EQ( vfs.read( "/docs/a.txt", MappedFile::Access::random ).size(), content.size() );
+        EXPECT_TRUE( vfs.read("/docs/empty.txt").empty() );
+        EXPECT_THROW( vfs.read("/docs"), Exception );
+        EXPECT_THROW( vfs.read("/docs/none.txt"), Exception );
+
+        auto view = vfs.read("/docs/a.txt");
+        vfs.remove("/docs/a.txt");
+        EXPECT_EQ( view.view(), content );
+    }
+    {
+        VFS<BPlusTree> vfs;
+        vfs.useBlobStore();
+        vfs.attach( "/a.txt", phys.string() );
+        vfs.attach( "/b.txt", phys.string() );
+        EXPECT_EQ( vfs.read("/a.txt").view(), content );
+        EXPECT_EQ( vfs.read("/b.txt").data(), vfs.read("/a.txt").data() ); // one blob, one mapping
+    }
+    fs::remove(phys);
+}
+
+// Write Tests
+TEST(WriteTest, FileWriterStagesAndReplaces) {
+    auto path = (fs::temp_directory_path()/"vfs_writer.bin").string();
+    std::ofstream( path, std::ios::binary | std::ios::trunc ) << "old";
+    std::string block( 3 * FileWriter::alignment + 123, 'w' );
+    for (size_t i = 0; i < block.size(); i++) { block[i] = char('a' + i % 26); }
+    {
+        WritePolicy policy;
+        policy.bufferSize = 2 * FileWriter::alignment;
+        policy.preallocate = 1 << 20;
+        policy.direct = true;
+        FileWriter out( path, FileWriter::Mode::replace, policy );
+        for (int i = 0; i < 10; i++) {
+            out.write( block.data(), 100 );
+            out.write( block.data() + 100, block.size() - 100 );
+        }
+        EXPECT_EQ( MappedFile(path).size(), 3u ); // not in place until closed
+        out.close();
+        EXPECT_EQ( out.written(), 10 * block.size() );
+        EXPECT_THROW( out.write("x"), Exception );
+    }
+    MappedFile replaced( path );
+    ASSERT_EQ( replaced.size(), 10 * block.size() );
+    EXPECT_EQ( std::string_view( replaced.data() + 9 * block.size(), block.size() ), block );
+    {
+        FileWriter out( path, FileWriter::Mode::append );
+        out.write( "tail" );
+    }
+    EXPECT_EQ( MappedFile(path).size(), 10 * block.size() + 4 );
+    {
+        FileWriter out( path, FileWriter::Mode::replace );
+        out.write( "dropped" );
+    }
+    EXPECT_EQ( MappedFile(path).size(), 10 * block.size() + 4 );
+    EXPECT_FALSE( fs::exists( path + ".0.tmp" ));
+    fs::remove(path);
+}
+
+TEST(WriteTest, WritesThroughTheNamespace) {
+    {
+        VFS<BPlusTree> vfs;
+        vfs.mkdir("/logs");
+        vfs.write( "/logs/a.txt", "first\n" );
+        vfs.append( "/logs/a.txt", "second\n" );
+        EXPECT_EQ( vfs.read("/logs/a.txt").view(), "first\nsecond\n" );
+
+        auto before = vfs.read("/logs/a.txt");
+        vfs.write( "/logs/a.txt", "replaced" );
+        EXPECT_EQ( before.view(), "first\nsecond\n" );
+        EXPECT_EQ( vfs.read("/logs/a.txt").view(), "replaced" );
+
+        {
+            auto out = vfs.writer( "/logs/big.txt" );
+            for (int i = 0; i < 1000; i++) { out.write( std::to_string(i) + "\n" ); }
+            out.close();
+        }
+        EXPECT_TRUE( vfs.read("/logs/big.txt").view().ends_with("998\n999\n") );
+        EXPECT_THROW( vfs.write( "/logs", "x" ), Exception );
+    }
+    {
+        VFS<BPlusTree> vfs;
+        vfs.useBlobStore();
+        vfs.touch( "/a.txt" );
+        vfs.touch( "/b.txt" );
+        vfs.append( "/a.txt", "only a" );
+        EXPECT_EQ( vfs.read("/a.txt").view(), "only a" );
+        EXPECT_TRUE( vfs.read("/b.txt").empty() ); // the shared empty blob is untouched
+    }
+}
+
+// Launcher Tests
+TEST(LauncherTest, ReapsChildrenInTheBackground) {
+    Launcher quiet( { "sh", "-c", "sleep 0.2", "sh" } );
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20; i++) { quiet.launch( "/file" + std::to_string(i) ); }
+    EXPECT_LT( std::chrono::steady_clock::now() - start, std::chrono::milliseconds( 200 ));
+    EXPECT_GT( quiet.running(), 0u );
+    quiet.wait();
+    EXPECT_EQ( quiet.running(), 0u );
+    EXPECT_EQ( quiet.failures().getSize(), 0 );
+
+    Launcher failing( { "sh", "-c", "exit 3", "sh" } );
+    failing.launch( "/a.txt" );
+    failing.launch( "/b.txt" );
+    failing.wait();
+    auto failures = failing.failures();
+    ASSERT_EQ( failures.getSize(), 2 );
+    EXPECT_NE( failures[0].find("code 3"), std::string::npos );
+    EXPECT_EQ( failing.failures().getSize(), 0 );
+
+    Launcher killed( { "sh", "-c", "kill -9 $$", "sh" } );
+    killed.launch( "/a.txt" );
+    killed.wait();
+    EXPECT_NE( killed.failures()[0].find("signal 9"), std::string::npos );
+
+    Launcher missing( { "no-such-open-tool" } );
+    EXPECT_THROW( missing.launch( "/a.txt" ), Exception );
+}
+
+// CommandLine Tests
+TEST(CommandLineTest, SplitsWordsAndQuotes) {
+    std::string line = "  mv\t\"/my docs/a b.txt\"  '/x y'  plain ''";
+    CommandLine words( line );
+    ASSERT_EQ( words.getSize(), 5u );
+    EXPECT_EQ( words[0], "mv" );
+    EXPECT_EQ( words[1], "/my docs/a b.txt" );
+    EXPECT_EQ( words[2], "/x y" );
+    EXPECT_EQ( words[3], "plain" );
+    EXPECT_EQ( words[4], "" );
+    EXPECT_EQ( words[1].data(), line.data() + 6 ); // a view, not a copy
+    EXPECT_THROW( words[5], Exception );
+
+    EXPECT_TRUE( CommandLine( " \t " ).isEmpty() );
+    EXPECT_THROW( CommandLine( "cat \"open" ), Exception );
+    std::string many;
+    for (size_t i = 0; i <= CommandLine::maxWords; i++) { many += "w "; }
+    EXPECT_THROW( CommandLine{ many }, Exception );
+}
+
+TEST(CommandLineTest, PerfectHashFindsEveryName) {
+    static constexpr std::array<std::string_view,6> names = { "ls", "cd", "mkdir", "rm", "remove", "h" };
+    constexpr PerfectHash<names.size(), 16> hash( names );
+    static_assert( hash.find("mkdir") == 2 );
+    for (size_t i = 0; i < names.size(); i++) {
+        EXPECT_EQ( hash.find( names[i] ), i );
+    }
+    EXPECT_EQ( hash.find("mkdi"), hash.absent );
+    EXPECT_EQ( hash.find(""), hash.absent );
+    EXPECT_EQ( hash.find("removed"), hash.absent );
+}
+
+// Batch Tests
+TEST(BatchTest, CountsErrorsAndStopsOnTheFirstWhenAsked) {
+    auto tooLong = (fs::temp_directory_path()/std::string( 300, 'x' )).string(); // a filesystem_error, not an Exception
+    std::string lines = "# setup\n"
+                        "\n"
+                        "mkdir /d\n"
+                        "   # indented comment\r\n"
+                        "mkdir /d\n"
+                        "attach /d/x.txt " + tooLong + "\n"
+                        "mkdir /e"; // no newline at the end
+    {
+        VFSConsoleApp<BPlusTree> app;
+        std::istringstream in( lines );
+        auto summary = app.runBatch( in, false );
+        EXPECT_EQ( summary.lines, 7u );
+        EXPECT_EQ( summary.commands, 4u );
+        EXPECT_EQ( summary.errors, 2u );
+        EXPECT_FALSE( summary.stopped );
+        EXPECT_NO_THROW( app.setCWD("/e") );
+    }
+    {
+        VFSConsoleApp<BPlusTree> app;
+        std::istringstream in( lines );
+        auto summary = app.runBatch( in, true );
+        EXPECT_EQ( summary.commands, 2u );
+        EXPECT_EQ( summary.errors, 1u );
+        EXPECT_TRUE( summary.stopped );
+        EXPECT_THROW( app.setCWD("/e"), Exception );
+    }
+    auto script = (fs::temp_directory_path()/std::format( "vfs-batch-{}.txt", ::getpid() )).string();
+    std::ofstream( script, std::ios::binary ) << lines;
+    {
+        VFSConsoleApp<BPlusTree> app;
+        auto summary = app.runScript( script, false );
+        EXPECT_EQ( summary.commands, 4u );
+        EXPECT_EQ( summary.errors, 2u );
+        summary = app.runScript( script, true ); // /d exists by now
+        EXPECT_EQ( summary.commands, 1u );
+        EXPECT_EQ( summary.errors, 1u );
+    }
+    fs::remove(script);
+}
+
+// Server Tests
+TEST(ServerTest, PipelinedSessionsKeepTheirDirectories) {
+    auto socketPath = (std::filesystem::temp_directory_path()
+                       / ("vfs-server-test-" + std::to_string( ::getpid() ) + ".sock")).string();
+    VFSConsoleApp<BPlusTree> app;
+    {
+        VFSServer<BPlusTree> server( app, socketPath );
+        std::thread loop( [&server]() { server.run(); } );
+        EXPECT_THROW( VFSServer<BPlusTree>( app, socketPath ), Exception ); // served already
+
+        VFSClient first( socketPath ), second( socketPath );
+        EXPECT_TRUE( first.call( "mkdir /a" ).ok );
+        EXPECT_TRUE( first.call( "mkdir /b" ).ok );
+        for (auto command : { "cd /a", "touch x.txt", "no such command", "ls" }) { first.send(command); }
+        for (auto command : { "cd /b", "touch y.txt", "ls" }) { second.send(command); }
+        second.flush();
+        EXPECT_EQ( first.inFlight(), 4u );
+
+        EXPECT_TRUE( first.receive().ok );
+        EXPECT_TRUE( first.receive().ok );
+        auto failed = first.receive();
+        EXPECT_FALSE( failed.ok );
+        EXPECT_FALSE( failed.output.empty() );
+        auto listing = first.receive();
+        EXPECT_TRUE( listing.ok );
+        EXPECT_NE( listing.output.find("x.txt"), std::string::npos );
+        EXPECT_EQ( listing.output.find("y.txt"), std::string::npos );
+
+        second.receive();
+        second.receive();
+        listing = second.receive();
+        EXPECT_NE( listing.output.find("y.txt"), std::string::npos );
+        EXPECT_EQ( listing.output.find("x.txt"), std::string::npos );
+        EXPECT_EQ( second.inFlight(), 0u );
+        EXPECT_THROW( second.receive(), Exception );
+
+        EXPECT_TRUE( first.call( "cat x.txt" ).ok ); // still in /a
+        EXPECT_TRUE( first.call( "exit" ).ok );
+        EXPECT_THROW( first.call( "ls" ), Exception ); // closed after exit
+
+        server.stop();
+        loop.join();
+    }
+    EXPECT_FALSE( std::filesystem::exists( socketPath ));
+}
+
+TEST(ServerTest, ClientReadsRepliesWhileSendingALongPipeline) {
+    auto socketPath = (std::filesystem::temp_directory_path()
+                       / ("vfs-pipeline-test-" + std::to_string( ::getpid() ) + ".sock")).string();
+    VFSConsoleApp<BPlusTree> app;
+    auto server = std::make_unique<VFSServer<BPlusTree>>( app, socketPath );
+    std::thread loop( [&server]() { server->run(); } );
+
+    // far more replies than the server holds back for one connection, and more requests than
+    // the socket buffers take, so neither side gets through without the other reading
+    const size_t requests = 8000;
+    std::atomic<size_t> received = 0;
+    std::thread client( [&]() {
+        try {
+            VFSClient vfs( socketPath );
+            vfs.call( "mkdir /d" );
+            for (int i = 0; i < 64; i++) { vfs.call( std::format( "mkdir /d/entry-with-a-long-name-{}", i )); }
+            std::string command = "ls /d";
+            for (int i = 0; i < 500; i++) { command += "/."; } // a kilobyte for the same listing
+            for (size_t i = 0; i < requests; i++) { vfs.send(command); }
+            vfs.flush();
+            while (vfs.inFlight() != 0 && vfs.receive().ok) { received++; }
+        } catch (Exception& ex) {} // the server went away on a deadlock
+    });
+    for (int waited = 0; waited < 600 && received < requests; waited++) {
+        std::this_thread::sleep_for( std::chrono::milliseconds(100) );
+    }
+    server->stop();
+    loop.join();
+    server.reset(); // closes the connection, a client stuck in send gives up
+    client.join();
+    EXPECT_EQ( received, requests );
+}
+
+// Reserve Tests
+TEST(ReserveTest, ArraySequenceKeepsReservedBuffer) {
+    ArraySequence<int> seq;
+    seq.reserve(100);
+    auto bytes = seq.allocatedBytes();
+    for (int i = 0; i < 100; i++) { seq.prepend(i); }
+    EXPECT_EQ(seq.allocatedBytes(), bytes);
+    for (int i = 0; i < 90; i++) { seq.removeAt(0); }
+    EXPECT_EQ(seq.allocatedBytes(), bytes);
+    EXPECT_EQ(seq[0], 9);
+}
+
+TEST(ReserveTest, TreesConsumeSpareNodes) {
+    BTree<int, long, 3> btree;
+    BPlusTree<int, long, 3> bplustree;
+    btree.reserve(500);
+    bplustree.reserve(500);
+    auto btreeSlack = btree.memoryUsage().slack;
+    auto bplustreeSlack = bplustree.memoryUsage().slack;
+
+    for (int i = 0; i < 500; i++) {
+        btree.insert(Pair<int, long>(i, i * 10));
+        bplustree.insert(Pair<int, long>(i, i * 10));
+    }
+    for (int i = 0; i < 500; i++) {
+        EXPECT_EQ(btree.get(i), i * 10);
+        EXPECT_EQ(bplustree.get(i), i * 10);
+    }
+    EXPECT_LT(btree.memoryUsage().slack, btreeSlack);
+    EXPECT_LT(bplustree.memoryUsage().slack, bplustreeSlack);
+}
+
+TEST(ReserveTest, IDictionaryHonorsCapacity) {
+    IDictionary<int, long, HashMap<int, long>> dict(1000);
+    EXPECT_EQ(dict.getCapacity(), 1000);
+    auto bytes = dict.memoryUsage().total();
+    for (int i = 0; i < 1000; i++) { dict.add(i, i); }
+    EXPECT_EQ(dict.memoryUsage().total(), bytes);
+    EXPECT_THROW(dict.reserve(-1), Exception);
+}
+
+#ifdef TREE_STATS
+// TreeStats Tests
+TEST(TreeStatsTest, CountsSplitsAndShape) {
+    using Tree = BTree<int, int, 3>;
+    Tree tree;
+    Tree::counters().reset();
+    for (int i = 0; i < 100; i++) { tree.insert(i); }
+
+    const auto& counters = Tree::counters();
+    EXPECT_EQ(counters.operations, 100u);
+    EXPECT_GT(counters.splits, 0u);
+    EXPECT_GT(counters.rootSplits, 0u);
+    EXPECT_GE(counters.visits, counters.operations);
+
+    auto shape = tree.shape();
+    EXPECT_GT(shape.height, 1u);
+    EXPECT_EQ(shape.levelNodes[0], 1u);
+    EXPECT_EQ(shape.levelNodes.getSize(), shape.height);
+
+    size_t histogramNodes = 0;
+    for (auto bucket : shape.fillHistogram) { histogramNodes += bucket; }
+    EXPECT_EQ(histogramNodes, shape.nodes);
+}
+#endif
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
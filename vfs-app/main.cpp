@@ -1,18 +1,97 @@
 #include "consoleApp.hpp"
+#include "VFSServer.hpp"
 #include "BPlusTree.hpp"
+#include "RadixTree.hpp"
+#include <csignal>
 
-int main() {
+#ifdef VFS_RADIX_DIRS
+    using App = VFSConsoleApp<RadixTree>;
+    using Server = VFSServer<RadixTree>;
+#else
     using App = VFSConsoleApp<BPlusTree>; 
+    using Server = VFSServer<BPlusTree>;
+#endif
+
+static Server* serving = nullptr; // stopped by SIGINT and SIGTERM
+
+int main( int argc, char** argv ) {
     App app;
 
-    App::showStart();
+    // vfs-app [--dedup] [--script <file> | --stdin-batch | --serve <socket>] [--stop-on-error] [<image>]:
+    // --dedup stores file contents once, <image> keeps the namespace in the image and its
+    // journal. --script and --stdin-batch run one command per line without prompts and print
+    // a summary to stderr, the exit code is 1 when a command failed. --serve answers clients
+    // on a unix domain socket until it is interrupted, see VFSClient.hpp
+    std::string script, socketPath;
+    bool batch = false, stopOnError = false;
+    for (int arg = 1; arg < argc; arg++) {
+        std::string option = argv[arg];
+        if (option == "--script" && arg + 1 < argc) {
+            script = argv[++arg];
+            batch = true;
+        } else if (option == "--serve" && arg + 1 < argc) {
+            socketPath = argv[++arg];
+        } else if (option == "--stdin-batch") {
+            batch = true;
+        } else if (option == "--stop-on-error") {
+            stopOnError = true;
+        }
+    }
+    if (batch) {
+        App::useBatchOutput();
+    } else if (socketPath.empty()) {
+        App::showStart();
+    }
+    for (int arg = 1; arg < argc; arg++) {
+        std::string option = argv[arg];
+        try {
+            if (option == "--dedup") {
+                app.useBlobStore();
+            } else if (option == "--script" || option == "--serve") {
+                arg++;
+            } else if (option != "--stdin-batch" && option != "--stop-on-error") {
+                app.persist( option );
+            }
+        } catch (Exception& ex) {
+            App::showError( ex );
+            if (batch || !socketPath.empty()) { return 1; }
+        }
+    }
+    if (batch) {
+        try {
+            auto summary = script.empty() ? app.runBatch( std::cin, stopOnError )
+                                          : app.runScript( script, stopOnError );
+            App::showSummary( summary );
+            return summary.errors ? 1 : 0;
+        } catch (std::exception& ex) { // an unreadable script
+            App::showError( ex );
+            return 1;
+        }
+    }
+    if (!socketPath.empty()) {
+        try {
+            Server server( app, socketPath );
+            serving = &server;
+            std::signal( SIGINT, []( int ) { serving->stop(); } );
+            std::signal( SIGTERM, []( int ) { serving->stop(); } );
+            std::cerr << "Serving on " << socketPath << "\n";
+            server.run();
+            serving = nullptr;
+            return 0;
+        } catch (Exception& ex) {
+            App::showError( ex );
+            return 1;
+        }
+    }
     while (true) {
         app.showCurrent();
         try {
-            app.execute( App::awaitInput() );
+            auto input = App::awaitInput();
+            if (input.empty() && !std::cin) { break; } // end of input
+            app.execute( input );
         } catch (ExitSignal& sig) {
             break;
-        } catch (Exception& ex) {
+        } catch (std::exception& ex) {
             App::showError( ex );
             continue;
         }
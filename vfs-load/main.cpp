@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "VFSClient.hpp"
+
+// load generator of a vfs-app started with --serve:
+//   vfs-load <socket> [--clients N] [--requests M] [--depth D]
+// every client works in a directory of its own and keeps D requests in flight, cycling through
+// touch, ls, cd and cat. prints the request rate and the latency of a batch of D requests
+
+struct ClientResult
+{
+    size_t requests = 0;
+    size_t errors = 0;
+    std::vector<double> latencies; // of every batch, in microseconds
+    std::string failure;           // why the client stopped early
+};
+
+static void runClient( const std::string& socketPath, const size_t id, const size_t requests
+                     , const size_t depth, ClientResult& result ) {
+    try {
+        VFSClient client( socketPath );
+        auto home = std::format( "/load-{}-c{}", ::getpid(), id ); // runs against one server do not collide
+        if (!client.call( "mkdir " + home ).ok) {
+            throw Exception( std::format( "Error. Unable to create {}.", home ));
+        }
+
+        for (size_t sent = 0; sent < requests;) {
+            auto start = std::chrono::steady_clock::now();
+            auto batch = std::min( depth, requests - sent );
+            for (size_t i = 0; i < batch; i++, sent++) {
+                switch (sent % 4) {
+                    case 0: client.send( std::format( "touch {}/f{}.txt", home, sent )); break;
+                    case 1: client.send( std::format( "ls {} --limit 16", home )); break;
+                    case 2: client.send( std::format( "cd {}", home )); break;
+                    default: client.send( std::format( "cat f{}.txt", sent - 3 )); break;
+                }
+            }
+            for (size_t i = 0; i < batch; i++) {
+                if (!client.receive().ok) { result.errors++; }
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            result.latencies.push_back( std::chrono::duration<double,std::micro>(elapsed).count() );
+            result.requests += batch;
+        }
+    } catch (Exception& ex) {
+        result.failure = ex.what();
+    }
+}
+
+int main( int argc, char** argv ) {
+    if (argc < 2) {
+        std::cerr << "usage: vfs-load <socket> [--clients N] [--requests M] [--depth D]\n";
+        return 2;
+    }
+    std::string socketPath = argv[1];
+    size_t clients = 4, requests = 100'000, depth = 32;
+    for (int arg = 2; arg + 1 < argc; arg += 2) {
+        std::string option = argv[arg];
+        size_t value = std::strtoull( argv[arg + 1], nullptr, 10 );
+        if (option == "--clients") {
+            clients = std::max<size_t>( value, 1 );
+        } else if (option == "--requests") {
+            requests = value;
+        } else if (option == "--depth") {
+            depth = std::max<size_t>( value, 1 );
+        }
+    }
+
+    std::vector<ClientResult> results( clients );
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t id = 0; id < clients; id++) {
+        threads.emplace_back( runClient, socketPath, id, requests, depth, std::ref( results[id] ));
+    }
+    for (auto& thread : threads) { thread.join(); }
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    size_t total = 0, errors = 0;
+    std::vector<double> latencies;
+    for (auto& result : results) {
+        total += result.requests;
+        errors += result.errors;
+        latencies.insert( latencies.end(), result.latencies.begin(), result.latencies.end() );
+        if (!result.failure.empty()) { std::cerr << result.failure << "\n"; }
+    }
+    std::sort( latencies.begin(), latencies.end() );
+    auto percentile = [&latencies]( const double p ) {
+        return latencies.empty() ? 0.0 : latencies[ static_cast<size_t>( p * (latencies.size() - 1) ) ];
+    };
+
+    std::cout << std::format( "{} clients, depth {}: {} requests in {:.3f} s, {:.0f} req/s, {} errors\n"
+                            , clients, depth, total, seconds, total / seconds, errors );
+    std::cout << std::format( "batch latency: p50 {:.1f} us, p99 {:.1f} us, max {:.1f} us\n"
+                            , percentile(0.5), percentile(0.99), percentile(1.0) );
+    return errors != 0 || total != clients * requests;
+}